@@ -0,0 +1,65 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "bench.h"
+
+
+// every allocation in the benchmark executable goes through here so the
+// harness can report allocations per operation
+
+std::atomic<std::size_t> allocation_count{0};
+
+
+std::size_t
+AllocationCount()
+{
+    return allocation_count.load(std::memory_order_relaxed);
+}
+
+
+void*
+operator new(std::size_t size)
+{
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size == 0 ? 1 : size))
+    {
+        return memory;
+    }
+    throw std::bad_alloc{};
+}
+
+
+void*
+operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+
+void
+operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+
+void
+operator delete[](void* memory) noexcept
+{
+    std::free(memory);
+}
+
+
+void
+operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+
+void
+operator delete[](void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
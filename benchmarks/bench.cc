@@ -0,0 +1,308 @@
+#include "bench.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <numeric>
+
+#include <fmt/core.h>
+
+#include <fcntl.h>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+
+// the iterations are doubled until a run takes at least this long, these
+// runs also warm up the caches and the branch predictors, the measured
+// repetitions then use the same number of iterations
+constexpr auto MIN_DURATION = std::chrono::milliseconds{100};
+
+constexpr std::size_t DEFAULT_REPETITIONS = 5;
+
+
+void
+Benchmarks::Add(
+        const std::string& name,
+        BenchFunction function,
+        std::size_t bytes_per_iteration)
+{
+    benchmarks.emplace_back(
+            Benchmark{name, std::move(function), bytes_per_iteration});
+}
+
+
+int
+OpenNullDevice()
+{
+#if defined(_WIN32)
+    return _open(NULL_DEVICE, _O_WRONLY | _O_BINARY);
+#else
+    return open(NULL_DEVICE, O_WRONLY);
+#endif
+}
+
+
+void
+CloseNullDevice(int fd)
+{
+#if defined(_WIN32)
+    _close(fd);
+#else
+    close(fd);
+#endif
+}
+
+
+struct BenchOptions
+{
+    std::vector<std::string> filters;
+    std::size_t repetitions = DEFAULT_REPETITIONS;
+
+    // empty if no json should be written
+    std::string json_path;
+};
+
+
+// the summary of all repetitions of one benchmark
+struct BenchResult
+{
+    std::string name;
+    std::size_t iterations;
+    std::size_t repetitions;
+
+    // nanoseconds per operation
+    double min;
+    double median;
+    double mean;
+    double stddev;
+
+    double allocations;
+
+    // 0 if the benchmark has no size
+    double megabytes_per_second;
+};
+
+
+bool
+IsSelected(const Benchmark& benchmark, const std::vector<std::string>& filters)
+{
+    if (filters.empty())
+    {
+        return true;
+    }
+    for (const auto& filter: filters)
+    {
+        if (benchmark.name.find(filter) != std::string::npos)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+using Clock = std::chrono::steady_clock;
+
+
+double
+TimeRun(const Benchmark& benchmark, std::size_t iterations)
+{
+    const auto start = Clock::now();
+    benchmark.function(iterations);
+    const auto duration = Clock::now() - start;
+    return std::chrono::duration<double, std::nano>{duration}.count();
+}
+
+
+BenchResult
+RunBenchmark(const Benchmark& benchmark, std::size_t repetitions)
+{
+    // benchmarks with a large setup make it on the first run, so it isn't
+    // part of the calibration
+    benchmark.function(1);
+
+    std::size_t iterations = 1;
+    while (TimeRun(benchmark, iterations) < std::chrono::duration<double, std::nano>{MIN_DURATION}.count())
+    {
+        iterations *= 2;
+    }
+
+    const auto allocations = AllocationCount();
+    std::vector<double> times;
+    for (std::size_t repetition = 0; repetition < repetitions; repetition += 1)
+    {
+        times.emplace_back(TimeRun(benchmark, iterations) / static_cast<double>(iterations));
+    }
+    const auto allocated = AllocationCount() - allocations;
+    const auto operations = static_cast<double>(iterations * repetitions);
+
+    std::sort(times.begin(), times.end());
+    const auto count = static_cast<double>(times.size());
+    const auto middle = times.size() / 2;
+    const auto median = times.size() % 2 == 1 ? times[middle] : (times[middle - 1] + times[middle]) / 2;
+    const auto mean = std::accumulate(times.begin(), times.end(), 0.0) / count;
+    double variance = 0;
+    for (const auto time: times)
+    {
+        variance += (time - mean) * (time - mean);
+    }
+    const auto stddev = times.size() > 1 ? std::sqrt(variance / (count - 1)) : 0.0;
+
+    const auto bytes = static_cast<double>(benchmark.bytes_per_iteration);
+    return BenchResult{
+            benchmark.name,
+            iterations,
+            repetitions,
+            times.front(),
+            median,
+            mean,
+            stddev,
+            static_cast<double>(allocated) / operations,
+            bytes / median * 1e9 / (1024.0 * 1024.0)};
+}
+
+
+void
+PrintResult(const BenchResult& result)
+{
+    fmt::print(
+            "{:<40} {:>14.2f} ns/op {:>6.1f}% {:>14.2f} min {:>10.2f} allocs/op {:>12} iterations",
+            result.name,
+            result.median,
+            result.median > 0 ? result.stddev / result.median * 100 : 0.0,
+            result.min,
+            result.allocations,
+            result.iterations);
+    if (result.megabytes_per_second > 0)
+    {
+        fmt::print(" {:>10.1f} MB/s", result.megabytes_per_second);
+    }
+    fmt::print("\n");
+    std::fflush(stdout);
+}
+
+
+std::string
+JsonString(const std::string& str)
+{
+    std::string escaped = "\"";
+    for (const char c: str)
+    {
+        if (c == '"' || c == '\\')
+        {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    escaped += '"';
+    return escaped;
+}
+
+
+// one object per benchmark, the times are nanoseconds per operation
+bool
+WriteJson(const std::string& path, const std::vector<BenchResult>& results)
+{
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    fmt::print(file, "{{\n  \"benchmarks\": [");
+    bool first = true;
+    for (const auto& result: results)
+    {
+        fmt::print(file, "{}\n    {{", first ? "" : ",");
+        first = false;
+        fmt::print(file, "\"name\": {}, ", JsonString(result.name));
+        fmt::print(file, "\"iterations\": {}, ", result.iterations);
+        fmt::print(file, "\"repetitions\": {}, ", result.repetitions);
+        fmt::print(file, "\"min_ns\": {}, ", result.min);
+        fmt::print(file, "\"median_ns\": {}, ", result.median);
+        fmt::print(file, "\"mean_ns\": {}, ", result.mean);
+        fmt::print(file, "\"stddev_ns\": {}, ", result.stddev);
+        fmt::print(file, "\"allocations\": {}, ", result.allocations);
+        fmt::print(file, "\"mb_per_second\": {}}}", result.megabytes_per_second);
+    }
+    fmt::print(file, "\n  ]\n}}\n");
+
+    return std::fclose(file) == 0;
+}
+
+
+// false if the arguments are invalid
+bool
+ParseBenchOptions(const std::vector<std::string>& arguments, BenchOptions* options)
+{
+    for (std::size_t index = 0; index < arguments.size(); index += 1)
+    {
+        const auto& arg = arguments[index];
+        const auto* value = index + 1 < arguments.size() ? &arguments[index + 1] : nullptr;
+        if (arg == "--repetitions")
+        {
+            if (value == nullptr)
+            {
+                return false;
+            }
+            const auto* end = value->data() + value->size();
+            const auto [ptr, ec] = std::from_chars(value->data(), end, options->repetitions);
+            if (ec != std::errc{} || ptr != end || options->repetitions == 0)
+            {
+                return false;
+            }
+            index += 1;
+        }
+        else if (arg == "--json")
+        {
+            if (value == nullptr)
+            {
+                return false;
+            }
+            options->json_path = *value;
+            index += 1;
+        }
+        else
+        {
+            options->filters.emplace_back(arg);
+        }
+    }
+    return true;
+}
+
+
+int
+RunBenchmarks(
+        const Benchmarks& benchmarks,
+        const std::vector<std::string>& arguments)
+{
+    auto options = BenchOptions{};
+    if (!ParseBenchOptions(arguments, &options))
+    {
+        fmt::print(stderr, "usage: bbcalc_bench [--repetitions N] [--json file] [filter...]\n");
+        return 1;
+    }
+
+    std::vector<BenchResult> results;
+    for (const auto& benchmark: benchmarks.benchmarks)
+    {
+        if (IsSelected(benchmark, options.filters))
+        {
+            results.emplace_back(RunBenchmark(benchmark, options.repetitions));
+            PrintResult(results.back());
+        }
+    }
+
+    if (!options.json_path.empty() && !WriteJson(options.json_path, results))
+    {
+        fmt::print(stderr, "Unable to write {}\n", options.json_path);
+        return 1;
+    }
+    return 0;
+}
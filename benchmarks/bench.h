@@ -0,0 +1,83 @@
+#ifndef BENCH_BENCH_H
+#define BENCH_BENCH_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+
+// runs the code under test the given number of times
+using BenchFunction = std::function<void(std::size_t iterations)>;
+
+
+struct Benchmark
+{
+    std::string name;
+    BenchFunction function;
+
+    // if set the throughput is reported as well
+    std::size_t bytes_per_iteration;
+};
+
+
+struct Benchmarks
+{
+    std::vector<Benchmark> benchmarks;
+
+    void
+    Add(const std::string& name,
+        BenchFunction function,
+        std::size_t bytes_per_iteration = 0);
+};
+
+
+// each benchmark is warmed up and then timed a number of repetitions, the
+// median is printed together with the spread between the repetitions
+//
+// arguments are substrings, only benchmarks that contain one of them are
+// run, --repetitions N changes the number of repetitions and --json file
+// writes all results to a file so builds can be compared
+int
+RunBenchmarks(
+        const Benchmarks& benchmarks,
+        const std::vector<std::string>& arguments);
+
+
+// discards what is written to it, so only the formatting and the writes
+// are measured
+#if defined(_WIN32)
+constexpr const char* NULL_DEVICE = "NUL";
+#else
+constexpr const char* NULL_DEVICE = "/dev/null";
+#endif
+
+
+// a file descriptor for the null device, -1 if it can't be opened
+int
+OpenNullDevice();
+
+void
+CloseNullDevice(int fd);
+
+
+// the number of calls to operator new since the program started
+std::size_t
+AllocationCount();
+
+
+// prevents the compiler from removing the calculation of a unused value
+template <typename T>
+void
+DoNotOptimize(const T& value)
+{
+#if defined(__GNUC__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+
+#endif  // BENCH_BENCH_H
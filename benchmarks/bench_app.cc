@@ -0,0 +1,62 @@
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "bench.h"
+
+#include "calc/calc.h"
+
+
+// throws the lines away so only the calculator itself is measured
+struct NullOutput : public Output
+{
+    void
+    PrintInfo(std::string_view str) override
+    {
+        DoNotOptimize(str);
+    }
+
+    void
+    PrintError(std::string_view str) override
+    {
+        DoNotOptimize(str);
+    }
+};
+
+
+std::string
+GenerateChain(std::size_t terms)
+{
+    std::string source = "0xff";
+    for (std::size_t i = 1; i < terms; i += 1)
+    {
+        source += i % 2 == 0 ? " & " : " | ";
+        source += std::to_string(i);
+    }
+    return source;
+}
+
+
+// the whole commandline path, from the arguments to the printed result
+void
+AddApp(Benchmarks* benchmarks, const std::string& name, const std::vector<std::string>& arguments)
+{
+    benchmarks->Add(name, [arguments](std::size_t iterations) {
+        NullOutput output;
+        for (std::size_t i = 0; i < iterations; i += 1)
+        {
+            DoNotOptimize(RunCalcApp("bbcalc", arguments, &output));
+        }
+    });
+}
+
+
+void
+AddAppBenchmarks(Benchmarks* benchmarks)
+{
+    AddApp(benchmarks, "app/short", {"0x42 | 7"});
+    AddApp(benchmarks, "app/chain-1000", {GenerateChain(1000)});
+    AddApp(benchmarks, "app/chain-1000/no-opt", {"--no-opt", GenerateChain(1000)});
+    AddApp(benchmarks, "app/width-512", {"--width", "512", "~0 >> 3 ^ 0xdeadbeef << 400"});
+    AddApp(benchmarks, "app/truth-table", {"--truth-table", "a & b | c ^ d & ~e"});
+}
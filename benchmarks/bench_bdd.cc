@@ -0,0 +1,120 @@
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <fmt/core.h>
+
+#include "bench.h"
+
+#include "calc/arena.h"
+#include "calc/bdd.h"
+#include "calc/errorhandler.h"
+#include "calc/lexer.h"
+#include "calc/parser.h"
+
+
+// the tree and the arena that owns it
+struct ParsedTree
+{
+    std::shared_ptr<AstArena> arena = std::make_shared<AstArena>();
+    const Node<std::uint64_t>* root = nullptr;
+};
+
+
+ParsedTree
+ParseTree(const std::string& source)
+{
+    ParsedTree tree;
+    ErrorHandler errors;
+    tree.root = RunParser(RunLexer<std::uint64_t>(source, &errors), &errors, tree.arena.get());
+    return tree;
+}
+
+
+// a0 != b0 or a1 != b1 ..., small when the pairs are next to each other and
+// exponential when all a are above all b
+std::string
+MakeChain(int pairs)
+{
+    std::string source;
+    for (int i = 0; i < pairs; i += 1)
+    {
+        source += fmt::format("{}a{} ^ b{}", i == 0 ? "" : " | ", i, i);
+    }
+    return source;
+}
+
+
+// the same as the chain, negated twice
+std::string
+MakeNegatedChain(int pairs)
+{
+    std::string source = "~(";
+    for (int i = 0; i < pairs; i += 1)
+    {
+        source += fmt::format("{}~(a{} ^ b{})", i == 0 ? "" : " & ", i, i);
+    }
+    return source + ")";
+}
+
+
+void
+AddChain(Benchmarks* benchmarks, int pairs)
+{
+    const auto chain = ParseTree(MakeChain(pairs));
+    const auto negated = ParseTree(MakeNegatedChain(pairs));
+
+    // the variables are added in the best order up front
+    benchmarks->Add(fmt::format("bdd/chain-{}/interleaved", pairs), [chain, pairs](std::size_t iterations) {
+        for (std::size_t i = 0; i < iterations; i += 1)
+        {
+            BddManager manager;
+            for (int pair = 0; pair < pairs; pair += 1)
+            {
+                DoNotOptimize(manager.Variable(fmt::format("a{}", pair)));
+                DoNotOptimize(manager.Variable(fmt::format("b{}", pair)));
+            }
+            DoNotOptimize(manager.NodeCount(manager.FromTree(*chain.root)));
+        }
+    });
+
+    benchmarks->Add(fmt::format("bdd/equiv-{}", pairs), [chain, negated](std::size_t iterations) {
+        for (std::size_t i = 0; i < iterations; i += 1)
+        {
+            BddManager manager;
+            manager.SetAutoReorder(true);
+            const auto lhs = manager.FromTree(*chain.root);
+            DoNotOptimize(lhs == manager.FromTree(*negated.root));
+        }
+    });
+}
+
+
+// all a above all b and every b added below the others, only auto
+// reordering keeps the diagrams from blowing up
+void
+AddReorder(Benchmarks* benchmarks, int pairs)
+{
+    const auto chain = ParseTree(MakeChain(pairs));
+    benchmarks->Add(fmt::format("bdd/chain-{}/reorder", pairs), [chain, pairs](std::size_t iterations) {
+        for (std::size_t i = 0; i < iterations; i += 1)
+        {
+            BddManager manager;
+            manager.SetAutoReorder(true);
+            for (int pair = 0; pair < pairs; pair += 1)
+            {
+                DoNotOptimize(manager.Variable(fmt::format("a{}", pair)));
+            }
+            DoNotOptimize(manager.NodeCount(manager.FromTree(*chain.root)));
+        }
+    });
+}
+
+
+void
+AddBddBenchmarks(Benchmarks* benchmarks)
+{
+    AddChain(benchmarks, 100);
+    AddChain(benchmarks, 300);
+    AddReorder(benchmarks, 100);
+}
@@ -0,0 +1,77 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+
+#include <fmt/format.h>
+
+#include "calc/binary.h"
+#include "calc/bits.h"
+#include "calc/value.h"
+
+
+void
+AddFormat(Benchmarks* benchmarks, const std::string& name, std::uint64_t value)
+{
+    benchmarks->Add(name, [value](std::size_t iterations) {
+        BinaryBuffer buffer;
+        auto n = value;
+        for (std::size_t i = 0; i < iterations; i += 1)
+        {
+            DoNotOptimize(n);
+            DoNotOptimize(FormatBinary(n, &buffer));
+        }
+    });
+}
+
+
+// formats a batch of wide values the way the results are printed
+template <void (*Append)(fmt::memory_buffer*, const Bits<512>&)>
+void
+AddFormatWide(Benchmarks* benchmarks, const std::string& name)
+{
+    constexpr std::size_t COUNT = 64;
+    std::vector<Bits<512>> values;
+    auto value = ~Bits<512>{};
+    for (std::size_t i = 0; i < COUNT; i += 1)
+    {
+        values.emplace_back(value);
+        value >>= 7;
+    }
+
+    benchmarks->Add(name, [values](std::size_t iterations) {
+        fmt::memory_buffer out;
+        for (std::size_t i = 0; i < iterations; i += 1)
+        {
+            for (const auto& v: values)
+            {
+                Append(&out, v);
+            }
+            DoNotOptimize(out.data());
+            out.clear();
+        }
+    });
+}
+
+
+void
+AddBinaryBenchmarks(Benchmarks* benchmarks)
+{
+    AddFormat(benchmarks, "binary/small", 0b1011);
+    AddFormat(benchmarks, "binary/32", 0x7eadbeef);
+    AddFormat(benchmarks, "binary/64", 0xfedcba9876543210);
+
+    benchmarks->Add("binary/to-string", [](std::size_t iterations) {
+        int n = 0x7eadbeef;
+        for (std::size_t i = 0; i < iterations; i += 1)
+        {
+            DoNotOptimize(n);
+            DoNotOptimize(ToBinaryString(n));
+        }
+    });
+
+    AddFormatWide<AppendDecimal<512>>(benchmarks, "binary/bulk-512/decimal");
+    AddFormatWide<AppendHex<512>>(benchmarks, "binary/bulk-512/hex");
+    AddFormatWide<AppendBinary<512>>(benchmarks, "binary/bulk-512/binary");
+}
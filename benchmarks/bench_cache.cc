@@ -0,0 +1,47 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+
+#include "calc/arena.h"
+#include "calc/compiler.h"
+#include "calc/errorhandler.h"
+#include "calc/lexer.h"
+#include "calc/optimizer.h"
+#include "calc/parser.h"
+#include "calc/programcache.h"
+
+
+constexpr const char* CACHED_SOURCE = "(x & 0xff00 | y & 0x00ff) ^ ~(z << 4) | x & y & 0x0f0f";
+
+
+void
+AddCacheBenchmarks(Benchmarks* benchmarks)
+{
+    // what every hit saves, the same steps as a evaluator that reuses its memory
+    benchmarks->Add("cache/compile", [](std::size_t iterations) {
+        ErrorHandler errors;
+        AstArena arena;
+        std::vector<Token<std::uint32_t>> tokens;
+        Program<std::uint32_t> program;
+        for (std::size_t i = 0; i < iterations; i += 1)
+        {
+            arena.Reset();
+            RunLexer(CACHED_SOURCE, &errors, &tokens);
+            auto* root = RunOptimizer(RunParser(tokens, &errors, &arena), &arena);
+            CompileProgram(*root, &program);
+            DoNotOptimize(program.code.data());
+        }
+    });
+
+    benchmarks->Add("cache/hit", [](std::size_t iterations) {
+        auto cache = ProgramCache<std::uint32_t>{256};
+        ErrorHandler errors;
+        cache.Compile(CACHED_SOURCE, true, &errors);
+        for (std::size_t i = 0; i < iterations; i += 1)
+        {
+            DoNotOptimize(cache.Find(CACHED_SOURCE, true));
+        }
+    });
+}
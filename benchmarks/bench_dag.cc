@@ -0,0 +1,127 @@
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "bench.h"
+
+#include "calc/errorhandler.h"
+#include "calc/expressiondag.h"
+#include "calc/programcache.h"
+#include "calc/vm.h"
+
+
+constexpr std::size_t DAG_RULES = 5000;
+
+
+// a rule file where the rules are combinations of a few shared terms
+std::vector<std::string>
+MakeRules()
+{
+    std::vector<std::string> rules;
+    for (std::size_t rule = 0; rule < DAG_RULES; rule += 1)
+    {
+        rules.emplace_back(fmt::format(
+                "0xff00 & flags & ((x >> {}) & 0x{:x} | y & ~mask) ^ (z << {})",
+                rule % 8,
+                (rule / 8) % 64 * 0x0101,
+                rule % 3));
+    }
+    return rules;
+}
+
+
+struct DagRules
+{
+    std::vector<std::string> rules = MakeRules();
+    ExpressionDag<std::uint32_t> dag;
+
+    // the same rules compiled one by one, with the variables of each
+    // program as indices into the variables of the dag
+    std::vector<std::shared_ptr<const Program<std::uint32_t>>> programs;
+    std::vector<std::vector<std::size_t>> program_variables;
+
+    DagRules()
+    {
+        auto cache = ProgramCache<std::uint32_t>{0};
+        ErrorHandler errors;
+        for (const auto& rule: rules)
+        {
+            dag.Add(rule, &errors);
+            programs.emplace_back(cache.Compile(rule, true, &errors));
+        }
+
+        const auto& names = dag.Variables();
+        for (const auto& program: programs)
+        {
+            std::vector<std::size_t> indices;
+            for (const auto& name: program->variables)
+            {
+                indices.emplace_back(static_cast<std::size_t>(
+                        std::find(names.begin(), names.end(), name) - names.begin()));
+            }
+            program_variables.emplace_back(indices);
+        }
+    }
+};
+
+
+// every iteration evaluates all rules for one input
+void
+AddDagBenchmarks(Benchmarks* benchmarks)
+{
+    const auto rules = std::make_shared<DagRules>();
+
+    benchmarks->Add("dag/add", [rules](std::size_t iterations) {
+        for (std::size_t i = 0; i < iterations; i += 1)
+        {
+            auto dag = ExpressionDag<std::uint32_t>{};
+            ErrorHandler errors;
+            for (const auto& rule: rules->rules)
+            {
+                DoNotOptimize(dag.Add(rule, &errors));
+            }
+        }
+    });
+
+    benchmarks->Add("dag/separate", [rules](std::size_t iterations) {
+        std::vector<std::uint32_t> variables(rules->dag.Variables().size());
+        std::vector<std::uint32_t> program_values;
+        std::vector<std::uint32_t> results(rules->programs.size());
+        for (std::size_t i = 0; i < iterations; i += 1)
+        {
+            for (std::size_t v = 0; v < variables.size(); v += 1)
+            {
+                variables[v] = static_cast<std::uint32_t>(i * 2654435761U + v);
+            }
+            for (std::size_t rule = 0; rule < rules->programs.size(); rule += 1)
+            {
+                program_values.clear();
+                for (const auto index: rules->program_variables[rule])
+                {
+                    program_values.emplace_back(variables[index]);
+                }
+                results[rule] = RunProgram(*rules->programs[rule], program_values.data());
+            }
+            DoNotOptimize(results.data());
+        }
+    });
+
+    benchmarks->Add("dag/shared", [rules](std::size_t iterations) {
+        std::vector<std::uint32_t> variables(rules->dag.Variables().size());
+        std::vector<std::uint32_t> values;
+        std::vector<std::uint32_t> results;
+        for (std::size_t i = 0; i < iterations; i += 1)
+        {
+            for (std::size_t v = 0; v < variables.size(); v += 1)
+            {
+                variables[v] = static_cast<std::uint32_t>(i * 2654435761U + v);
+            }
+            rules->dag.Evaluate(variables, &values, &results);
+            DoNotOptimize(results.data());
+        }
+    });
+}
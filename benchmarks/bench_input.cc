@@ -0,0 +1,97 @@
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "bench.h"
+
+#include "calc/linereader.h"
+
+
+constexpr int INPUT_LINES = 2000000;
+
+
+// a generated expression file that is removed when the last benchmark
+// that uses it is gone
+struct InputFile
+{
+    std::string path;
+    std::size_t size = 0;
+
+    InputFile()
+        : path((std::filesystem::temp_directory_path() / "bbcalc_bench_input.txt").string())
+    {
+        std::ofstream file{path};
+        for (int line = 0; line < INPUT_LINES; line += 1)
+        {
+            const auto source = std::to_string(line) + " & 0xff00 | x ^ 0b1011";
+            file << source << "\n";
+            size += source.size() + 1;
+        }
+    }
+
+    ~InputFile()
+    {
+        std::remove(path.c_str());
+    }
+
+    InputFile(const InputFile&) = delete;
+    InputFile(InputFile&&) = delete;
+    void
+    operator=(const InputFile&) = delete;
+    void
+    operator=(InputFile&&) = delete;
+};
+
+
+void
+AddLineReader(Benchmarks* benchmarks, const std::string& name, std::shared_ptr<InputFile> file, bool allow_map)
+{
+    benchmarks->Add(
+            name,
+            [file, allow_map](std::size_t iterations) {
+                for (std::size_t i = 0; i < iterations; i += 1)
+                {
+                    std::FILE* f = std::fopen(file->path.c_str(), "rb");
+                    {
+                        auto reader = LineReader{f, allow_map};
+                        std::string_view line;
+                        while (reader.Next(&line))
+                        {
+                            DoNotOptimize(line);
+                            reader.Release();
+                        }
+                    }
+                    std::fclose(f);
+                }
+            },
+            file->size);
+}
+
+
+// every line of the file, without evaluating them
+void
+AddInputBenchmarks(Benchmarks* benchmarks)
+{
+    const auto file = std::make_shared<InputFile>();
+    AddLineReader(benchmarks, "input/mmap", file, true);
+    AddLineReader(benchmarks, "input/read", file, false);
+
+    // a string per line, how a stream on top of iostream would read
+    benchmarks->Add(
+            "input/iostream",
+            [file](std::size_t iterations) {
+                for (std::size_t i = 0; i < iterations; i += 1)
+                {
+                    std::ifstream stream{file->path};
+                    std::string line;
+                    while (std::getline(stream, line))
+                    {
+                        DoNotOptimize(line);
+                    }
+                }
+            },
+            file->size);
+}
@@ -0,0 +1,62 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+
+#include "calc/bits.h"
+#include "calc/errorhandler.h"
+#include "calc/lexer.h"
+
+
+constexpr std::size_t LEXER_INPUT_SIZE = 4 * 1024 * 1024;
+
+
+// repeat the terms with alternating operators until the source is large
+std::string
+GenerateSource(const std::vector<std::string>& terms)
+{
+    std::string source = terms[0];
+    std::size_t index = 0;
+    while (source.size() < LEXER_INPUT_SIZE)
+    {
+        source += index % 2 == 0 ? " & " : " | ";
+        source += terms[index % terms.size()];
+        index += 1;
+    }
+    return source;
+}
+
+
+template <typename V>
+void
+AddLex(Benchmarks* benchmarks, const std::string& name, const std::string& source)
+{
+    benchmarks->Add(
+            name,
+            [source](std::size_t iterations) {
+                for (std::size_t i = 0; i < iterations; i += 1)
+                {
+                    ErrorHandler errors;
+                    DoNotOptimize(RunLexer<V>(source, &errors));
+                }
+            },
+            source.size());
+}
+
+
+void
+AddLexerBenchmarks(Benchmarks* benchmarks)
+{
+    AddLex<std::uint32_t>(benchmarks, "lex/decimal", GenerateSource({"1", "42", "1234567", "99"}));
+    AddLex<std::uint32_t>(benchmarks, "lex/hex", GenerateSource({"0xff", "0x7eadbeef", "0x7fff0000"}));
+    AddLex<std::uint32_t>(benchmarks, "lex/binary", GenerateSource({"0b1", "0b1010101010101010", "0b110"}));
+    AddLex<std::uint32_t>(benchmarks, "lex/variables", GenerateSource({"x", "flags", "mask_2", "y"}));
+    AddLex<std::uint32_t>(benchmarks, "lex/mixed", GenerateSource({"x", "0xff00", "12", "0b1011", "flags"}));
+
+    // literals that fill the widest value type
+    const auto huge_hex = "0x" + std::string(128, 'f');
+    const auto huge_binary = "0b" + std::string(512, '1');
+    AddLex<Bits<512>>(benchmarks, "lex/huge-hex", GenerateSource({huge_hex, "0x1", huge_hex}));
+    AddLex<Bits<512>>(benchmarks, "lex/huge-binary", GenerateSource({huge_binary, "0b10", huge_binary}));
+}
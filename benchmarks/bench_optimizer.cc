@@ -0,0 +1,78 @@
+#include <string>
+#include <vector>
+
+#include "bench.h"
+
+#include "calc/compiledexpr.h"
+#include "calc/errorhandler.h"
+#include "calc/lexer.h"
+#include "calc/optimizer.h"
+#include "calc/parser.h"
+
+
+// a long chain with the redundancy machine generated rules tend to have
+std::string
+RedundantChain(int terms)
+{
+    const std::vector<std::string> atoms{
+            "x", "0xffff", "y", "0", "x", "0xff00", "z", "y", "0x7fffffff"};
+    std::string source = "x";
+    for (int i = 0; i < terms; i += 1)
+    {
+        source += i % 3 == 0 ? " & " : " | ";
+        source += atoms[static_cast<std::size_t>(i) % atoms.size()];
+    }
+    return source;
+}
+
+
+void
+AddEvaluation(
+        Benchmarks* benchmarks,
+        const std::string& name,
+        const std::string& source,
+        bool optimize)
+{
+    ErrorHandler errors;
+    AstArena arena;
+    auto* root = RunParser(RunLexer<std::uint64_t>(source, &errors), &errors, &arena);
+    if (optimize)
+    {
+        root = RunOptimizer(root, &arena);
+    }
+    const auto expr = CompiledExpr::FromNode(*root);
+
+    benchmarks->Add(name, [expr](std::size_t iterations) {
+        auto variables = std::vector<std::uint64_t>(expr.Variables().size());
+        for (std::size_t i = 0; i < iterations; i += 1)
+        {
+            for (auto& v: variables)
+            {
+                v = i;
+            }
+            DoNotOptimize(expr.Eval(variables));
+        }
+    });
+}
+
+
+void
+AddOptimizerBenchmarks(Benchmarks* benchmarks)
+{
+    const auto source = RedundantChain(1000);
+
+    AddEvaluation(benchmarks, "eval/chain-1000/no-opt", source, false);
+    AddEvaluation(benchmarks, "eval/chain-1000/opt", source, true);
+
+    benchmarks->Add("optimize/chain-1000", [source](std::size_t iterations) {
+        ErrorHandler errors;
+        AstArena source_arena;
+        auto* root = RunParser(RunLexer<std::uint64_t>(source, &errors), &errors, &source_arena);
+        AstArena arena;
+        for (std::size_t i = 0; i < iterations; i += 1)
+        {
+            arena.Reset();
+            DoNotOptimize(RunOptimizer(root, &arena));
+        }
+    });
+}
@@ -0,0 +1,72 @@
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+
+#include <fmt/format.h>
+
+#include "bench.h"
+
+#include "calc/binary.h"
+#include "calc/binaryoutput.h"
+#include "calc/records.h"
+#include "calc/bufferedoutput.h"
+
+
+// each iteration prints one result, the three lines PrintNumber prints, to
+// the null device so only the formatting and the writes are measured
+void
+AddOutputBenchmarks(Benchmarks* benchmarks)
+{
+    // how the commandline printed before, a string per line and iostream
+    benchmarks->Add("output/iostream", [](std::size_t iterations) {
+        std::ofstream file{NULL_DEVICE};
+        for (std::size_t i = 0; i < iterations; i += 1)
+        {
+            const auto n = static_cast<int>(i);
+            file << fmt::format("dec: {}", n) << "\n";
+            file << fmt::format("hex: 0x{:x}", n) << "\n";
+            file << fmt::format("bin: {}", ToBinaryString(n)) << "\n";
+        }
+    });
+
+    benchmarks->Add("output/buffered", [](std::size_t iterations) {
+        const int fd = OpenNullDevice();
+        {
+            auto output = BufferedOutput{fd, fd};
+            fmt::memory_buffer line;
+            BinaryBuffer binary;
+            for (std::size_t i = 0; i < iterations; i += 1)
+            {
+                const auto n = static_cast<int>(i);
+                fmt::format_to(std::back_inserter(line), "dec: {}", n);
+                output.PrintInfo({line.data(), line.size()});
+                line.clear();
+                fmt::format_to(std::back_inserter(line), "hex: 0x{:x}", n);
+                output.PrintInfo({line.data(), line.size()});
+                line.clear();
+                line.append(std::string_view{"bin: "});
+                line.append(FormatBinary(n, &binary));
+                output.PrintInfo({line.data(), line.size()});
+                line.clear();
+            }
+        }
+        CloseNullDevice(fd);
+    });
+
+    // the same result as a record
+    benchmarks->Add("output/binary", [](std::size_t iterations) {
+        std::FILE* file = std::fopen(NULL_DEVICE, "wb");
+        {
+            auto text = BufferedOutput{-1, -1};
+            auto output = BinaryOutput{file, &text};
+            RecordBuffer record;
+            for (std::size_t i = 0; i < iterations; i += 1)
+            {
+                output.PrintRecords(FormatRecord(static_cast<std::uint32_t>(i), false, &record));
+            }
+        }
+        std::fclose(file);
+    });
+}
@@ -0,0 +1,78 @@
+#include <string>
+#include <vector>
+
+#include "bench.h"
+
+#include "calc/errorhandler.h"
+#include "calc/lexer.h"
+#include "calc/parser.h"
+
+
+std::string
+AndOrChain(int terms)
+{
+    std::string source = "0x1";
+    for (int i = 0; i < terms; i += 1)
+    {
+        source += i % 2 == 0 ? " & " : " | ";
+        source += i % 3 == 0 ? "x" : "0xff00";
+    }
+    return source;
+}
+
+
+// right nested so every level waits for the rest of the expression, the
+// time should grow linearly with the depth
+std::string
+NestedExpression(int depth)
+{
+    constexpr const char* OPERATORS[] = {" & ", " | ", " ^ ", " << "};
+    std::string source;
+    for (int i = 0; i < depth; i += 1)
+    {
+        source += "~(x";
+        source += OPERATORS[i % 4];
+    }
+    source += "1";
+    source += std::string(static_cast<std::size_t>(depth), ')');
+    return source;
+}
+
+
+void
+AddParse(Benchmarks* benchmarks, const std::string& name, const std::string& source)
+{
+    ErrorHandler lexer_errors;
+    const auto tokens = RunLexer<std::uint32_t>(source, &lexer_errors);
+
+    // a new arena per parse is what a one-off parse costs, a reused arena
+    // is what parsing many expressions in a row costs
+    benchmarks->Add(name + "/new-arena", [tokens](std::size_t iterations) {
+        ErrorHandler errors;
+        for (std::size_t i = 0; i < iterations; i += 1)
+        {
+            AstArena arena;
+            DoNotOptimize(RunParser(tokens, &errors, &arena));
+        }
+    });
+
+    benchmarks->Add(name + "/reused-arena", [tokens](std::size_t iterations) {
+        ErrorHandler errors;
+        AstArena arena;
+        for (std::size_t i = 0; i < iterations; i += 1)
+        {
+            arena.Reset();
+            DoNotOptimize(RunParser(tokens, &errors, &arena));
+        }
+    });
+}
+
+
+void
+AddParserBenchmarks(Benchmarks* benchmarks)
+{
+    AddParse(benchmarks, "parse/short", "0xff & 0b100");
+    AddParse(benchmarks, "parse/chain-1000", AndOrChain(1000));
+    AddParse(benchmarks, "parse/nested-1000", NestedExpression(1000));
+    AddParse(benchmarks, "parse/nested-10000", NestedExpression(10000));
+}
@@ -0,0 +1,134 @@
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "bench.h"
+
+#include "calc/compiledexpr.h"
+#include "calc/errorhandler.h"
+#include "calc/ruleindex.h"
+
+
+constexpr std::size_t RULE_QUERIES = 256;
+
+
+// flag tests, a mask of one to three bits and sometimes a xor with the
+// expected value, queried with values that have a few bits set
+struct RuleSet
+{
+    std::vector<std::string> rules;
+    std::vector<std::uint64_t> queries;
+
+    explicit RuleSet(std::size_t count)
+    {
+        std::mt19937_64 random{count};
+        const auto bits = [&random](int bit_count) {
+            std::uint64_t mask = 0;
+            for (int bit = 0; bit < bit_count; bit += 1)
+            {
+                mask |= std::uint64_t{1} << (random() % 64);
+            }
+            return mask;
+        };
+
+        for (std::size_t rule = 0; rule < count; rule += 1)
+        {
+            const auto mask = bits(1 + static_cast<int>(rule % 3));
+            rules.emplace_back(
+                    rule % 8 == 0 ? fmt::format("(x ^ {:#x}) & {:#x}", bits(2), mask)
+                                  : fmt::format("x & {:#x}", mask));
+        }
+        for (std::size_t query = 0; query < RULE_QUERIES; query += 1)
+        {
+            queries.emplace_back(bits(4));
+        }
+    }
+};
+
+
+// built on the first run so only the selected sizes are made
+template <typename T>
+const T&
+LazyMake(std::shared_ptr<T>* made, std::size_t count)
+{
+    if (*made == nullptr)
+    {
+        *made = std::make_shared<T>(count);
+    }
+    return **made;
+}
+
+
+struct IndexedRules
+{
+    RuleSet set;
+    RuleIndex index;
+
+    explicit IndexedRules(std::size_t count) : set(count)
+    {
+        ErrorHandler errors;
+        for (const auto& rule: set.rules)
+        {
+            index.Add(rule, &errors);
+        }
+    }
+};
+
+
+struct LinearRules
+{
+    RuleSet set;
+    std::vector<CompiledExpr> expressions;
+
+    explicit LinearRules(std::size_t count) : set(count)
+    {
+        ErrorHandler errors;
+        for (const auto& rule: set.rules)
+        {
+            expressions.emplace_back(CompileExpression(rule, &errors));
+        }
+    }
+};
+
+
+// every iteration finds the matching rules of one value
+void
+AddRuleBenchmarks(Benchmarks* benchmarks)
+{
+    for (const std::size_t count: {1000U, 10000U, 100000U, 1000000U})
+    {
+        auto indexed = std::make_shared<std::shared_ptr<IndexedRules>>();
+        benchmarks->Add(fmt::format("rules/index-{}", count), [indexed, count](std::size_t iterations) {
+            const auto& rules = LazyMake(indexed.get(), count);
+            RuleMatches matches;
+            for (std::size_t i = 0; i < iterations; i += 1)
+            {
+                rules.index.Match(rules.set.queries[i % RULE_QUERIES], &matches);
+                DoNotOptimize(matches.rules.data());
+            }
+        });
+
+        auto linear = std::make_shared<std::shared_ptr<LinearRules>>();
+        benchmarks->Add(fmt::format("rules/linear-{}", count), [linear, count](std::size_t iterations) {
+            const auto& rules = LazyMake(linear.get(), count);
+            std::vector<int> matches;
+            for (std::size_t i = 0; i < iterations; i += 1)
+            {
+                const auto value = rules.set.queries[i % RULE_QUERIES];
+                matches.clear();
+                for (std::size_t rule = 0; rule < rules.expressions.size(); rule += 1)
+                {
+                    if (rules.expressions[rule].Eval({&value, 1}) != 0)
+                    {
+                        matches.emplace_back(static_cast<int>(rule));
+                    }
+                }
+                DoNotOptimize(matches.data());
+            }
+        });
+    }
+}
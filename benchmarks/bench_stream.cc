@@ -0,0 +1,145 @@
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include "bench.h"
+
+#include "calc/bufferedoutput.h"
+#include "calc/calc.h"
+#include "calc/output.h"
+
+
+constexpr int STREAM_LINES = 100000;
+
+
+struct NullOutput : public Output
+{
+    void
+    PrintInfo(std::string_view str) override
+    {
+        DoNotOptimize(str);
+    }
+
+    void
+    PrintError(std::string_view str) override
+    {
+        DoNotOptimize(str);
+    }
+};
+
+
+// a generated expression file that is removed when the last benchmark
+// that uses it is gone
+struct StreamFile
+{
+    std::string path;
+    std::size_t size = 0;
+
+    StreamFile()
+        : path((std::filesystem::temp_directory_path() / "bbcalc_bench_stream.txt")
+                       .string())
+    {
+        std::ofstream file{path};
+        const std::vector<std::string> terms = {"0xff00", "12", "0b1011", "7", "0x7fff"};
+        for (int line = 0; line < STREAM_LINES; line += 1)
+        {
+            const auto index = static_cast<std::size_t>(line);
+            const auto source = fmt::format(
+                    "{} & {} | {} & 0xffff | {}",
+                    terms[index % terms.size()],
+                    line,
+                    terms[(index + 2) % terms.size()],
+                    terms[(index + 3) % terms.size()]);
+            file << source << "\n";
+            size += source.size() + 1;
+        }
+    }
+
+    ~StreamFile()
+    {
+        std::remove(path.c_str());
+    }
+
+    StreamFile(const StreamFile&) = delete;
+    StreamFile(StreamFile&&) = delete;
+    void
+    operator=(const StreamFile&) = delete;
+    void
+    operator=(StreamFile&&) = delete;
+};
+
+
+void
+AddStreamBenchmarks(Benchmarks* benchmarks)
+{
+    const auto file = std::make_shared<StreamFile>();
+    for (int jobs: {1, 2, 4, 8, 16})
+    {
+        benchmarks->Add(
+                fmt::format("stream/jobs-{}", jobs),
+                [file, jobs](std::size_t iterations) {
+                    const std::vector<std::string> arguments = {
+                            "--stream", file->path, "--jobs", std::to_string(jobs)};
+                    for (std::size_t i = 0; i < iterations; i += 1)
+                    {
+                        auto output = NullOutput{};
+                        DoNotOptimize(RunCalcApp("bench", arguments, &output));
+                    }
+                },
+                file->size);
+    }
+
+    // the overhead of collecting the stats
+    benchmarks->Add(
+            "stream/jobs-1/stats",
+            [file](std::size_t iterations) {
+                const std::vector<std::string> arguments = {"--stream", file->path, "--stats"};
+                for (std::size_t i = 0; i < iterations; i += 1)
+                {
+                    auto output = NullOutput{};
+                    DoNotOptimize(RunCalcApp("bench", arguments, &output));
+                }
+            },
+            file->size);
+
+    // the results written to the null device as text and as records, so the
+    // writes are measured too
+    benchmarks->Add(
+            "stream/jobs-1/text",
+            [file](std::size_t iterations) {
+                const std::vector<std::string> arguments = {"--stream", file->path};
+                const int fd = OpenNullDevice();
+                for (std::size_t i = 0; i < iterations; i += 1)
+                {
+                    auto output = BufferedOutput{fd, fd};
+                    DoNotOptimize(RunCalcApp("bench", arguments, &output));
+                }
+                CloseNullDevice(fd);
+            },
+            file->size);
+
+    for (const auto* status: {"", "--status"})
+    {
+        benchmarks->Add(
+                fmt::format("stream/jobs-1/binary{}", status[0] == 0 ? "" : "-status"),
+                [file, status](std::size_t iterations) {
+                    std::vector<std::string> arguments = {"--stream", file->path, "--binary", NULL_DEVICE};
+                    if (status[0] != 0)
+                    {
+                        arguments.emplace_back(status);
+                    }
+                    for (std::size_t i = 0; i < iterations; i += 1)
+                    {
+                        auto output = NullOutput{};
+                        DoNotOptimize(RunCalcApp("bench", arguments, &output));
+                    }
+                },
+                file->size);
+    }
+}
@@ -0,0 +1,91 @@
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include <fmt/core.h>
+
+#include "bench.h"
+
+#include "calc/arena.h"
+#include "calc/compiler.h"
+#include "calc/errorhandler.h"
+#include "calc/lexer.h"
+#include "calc/optimizer.h"
+#include "calc/output.h"
+#include "calc/parser.h"
+#include "calc/truthtable.h"
+
+
+// keeps the lines from being optimized away without storing them
+struct CountingOutput : public Output
+{
+    std::size_t bytes = 0;
+
+    void
+    PrintInfo(std::string_view str) override
+    {
+        bytes += str.size() + 1;
+    }
+
+    void
+    PrintError(std::string_view str) override
+    {
+        bytes += str.size() + 1;
+    }
+};
+
+
+// pairs of variables that are and:ed and or:ed together
+TruthTable
+MakeTable(int variables)
+{
+    std::string source;
+    for (int i = 0; i < variables; i += 2)
+    {
+        if (i > 0)
+        {
+            source += " | ";
+        }
+        source += fmt::format("v{} & v{}", i, i + 1);
+    }
+
+    ErrorHandler errors;
+    AstArena arena;
+    auto* root = RunParser(RunLexer<std::uint64_t>(source, &errors), &errors, &arena);
+    return TruthTable{CompileProgram(*RunOptimizer(root, &arena))};
+}
+
+
+void
+AddTruthTable(Benchmarks* benchmarks, int variables)
+{
+    const auto table = MakeTable(variables);
+
+    benchmarks->Add(fmt::format("truthtable/eval-{}", variables), [table](std::size_t iterations) {
+        for (std::size_t i = 0; i < iterations; i += 1)
+        {
+            for (std::uint64_t row = 0; row < table.RowCount(); row += 64)
+            {
+                DoNotOptimize(table.EvalRows(row));
+            }
+        }
+    });
+
+    benchmarks->Add(fmt::format("truthtable/print-{}", variables), [table](std::size_t iterations) {
+        for (std::size_t i = 0; i < iterations; i += 1)
+        {
+            auto output = CountingOutput{};
+            table.Print(&output);
+            DoNotOptimize(output.bytes);
+        }
+    });
+}
+
+
+void
+AddTruthTableBenchmarks(Benchmarks* benchmarks)
+{
+    AddTruthTable(benchmarks, 8);
+    AddTruthTable(benchmarks, 20);
+    AddTruthTable(benchmarks, 24);
+}
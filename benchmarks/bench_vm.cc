@@ -0,0 +1,136 @@
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+
+#include "calc/arena.h"
+#include "calc/compiler.h"
+#include "calc/errorhandler.h"
+#include "calc/jit.h"
+#include "calc/lexer.h"
+#include "calc/lookuptable.h"
+#include "calc/parser.h"
+#include "calc/program.h"
+#include "calc/value.h"
+#include "calc/vm.h"
+
+
+constexpr const char* VM_SOURCE = "x & 0xf0 | y & 0x3c | z & x | 0xf | y & z";
+
+
+template <typename V>
+void
+AddRun(Benchmarks* benchmarks, const std::string& name)
+{
+    ErrorHandler errors;
+    AstArena arena;
+    const auto* root = RunParser(RunLexer<V>(VM_SOURCE, &errors), &errors, &arena);
+    const auto program = CompileProgram(*root);
+
+    benchmarks->Add(name, [program](std::size_t iterations) {
+        auto values = std::vector<V>{V(0x12u), V(0x56u), V(0x9au)};
+        for (std::size_t i = 0; i < iterations; i += 1)
+        {
+            DoNotOptimize(values);
+            DoNotOptimize(RunProgram(program, values));
+        }
+    });
+}
+
+
+// the same expression on every backend, the values are 64 bit since that
+// is what the jit supports
+void
+AddBackends(Benchmarks* benchmarks)
+{
+    auto errors = ErrorHandler{};
+    auto arena = std::make_shared<AstArena>();
+    const auto* root = RunParser(RunLexer<std::uint64_t>(VM_SOURCE, &errors), &errors, arena.get());
+    const auto program = CompileProgram(*root);
+    const auto values = std::vector<std::uint64_t>{0x12, 0x56, 0x9a};
+
+    benchmarks->Add("backend/tree", [arena, root, values](std::size_t iterations) {
+        auto variables = values;
+        for (std::size_t i = 0; i < iterations; i += 1)
+        {
+            DoNotOptimize(variables);
+            DoNotOptimize(root->Calculate(variables));
+        }
+    });
+
+    benchmarks->Add("backend/vm", [program, values](std::size_t iterations) {
+        auto variables = values;
+        for (std::size_t i = 0; i < iterations; i += 1)
+        {
+            DoNotOptimize(variables);
+            DoNotOptimize(RunProgram(program, variables));
+        }
+    });
+
+    const auto jit = std::make_shared<JitProgram>(program);
+    const auto jit_name = jit->IsNative() ? "backend/jit" : "backend/jit-fallback";
+    benchmarks->Add(jit_name, [jit, values](std::size_t iterations) {
+        auto variables = values;
+        for (std::size_t i = 0; i < iterations; i += 1)
+        {
+            DoNotOptimize(variables);
+            DoNotOptimize(jit->Run(variables.data()));
+        }
+    });
+}
+
+
+constexpr const char* TABLE_SOURCE = "(x ^ 0x5a) & ~(x << 3) | x >> 5 & 0x7";
+
+
+// the inputs step through the whole table so a 16 bit table doesn't stay
+// in the cache more than it would with real inputs
+template <typename V>
+void
+AddTable(Benchmarks* benchmarks, const std::string& name)
+{
+    ErrorHandler errors;
+    auto arena = std::make_shared<AstArena>();
+    const auto* root = RunParser(RunLexer<V>(TABLE_SOURCE, &errors), &errors, arena.get());
+    const auto direct = CompileProgram(*root);
+    auto tabulated = direct;
+    TabulateProgram(&tabulated);
+
+    const auto run = [](const Program<V>& program) {
+        return [program](std::size_t iterations) {
+            for (std::size_t i = 0; i < iterations; i += 1)
+            {
+                const auto value = static_cast<V>(i * 40503);
+                DoNotOptimize(RunProgram(program, &value));
+            }
+        };
+    };
+    benchmarks->Add(name + "/direct", run(direct));
+    benchmarks->Add(name + "/lookup", run(tabulated));
+
+    benchmarks->Add(name + "/fill", [arena, root, direct](std::size_t iterations) {
+        auto program = direct;
+        for (std::size_t i = 0; i < iterations; i += 1)
+        {
+            TabulateProgram(&program);
+            DoNotOptimize(program.table.data());
+        }
+    });
+}
+
+
+void
+AddVmBenchmarks(Benchmarks* benchmarks)
+{
+    AddBackends(benchmarks);
+    AddRun<std::uint8_t>(benchmarks, "vm/width-8");
+    AddRun<std::uint32_t>(benchmarks, "vm/width-32");
+    AddRun<std::uint64_t>(benchmarks, "vm/width-64");
+    AddRun<Bits<128>>(benchmarks, "vm/width-128");
+    AddRun<Bits<256>>(benchmarks, "vm/width-256");
+    AddRun<Bits<512>>(benchmarks, "vm/width-512");
+    AddTable<std::uint8_t>(benchmarks, "vm/table-8");
+    AddTable<std::uint16_t>(benchmarks, "vm/table-16");
+}
@@ -0,0 +1,233 @@
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <csignal>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <fmt/core.h>
+
+
+// the latency of one expression from a script, once with a new bbcalc
+// process for every expression and once with a running bbcalc --serve,
+// both over the socket directly and with a bbcalc --client process
+
+
+extern char** environ;
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t DEFAULT_COUNT = 500;
+
+// different expressions so the server cache is used like with a script
+constexpr std::array<const char*, 8> EXPRESSIONS = {
+        "0x42 | 7",
+        "0xff & ~0x0f ^ 0b1010",
+        "1 << 12 | 1 << 3",
+        "0xdead & 0xbeef",
+        "~0 >> 4",
+        "(0x1234 ^ 0x00ff) & 0xf0f0",
+        "0b1111 << 8 | 0b0101",
+        "42 ^ 24 | 12 & 6"};
+
+
+double
+MicrosecondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+
+void
+PrintLatencies(std::string_view name, std::vector<double> micros)
+{
+    std::sort(micros.begin(), micros.end());
+    const auto at = [&micros](std::size_t percent) { return micros[micros.size() * percent / 100]; };
+    double sum = 0;
+    for (const auto micro: micros)
+    {
+        sum += micro;
+    }
+    fmt::print(
+            "{:<16} p50 {:>10.1f} us   p99 {:>10.1f} us   mean {:>10.1f} us\n",
+            name,
+            at(50),
+            at(99),
+            sum / static_cast<double>(micros.size()));
+}
+
+
+// -1 if the process couldn't be started, the output is thrown away
+pid_t
+Spawn(const std::vector<std::string>& arguments)
+{
+    std::vector<char*> argv;
+    for (const auto& argument: arguments)
+    {
+        argv.emplace_back(const_cast<char*>(argument.c_str()));
+    }
+    argv.emplace_back(nullptr);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+    pid_t pid = -1;
+    if (posix_spawn(&pid, argv[0], &actions, nullptr, argv.data(), environ) != 0)
+    {
+        pid = -1;
+    }
+    posix_spawn_file_actions_destroy(&actions);
+    return pid;
+}
+
+
+bool
+SpawnAndWait(const std::vector<std::string>& arguments)
+{
+    const auto pid = Spawn(arguments);
+    int status = 0;
+    return pid > 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+
+// a new process for every expression, empty if one failed
+std::vector<double>
+TimeProcesses(std::vector<std::string> arguments, std::size_t count)
+{
+    std::vector<double> micros;
+    arguments.emplace_back();
+    for (std::size_t call = 0; call < count; call += 1)
+    {
+        arguments.back() = EXPRESSIONS[call % EXPRESSIONS.size()];
+        const auto start = Clock::now();
+        if (!SpawnAndWait(arguments))
+        {
+            return {};
+        }
+        micros.emplace_back(MicrosecondsSince(start));
+    }
+    return micros;
+}
+
+
+// waits for the server to start listening, -1 if it doesn't
+int
+Connect(const std::string& path)
+{
+    auto address = sockaddr_un{};
+    address.sun_family = AF_UNIX;
+    path.copy(address.sun_path, sizeof(address.sun_path) - 1);
+
+    for (int attempt = 0; attempt < 500; attempt += 1)
+    {
+        const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0)
+        {
+            return fd;
+        }
+        close(fd);
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    }
+    return -1;
+}
+
+
+// one expression at a time over one connection, a reply ends with a empty
+// line, empty if the server stopped answering
+std::vector<double>
+TimeSocket(int fd, std::size_t count)
+{
+    std::vector<double> micros;
+    std::array<char, 4096> buffer;
+    std::string reply;
+    for (std::size_t call = 0; call < count; call += 1)
+    {
+        const auto request = fmt::format("{}\n", EXPRESSIONS[call % EXPRESSIONS.size()]);
+        const auto start = Clock::now();
+        if (send(fd, request.data(), request.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(request.size()))
+        {
+            return {};
+        }
+        reply.clear();
+        while (reply.size() < 2 || reply.compare(reply.size() - 2, 2, "\n\n") != 0)
+        {
+            const auto received = read(fd, buffer.data(), buffer.size());
+            if (received <= 0)
+            {
+                return {};
+            }
+            reply.append(buffer.data(), static_cast<std::size_t>(received));
+        }
+        micros.emplace_back(MicrosecondsSince(start));
+    }
+    return micros;
+}
+
+
+int
+main(int argc, char* argv[])
+{
+    std::size_t count = DEFAULT_COUNT;
+    std::string bbcalc = BBCALC_PATH;
+    for (int index = 1; index + 1 < argc; index += 2)
+    {
+        const std::string_view option = argv[index];
+        const std::string_view value = argv[index + 1];
+        if (option == "--count")
+        {
+            const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), count);
+            if (error != std::errc{} || end != value.data() + value.size() || count == 0)
+            {
+                fmt::print(stderr, "Invalid count: {}\n", value);
+                return 1;
+            }
+        }
+        else if (option == "--bbcalc")
+        {
+            bbcalc = value;
+        }
+        else
+        {
+            fmt::print(stderr, "usage: {} [--count N] [--bbcalc path]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    const auto socket_path = fmt::format("/tmp/bbcalc-latency-{}.sock", getpid());
+    const auto server = Spawn({bbcalc, "--serve", socket_path});
+    const int fd = server > 0 ? Connect(socket_path) : -1;
+    if (fd < 0)
+    {
+        fmt::print(stderr, "Unable to start {} --serve {}\n", bbcalc, socket_path);
+        return 1;
+    }
+
+    fmt::print("{} calls of {}\n", count, bbcalc);
+    const auto process = TimeProcesses({bbcalc}, count);
+    const auto client = TimeProcesses({bbcalc, "--client", socket_path}, count);
+    const auto socket = TimeSocket(fd, count);
+    close(fd);
+    kill(server, SIGTERM);
+    waitpid(server, nullptr, 0);
+
+    if (process.empty() || client.empty() || socket.empty())
+    {
+        fmt::print(stderr, "A call failed\n");
+        return 1;
+    }
+    PrintLatencies("process", process);
+    PrintLatencies("client process", client);
+    PrintLatencies("socket", socket);
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include <string>
+#include <vector>
+
+#include "bench.h"
+
+
+void
+AddAppBenchmarks(Benchmarks* benchmarks);
+
+void
+AddBinaryBenchmarks(Benchmarks* benchmarks);
+
+void
+AddBddBenchmarks(Benchmarks* benchmarks);
+
+void
+AddCacheBenchmarks(Benchmarks* benchmarks);
+
+void
+AddDagBenchmarks(Benchmarks* benchmarks);
+
+void
+AddInputBenchmarks(Benchmarks* benchmarks);
+
+void
+AddLexerBenchmarks(Benchmarks* benchmarks);
+
+void
+AddOptimizerBenchmarks(Benchmarks* benchmarks);
+
+void
+AddOutputBenchmarks(Benchmarks* benchmarks);
+
+void
+AddParserBenchmarks(Benchmarks* benchmarks);
+
+void
+AddRuleBenchmarks(Benchmarks* benchmarks);
+
+void
+AddStreamBenchmarks(Benchmarks* benchmarks);
+
+void
+AddTruthTableBenchmarks(Benchmarks* benchmarks);
+
+void
+AddVmBenchmarks(Benchmarks* benchmarks);
+
+
+int
+main(int argc, char* argv[])
+{
+    std::vector<std::string> arguments;
+    for (int i = 1; i < argc; i += 1)
+    {
+        arguments.emplace_back(argv[i]);
+    }
+
+    auto benchmarks = Benchmarks{};
+    AddAppBenchmarks(&benchmarks);
+    AddBinaryBenchmarks(&benchmarks);
+    AddBddBenchmarks(&benchmarks);
+    AddCacheBenchmarks(&benchmarks);
+    AddDagBenchmarks(&benchmarks);
+    AddInputBenchmarks(&benchmarks);
+    AddLexerBenchmarks(&benchmarks);
+    AddOptimizerBenchmarks(&benchmarks);
+    AddOutputBenchmarks(&benchmarks);
+    AddParserBenchmarks(&benchmarks);
+    AddRuleBenchmarks(&benchmarks);
+    AddStreamBenchmarks(&benchmarks);
+    AddTruthTableBenchmarks(&benchmarks);
+    AddVmBenchmarks(&benchmarks);
+
+    return RunBenchmarks(benchmarks, arguments);
+}
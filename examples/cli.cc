@@ -1,22 +1,9 @@
-#include <iostream>
+#include <string>
+#include <vector>
 
+#include "calc/bufferedoutput.h"
 #include "calc/calc.h"
 
-struct ConsoleOutput : public Output
-{
-    void
-    PrintInfo(const std::string& str) override
-    {
-        std::cout << str << "\n";
-    }
-
-    void
-    PrintError(const std::string& str) override
-    {
-        std::cerr << str << "\n";
-    }
-};
-
 
 int
 main(int argc, char* argv[])
@@ -33,7 +20,8 @@ main(int argc, char* argv[])
         arguments.emplace_back(arg);
     }
 
-    auto console_output = ConsoleOutput{};
+    // stdout and stderr
+    auto console_output = BufferedOutput{1, 2};
 
     return RunCalcApp(argv[0], arguments, &console_output);
 }
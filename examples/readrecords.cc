@@ -0,0 +1,132 @@
+#include <charconv>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "calc/bits.h"
+#include "calc/bufferedoutput.h"
+#include "calc/records.h"
+#include "calc/value.h"
+
+
+// prints the records that bbcalc --binary wrote, one line for each record,
+// the decimal value or the error of the status
+
+
+bool
+ReadFile(std::FILE* file, std::string* data)
+{
+    std::vector<char> buffer(1024 * 1024);
+    std::size_t read = 0;
+    while ((read = std::fread(buffer.data(), 1, buffer.size(), file)) > 0)
+    {
+        data->append(buffer.data(), read);
+    }
+    return std::ferror(file) == 0;
+}
+
+
+template <typename V>
+void
+PrintRecords(std::string_view data, std::size_t width, bool has_status, Output* output)
+{
+    auto reader = RecordReader{data, width, has_status};
+    fmt::memory_buffer line;
+    Record record;
+    while (reader.Next(&record))
+    {
+        if (record.status == RECORD_OK)
+        {
+            AppendDecimal(&line, LoadLittleEndian<V>(record.value.data()));
+        }
+        else
+        {
+            fmt::format_to(std::back_inserter(line), "error: {}", RecordStatusName(record.status));
+        }
+        output->PrintInfo({line.data(), line.size()});
+        line.clear();
+    }
+
+    if (reader.RemainingBytes() > 0)
+    {
+        output->PrintError(fmt::format("{} bytes after the last record", reader.RemainingBytes()));
+    }
+}
+
+
+int
+main(int argc, char* argv[])
+{
+    std::size_t width = 32;
+    bool has_status = false;
+    std::string path = "-";
+
+    for (int i = 1; i < argc; i += 1)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--status")
+        {
+            has_status = true;
+        }
+        else if (arg == "--width" && i + 1 < argc)
+        {
+            i += 1;
+            const std::string_view str = argv[i];
+            const auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), width);
+            if (ec != std::errc{} || ptr != str.data() + str.size())
+            {
+                std::fprintf(stderr, "Invalid width: %s\n", argv[i]);
+                return -1;
+            }
+        }
+        else if (arg == "--help" || arg == "-h")
+        {
+            std::puts("bbcalc_read [--width N] [--status] [file]");
+            std::puts(" - print the records of bbcalc --binary, - or no file is stdin");
+            return 0;
+        }
+        else
+        {
+            path = arg;
+        }
+    }
+
+    std::FILE* file = path == "-" ? stdin : std::fopen(path.c_str(), "rb");
+    if (file == nullptr)
+    {
+        std::fprintf(stderr, "Unable to open %s\n", path.c_str());
+        return -1;
+    }
+    std::string data;
+    const auto read = ReadFile(file, &data);
+    if (file != stdin)
+    {
+        std::fclose(file);
+    }
+    if (!read)
+    {
+        std::fprintf(stderr, "Unable to read %s\n", path.c_str());
+        return -1;
+    }
+
+    // stdout and stderr
+    auto output = BufferedOutput{1, 2};
+
+    switch (width)
+    {
+    case 8: PrintRecords<std::uint8_t>(data, width, has_status, &output); break;
+    case 16: PrintRecords<std::uint16_t>(data, width, has_status, &output); break;
+    case 32: PrintRecords<std::uint32_t>(data, width, has_status, &output); break;
+    case 64: PrintRecords<std::uint64_t>(data, width, has_status, &output); break;
+    case 128: PrintRecords<Bits<128>>(data, width, has_status, &output); break;
+    case 256: PrintRecords<Bits<256>>(data, width, has_status, &output); break;
+    case 512: PrintRecords<Bits<512>>(data, width, has_status, &output); break;
+    default:
+        output.PrintError(fmt::format("Invalid width: {}", width));
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include "calc/arena.h"
+
+#include <algorithm>
+#include <cstring>
+
+
+// most expressions are short so the first block is small, following blocks
+// grow so long expressions need only a few allocations
+constexpr std::size_t FIRST_BLOCK_SIZE = 1024;
+constexpr std::size_t MAX_BLOCK_SIZE = 1024 * 1024;
+
+
+AstArena::AstArena() = default;
+
+AstArena::~AstArena() = default;
+
+
+std::string_view
+AstArena::MakeString(std::string_view str)
+{
+    auto* memory = static_cast<char*>(Allocate(str.size(), 1));
+    std::memcpy(memory, str.data(), str.size());
+    return {memory, str.size()};
+}
+
+
+void
+AstArena::Reset()
+{
+    current_block = 0;
+    used = 0;
+    bytes_used = 0;
+    objects_made = 0;
+}
+
+
+[[nodiscard]] std::size_t
+AstArena::BytesUsed() const
+{
+    return bytes_used;
+}
+
+
+[[nodiscard]] std::size_t
+AstArena::ObjectCount() const
+{
+    return objects_made;
+}
+
+
+void*
+AstArena::Allocate(std::size_t size, std::size_t alignment)
+{
+    while (current_block < blocks.size())
+    {
+        auto& block = blocks[current_block];
+        const auto start = (used + alignment - 1) & ~(alignment - 1);
+        if (start + size <= block.size)
+        {
+            used = start + size;
+            bytes_used += size;
+            return block.memory.get() + start;
+        }
+
+        // the rest of this block is left unused until the next reset
+        current_block += 1;
+        used = 0;
+    }
+
+    const auto last_size = blocks.empty() ? FIRST_BLOCK_SIZE / 2 : blocks.back().size;
+    const auto block_size = std::max(std::min(last_size * 2, MAX_BLOCK_SIZE), size + alignment);
+    blocks.emplace_back(Block{std::unique_ptr<char[]>(new char[block_size]), block_size});
+    return Allocate(size, alignment);
+}
@@ -0,0 +1,110 @@
+#ifndef CALC_ARENA_H
+#define CALC_ARENA_H
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "calc/span.h"
+
+template <typename V>
+struct Node;
+
+
+// owns all nodes of one or more parses, nodes are bump allocated and are
+// never destroyed one by one, all of them are freed with a single Reset
+struct AstArena
+{
+    AstArena();
+    ~AstArena();
+
+    AstArena(const AstArena&) = delete;
+    AstArena(AstArena&&) = delete;
+    void
+    operator=(const AstArena&) = delete;
+    void
+    operator=(AstArena&&) = delete;
+
+    template <typename T, typename... Args>
+    T*
+    Make(Args&&... args)
+    {
+        // destructors are never called
+        static_assert(std::is_trivially_destructible_v<T>);
+        void* memory = Allocate(sizeof(T), alignof(T));
+        objects_made += 1;
+        return new (memory) T(std::forward<Args>(args)...);
+    }
+
+    template <typename V>
+    Span<Node<V>*>
+    MakeNodes(std::initializer_list<Node<V>*> nodes)
+    {
+        return CopyPointers(nodes.begin(), nodes.size());
+    }
+
+    template <typename V>
+    Span<Node<V>*>
+    MakeNodes(const std::vector<Node<V>*>& nodes)
+    {
+        return CopyPointers(nodes.data(), nodes.size());
+    }
+
+    std::string_view
+    MakeString(std::string_view str);
+
+    // uninitialized scratch memory that is valid until the next reset
+    template <typename T>
+    Span<T>
+    MakeArray(std::size_t size)
+    {
+        static_assert(std::is_trivial_v<T>);
+        return {static_cast<T*>(Allocate(sizeof(T) * size, alignof(T))), size};
+    }
+
+    // forget all nodes but keep the memory around for the next parse
+    void
+    Reset();
+
+    // the number of bytes handed out since the last reset
+    [[nodiscard]] std::size_t
+    BytesUsed() const;
+
+    // the number of objects made since the last reset
+    [[nodiscard]] std::size_t
+    ObjectCount() const;
+
+private:
+    void*
+    Allocate(std::size_t size, std::size_t alignment);
+
+    template <typename T>
+    Span<T*>
+    CopyPointers(T* const* source, std::size_t size)
+    {
+        auto* memory = static_cast<T**>(Allocate(sizeof(T*) * size, alignof(T*)));
+        std::copy(source, source + size, memory);
+        return {memory, size};
+    }
+
+    struct Block
+    {
+        std::unique_ptr<char[]> memory;
+        std::size_t size;
+    };
+
+    std::vector<Block> blocks;
+    std::size_t current_block = 0;
+    std::size_t used = 0;
+    std::size_t bytes_used = 0;
+    std::size_t objects_made = 0;
+};
+
+
+#endif  // CALC_ARENA_H
@@ -1,55 +1,322 @@
 #include "calc/ast.h"
 
+#include <cassert>
 
-[[nodiscard]] int
-ErrorNode::Calculate() const
+#include "calc/ints.h"
+#include "calc/value.h"
+
+
+template <typename V>
+void
+ErrorNode<V>::Accept(NodeVisitor<V>* visitor) const
+{
+    visitor->OnError(*this);
+}
+
+
+template <typename V>
+void
+ErrorNode<V>::AppendOperands(std::vector<Node<V>*>*) const
+{
+}
+
+
+template <typename V>
+NumberNode<V>::NumberNode(const V& n) : value(n)
+{
+}
+
+
+template <typename V>
+void
+NumberNode<V>::Accept(NodeVisitor<V>* visitor) const
+{
+    visitor->OnNumber(*this);
+}
+
+
+template <typename V>
+void
+NumberNode<V>::AppendOperands(std::vector<Node<V>*>*) const
+{
+}
+
+
+template <typename V>
+VariableNode<V>::VariableNode(std::string_view n, int i)
+    : name(n)
+    , index(i)
+{
+}
+
+
+template <typename V>
+void
+VariableNode<V>::Accept(NodeVisitor<V>* visitor) const
+{
+    visitor->OnVariable(*this);
+}
+
+
+template <typename V>
+void
+VariableNode<V>::AppendOperands(std::vector<Node<V>*>*) const
+{
+}
+
+
+template <typename V>
+AndNode<V>::AndNode(Span<Node<V>*> o) : operands(o)
+{
+    assert(operands.size >= 2);
+}
+
+
+template <typename V>
+void
+AndNode<V>::Accept(NodeVisitor<V>* visitor) const
+{
+    visitor->OnAnd(*this);
+}
+
+
+template <typename V>
+void
+AndNode<V>::AppendOperands(std::vector<Node<V>*>* list) const
 {
-    return 0;
+    list->insert(list->end(), operands.begin(), operands.end());
 }
 
 
-std::shared_ptr<Node>
-ErrorNode::Make()
+template <typename V>
+OrNode<V>::OrNode(Span<Node<V>*> o) : operands(o)
 {
-    return std::make_shared<ErrorNode>();
+    assert(operands.size >= 2);
 }
 
 
-NumberNode::NumberNode(int n) : value(n)
+template <typename V>
+void
+OrNode<V>::Accept(NodeVisitor<V>* visitor) const
 {
+    visitor->OnOr(*this);
 }
 
 
-[[nodiscard]] int
-NumberNode::Calculate() const
+template <typename V>
+void
+OrNode<V>::AppendOperands(std::vector<Node<V>*>* list) const
 {
-    return value;
+    list->insert(list->end(), operands.begin(), operands.end());
 }
 
 
-AndNode::AndNode(std::shared_ptr<Node> l, std::shared_ptr<Node> r)
-    : lhs(std::move(l))
-    , rhs(std::move(r))
+template <typename V>
+XorNode<V>::XorNode(Span<Node<V>*> o) : operands(o)
 {
+    assert(operands.size >= 2);
 }
 
-[[nodiscard]] int
-AndNode::Calculate() const
+
+template <typename V>
+void
+XorNode<V>::Accept(NodeVisitor<V>* visitor) const
+{
+    visitor->OnXor(*this);
+}
+
+
+template <typename V>
+void
+XorNode<V>::AppendOperands(std::vector<Node<V>*>* list) const
 {
-    return lhs->Calculate() & rhs->Calculate();
+    list->insert(list->end(), operands.begin(), operands.end());
 }
 
 
-OrNode::OrNode(std::shared_ptr<Node> l, std::shared_ptr<Node> r)
-    : lhs(std::move(l))
-    , rhs(std::move(r))
+template <typename V>
+NotNode<V>::NotNode(Node<V>* o) : operand(o)
 {
 }
 
-[[nodiscard]] int
-OrNode::Calculate() const
+
+template <typename V>
+void
+NotNode<V>::Accept(NodeVisitor<V>* visitor) const
+{
+    visitor->OnNot(*this);
+}
+
+
+template <typename V>
+void
+NotNode<V>::AppendOperands(std::vector<Node<V>*>* list) const
+{
+    list->push_back(operand);
+}
+
+
+template <typename V>
+ShiftLeftNode<V>::ShiftLeftNode(Node<V>* l, Node<V>* r)
+    : lhs(l)
+    , rhs(r)
+{
+}
+
+
+template <typename V>
+void
+ShiftLeftNode<V>::Accept(NodeVisitor<V>* visitor) const
+{
+    visitor->OnShiftLeft(*this);
+}
+
+
+template <typename V>
+void
+ShiftLeftNode<V>::AppendOperands(std::vector<Node<V>*>* list) const
+{
+    list->push_back(lhs);
+    list->push_back(rhs);
+}
+
+
+template <typename V>
+ShiftRightNode<V>::ShiftRightNode(Node<V>* l, Node<V>* r)
+    : lhs(l)
+    , rhs(r)
+{
+}
+
+
+template <typename V>
+void
+ShiftRightNode<V>::Accept(NodeVisitor<V>* visitor) const
+{
+    visitor->OnShiftRight(*this);
+}
+
+
+template <typename V>
+void
+ShiftRightNode<V>::AppendOperands(std::vector<Node<V>*>* list) const
+{
+    list->push_back(lhs);
+    list->push_back(rhs);
+}
+
+
+template <typename V>
+NodeVisitor<V>::NodeVisitor() = default;
+
+template <typename V>
+NodeVisitor<V>::~NodeVisitor() = default;
+
+
+// the value of a node from the values of its operands
+template <typename V>
+struct ValueFolder final : public NodeVisitor<V>
+{
+    const std::vector<V>* variables = nullptr;
+    Span<V> operands;
+    V result{};
+
+    void
+    OnError(const ErrorNode<V>&) override
+    {
+        result = V{};
+    }
+
+    void
+    OnNumber(const NumberNode<V>& node) override
+    {
+        result = node.value;
+    }
+
+    void
+    OnVariable(const VariableNode<V>& node) override
+    {
+        assert(node.index < ToInt(variables->size()) && "missing variable value");
+        result = (*variables)[ToSizet(node.index)];
+    }
+
+    void
+    OnAnd(const AndNode<V>&) override
+    {
+        result = operands[0];
+        for (std::size_t i = 1; i < operands.size; i += 1)
+        {
+            result &= operands[i];
+        }
+    }
+
+    void
+    OnOr(const OrNode<V>&) override
+    {
+        result = operands[0];
+        for (std::size_t i = 1; i < operands.size; i += 1)
+        {
+            result |= operands[i];
+        }
+    }
+
+    void
+    OnXor(const XorNode<V>&) override
+    {
+        result = operands[0];
+        for (std::size_t i = 1; i < operands.size; i += 1)
+        {
+            result ^= operands[i];
+        }
+    }
+
+    void
+    OnNot(const NotNode<V>&) override
+    {
+        result = Complement(operands[0]);
+    }
+
+    void
+    OnShiftLeft(const ShiftLeftNode<V>&) override
+    {
+        result = operands[0];
+        ShiftLeft(&result, operands[1]);
+    }
+
+    void
+    OnShiftRight(const ShiftRightNode<V>&) override
+    {
+        result = operands[0];
+        ShiftRight(&result, operands[1]);
+    }
+};
+
+
+template <typename V>
+[[nodiscard]] V
+Node<V>::Calculate(const std::vector<V>& variables) const
 {
-    return lhs->Calculate() | rhs->Calculate();
+    ValueFolder<V> folder;
+    folder.variables = &variables;
+    return FoldTree<V>(*this, [&folder](const Node<V>& node, Span<Node<V>* const>, Span<V> operands) {
+        folder.operands = operands;
+        node.Accept(&folder);
+        return folder.result;
+    });
 }
 
 
+#define INSTANTIATE(V) \
+    template V Node<V>::Calculate(const std::vector<V>& variables) const; \
+    template struct ErrorNode<V>; \
+    template struct NumberNode<V>; \
+    template struct VariableNode<V>; \
+    template struct AndNode<V>; \
+    template struct OrNode<V>; \
+    template struct XorNode<V>; \
+    template struct NotNode<V>; \
+    template struct ShiftLeftNode<V>; \
+    template struct ShiftRightNode<V>; \
+    template struct NodeVisitor<V>;
+CALC_FOR_EACH_VALUE(INSTANTIATE)
+#undef INSTANTIATE
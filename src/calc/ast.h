@@ -1,14 +1,23 @@
 #ifndef CALC_AST_H
 #define CALC_AST_H
 
-#include <memory>
+#include <cstddef>
+#include <string_view>
+#include <utility>
+#include <vector>
 
+#include "calc/span.h"
 
+
+template <typename V>
+struct NodeVisitor;
+
+
+// nodes are owned by a AstArena and are never destroyed one by one so
+// all nodes must be trivially destructible, V is the type of the values
+template <typename V>
 struct Node
 {
-    Node() = default;
-    virtual ~Node() = default;
-
     Node(const Node&) = delete;
     Node(Node&&) = delete;
     void
@@ -16,55 +25,279 @@ struct Node
     void
     operator=(Node&&) = delete;
 
-    [[nodiscard]] virtual int
-    Calculate() const = 0;
+    // variables are looked up by VariableNode::index
+    [[nodiscard]] V
+    Calculate(const std::vector<V>& variables) const;
+
+    virtual void
+    Accept(NodeVisitor<V>* visitor) const = 0;
+
+    // appends the operands in order, numbers, variables and errors have
+    // none
+    virtual void
+    AppendOperands(std::vector<Node<V>*>* operands) const = 0;
+
+protected:
+    Node() = default;
+    ~Node() = default;
 };
 
 
-struct ErrorNode : public Node
+template <typename V>
+struct ErrorNode final : public Node<V>
 {
-    [[nodiscard]] int
-    Calculate() const override;
+    void
+    Accept(NodeVisitor<V>* visitor) const override;
 
-    static std::shared_ptr<Node>
-    Make();
+    void
+    AppendOperands(std::vector<Node<V>*>* operands) const override;
 };
 
 
-struct NumberNode : public Node
+template <typename V>
+struct NumberNode final : public Node<V>
 {
-    int value;
+    V value;
 
-    explicit NumberNode(int n);
+    explicit NumberNode(const V& n);
 
-    [[nodiscard]] int
-    Calculate() const override;
+    void
+    Accept(NodeVisitor<V>* visitor) const override;
+
+    void
+    AppendOperands(std::vector<Node<V>*>* operands) const override;
 };
 
 
-struct AndNode : public Node
+template <typename V>
+struct VariableNode final : public Node<V>
 {
-    std::shared_ptr<Node> lhs;
-    std::shared_ptr<Node> rhs;
+    // points to memory owned by the arena
+    std::string_view name;
+    int index;
+
+    VariableNode(std::string_view n, int i);
 
-    AndNode(std::shared_ptr<Node> l, std::shared_ptr<Node> r);
+    void
+    Accept(NodeVisitor<V>* visitor) const override;
 
-    [[nodiscard]] int
-    Calculate() const override;
+    void
+    AppendOperands(std::vector<Node<V>*>* operands) const override;
 };
 
 
-struct OrNode : public Node
+// and/or/xor are associative so they can hold any number of operands,
+// the parser always creates two but the optimizer flattens chains
+template <typename V>
+struct AndNode final : public Node<V>
 {
-    std::shared_ptr<Node> lhs;
-    std::shared_ptr<Node> rhs;
+    Span<Node<V>*> operands;
 
-    OrNode(std::shared_ptr<Node> l, std::shared_ptr<Node> r);
+    explicit AndNode(Span<Node<V>*> o);
 
-    [[nodiscard]] int
-    Calculate() const override;
+    void
+    Accept(NodeVisitor<V>* visitor) const override;
+
+    void
+    AppendOperands(std::vector<Node<V>*>* operands) const override;
 };
 
 
-#endif  // CALC_AST_H
+template <typename V>
+struct OrNode final : public Node<V>
+{
+    Span<Node<V>*> operands;
+
+    explicit OrNode(Span<Node<V>*> o);
+
+    void
+    Accept(NodeVisitor<V>* visitor) const override;
+
+    void
+    AppendOperands(std::vector<Node<V>*>* operands) const override;
+};
+
+
+template <typename V>
+struct XorNode final : public Node<V>
+{
+    Span<Node<V>*> operands;
+
+    explicit XorNode(Span<Node<V>*> o);
+
+    void
+    Accept(NodeVisitor<V>* visitor) const override;
+
+    void
+    AppendOperands(std::vector<Node<V>*>* operands) const override;
+};
+
+
+template <typename V>
+struct NotNode final : public Node<V>
+{
+    Node<V>* operand;
+
+    explicit NotNode(Node<V>* o);
+
+    void
+    Accept(NodeVisitor<V>* visitor) const override;
+
+    void
+    AppendOperands(std::vector<Node<V>*>* operands) const override;
+};
 
+
+// shifts are not associative so they always have two operands
+template <typename V>
+struct ShiftLeftNode final : public Node<V>
+{
+    Node<V>* lhs;
+    Node<V>* rhs;
+
+    ShiftLeftNode(Node<V>* l, Node<V>* r);
+
+    void
+    Accept(NodeVisitor<V>* visitor) const override;
+
+    void
+    AppendOperands(std::vector<Node<V>*>* operands) const override;
+};
+
+
+template <typename V>
+struct ShiftRightNode final : public Node<V>
+{
+    Node<V>* lhs;
+    Node<V>* rhs;
+
+    ShiftRightNode(Node<V>* l, Node<V>* r);
+
+    void
+    Accept(NodeVisitor<V>* visitor) const override;
+
+    void
+    AppendOperands(std::vector<Node<V>*>* operands) const override;
+};
+
+
+// walks a node tree without knowing the concrete node types up front
+template <typename V>
+struct NodeVisitor
+{
+    NodeVisitor();
+    virtual ~NodeVisitor();
+
+    NodeVisitor(const NodeVisitor&) = delete;
+    NodeVisitor(NodeVisitor&&) = delete;
+    void
+    operator=(const NodeVisitor&) = delete;
+    void
+    operator=(NodeVisitor&&) = delete;
+
+    virtual void
+    OnError(const ErrorNode<V>& node) = 0;
+
+    virtual void
+    OnNumber(const NumberNode<V>& node) = 0;
+
+    virtual void
+    OnVariable(const VariableNode<V>& node) = 0;
+
+    virtual void
+    OnAnd(const AndNode<V>& node) = 0;
+
+    virtual void
+    OnOr(const OrNode<V>& node) = 0;
+
+    virtual void
+    OnXor(const XorNode<V>& node) = 0;
+
+    virtual void
+    OnNot(const NotNode<V>& node) = 0;
+
+    virtual void
+    OnShiftLeft(const ShiftLeftNode<V>& node) = 0;
+
+    virtual void
+    OnShiftRight(const ShiftRightNode<V>& node) = 0;
+};
+
+
+// trees can be many thousands of levels deep so they are walked with
+// explicit stacks instead of recursion, fold(node, operands, results) is
+// called for every node after its operands, results are what fold returned
+// for the operands and the result for the root is returned, operands_of
+// appends the operands of a node to walk
+template <typename R, typename V, typename OperandsOf, typename Fold>
+R
+FoldTree(const Node<V>& root, OperandsOf operands_of, Fold fold)
+{
+    struct Pending
+    {
+        const Node<V>* node;
+        // where the operands of the node start once it's expanded
+        std::size_t first_operand;
+        bool expanded;
+    };
+
+    // most trees are small so the stacks start large enough for them
+    constexpr std::size_t RESERVED = 32;
+    std::vector<Pending> pending;
+    std::vector<Node<V>*> operands;
+    std::vector<R> results;
+    pending.reserve(RESERVED);
+    operands.reserve(RESERVED);
+    results.reserve(RESERVED);
+    pending.push_back({&root, 0, false});
+    while (true)
+    {
+        if (!pending.back().expanded)
+        {
+            const auto first = operands.size();
+            pending.back().first_operand = first;
+            pending.back().expanded = true;
+            operands_of(*pending.back().node, &operands);
+
+            // the first operand is on top so it's folded first
+            for (auto index = operands.size(); index > first; index -= 1)
+            {
+                pending.push_back({operands[index - 1], 0, false});
+            }
+            continue;
+        }
+
+        const auto* node = pending.back().node;
+        const auto first = pending.back().first_operand;
+        pending.pop_back();
+
+        const auto count = operands.size() - first;
+        const auto first_result = results.size() - count;
+        auto result = fold(
+                *node,
+                Span<Node<V>* const>{operands.data() + first, count},
+                Span<R>{results.data() + first_result, count});
+        if (pending.empty())
+        {
+            return result;
+        }
+        operands.resize(first);
+        results.erase(results.begin() + static_cast<std::ptrdiff_t>(first_result), results.end());
+        results.emplace_back(std::move(result));
+    }
+}
+
+
+// same as above with the operands of every node
+template <typename R, typename V, typename Fold>
+R
+FoldTree(const Node<V>& root, Fold fold)
+{
+    return FoldTree<R>(
+            root,
+            [](const Node<V>& node, std::vector<Node<V>*>* operands) { node.AppendOperands(operands); },
+            fold);
+}
+
+
+#endif  // CALC_AST_H
@@ -0,0 +1,1010 @@
+#include "calc/bdd.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "calc/ast.h"
+
+
+constexpr std::uint32_t BDD_FALSE = 0;
+constexpr std::uint32_t BDD_TRUE = 1;
+constexpr std::uint32_t BDD_NONE = std::numeric_limits<std::uint32_t>::max();
+
+// the variable of the terminals, below every level
+constexpr std::uint32_t TERMINAL_VARIABLE = std::numeric_limits<std::uint32_t>::max();
+
+constexpr std::size_t MIN_BUCKETS = 16;
+constexpr std::size_t MIN_CACHE_SIZE = std::size_t{1} << 16;
+constexpr std::size_t MAX_CACHE_SIZE = std::size_t{1} << 22;
+
+// dead nodes are collected once there are this many and they are a large
+// part of all nodes
+constexpr std::size_t MIN_COLLECT_SIZE = 4096;
+
+// auto reordering starts at this many nodes and is done again when the
+// nodes have doubled since
+constexpr std::size_t MIN_REORDER_SIZE = 4096;
+
+// sifting stops moving a variable in one direction once the diagrams have
+// grown this much over the smallest size
+constexpr double MAX_SIFT_GROWTH = 1.2;
+
+// the precedence of a variable or a constant, see PRECEDENCE
+constexpr int ATOM_PRECEDENCE = 6;
+
+
+std::size_t
+HashChildren(std::uint32_t low, std::uint32_t high)
+{
+    const auto key = (std::uint64_t{low} << 32) | high;
+    return (key * 0x9e3779b97f4a7c15) >> 32;
+}
+
+
+Bdd::Bdd(BddManager* m, std::uint32_t n) : manager(m), node(n)
+{
+    manager->Ref(node);
+}
+
+
+Bdd::~Bdd()
+{
+    if (manager != nullptr)
+    {
+        manager->Deref(node);
+    }
+}
+
+
+Bdd::Bdd(const Bdd& other) : manager(other.manager), node(other.node)
+{
+    if (manager != nullptr)
+    {
+        manager->Ref(node);
+    }
+}
+
+
+Bdd::Bdd(Bdd&& other) noexcept : manager(other.manager), node(other.node)
+{
+    other.manager = nullptr;
+}
+
+
+Bdd&
+Bdd::operator=(const Bdd& other)
+{
+    if (other.manager != nullptr)
+    {
+        other.manager->Ref(other.node);
+    }
+    if (manager != nullptr)
+    {
+        manager->Deref(node);
+    }
+    manager = other.manager;
+    node = other.node;
+    return *this;
+}
+
+
+Bdd&
+Bdd::operator=(Bdd&& other) noexcept
+{
+    if (this != &other)
+    {
+        if (manager != nullptr)
+        {
+            manager->Deref(node);
+        }
+        manager = other.manager;
+        node = other.node;
+        other.manager = nullptr;
+    }
+    return *this;
+}
+
+
+[[nodiscard]] bool
+Bdd::operator==(const Bdd& other) const
+{
+    return manager == other.manager && node == other.node;
+}
+
+
+[[nodiscard]] bool
+Bdd::operator!=(const Bdd& other) const
+{
+    return !(*this == other);
+}
+
+
+[[nodiscard]] bool
+Bdd::IsTrue() const
+{
+    return manager != nullptr && node == BDD_TRUE;
+}
+
+
+[[nodiscard]] bool
+Bdd::IsFalse() const
+{
+    return manager != nullptr && node == BDD_FALSE;
+}
+
+
+// the tree is built bottom up with a operation for every node, so the
+// manager can collect and reorder between them
+struct BddBuilder final : public NodeVisitor<std::uint64_t>
+{
+    BddManager* manager;
+    // the diagrams of the operands of the visited node
+    Span<Bdd> operands;
+    Bdd result;
+
+    explicit BddBuilder(BddManager* m) : manager(m)
+    {
+    }
+
+    Bdd
+    Build(const Node<std::uint64_t>& root)
+    {
+        return FoldTree<Bdd>(
+                root,
+                [this](const Node<std::uint64_t>& node, Span<Node<std::uint64_t>* const>, Span<Bdd> built) {
+                    operands = built;
+                    node.Accept(this);
+                    return std::move(result);
+                });
+    }
+
+    void
+    OnError(const ErrorNode<std::uint64_t>&) override
+    {
+        result = manager->False();
+    }
+
+    void
+    OnNumber(const NumberNode<std::uint64_t>& node) override
+    {
+        result = (node.value & 1) != 0 ? manager->True() : manager->False();
+    }
+
+    void
+    OnVariable(const VariableNode<std::uint64_t>& node) override
+    {
+        result = manager->Variable(node.name);
+    }
+
+    void
+    OnAnd(const AndNode<std::uint64_t>&) override
+    {
+        Combine([this](const Bdd& lhs, const Bdd& rhs) { return manager->And(lhs, rhs); });
+    }
+
+    void
+    OnOr(const OrNode<std::uint64_t>&) override
+    {
+        Combine([this](const Bdd& lhs, const Bdd& rhs) { return manager->Or(lhs, rhs); });
+    }
+
+    void
+    OnXor(const XorNode<std::uint64_t>&) override
+    {
+        Combine([this](const Bdd& lhs, const Bdd& rhs) { return manager->Xor(lhs, rhs); });
+    }
+
+    void
+    OnNot(const NotNode<std::uint64_t>&) override
+    {
+        result = manager->Not(operands[0]);
+    }
+
+    // a boolean shifted by 0 is itself and shifted by 1 is 0
+    void
+    OnShiftLeft(const ShiftLeftNode<std::uint64_t>&) override
+    {
+        ClearIf();
+    }
+
+    void
+    OnShiftRight(const ShiftRightNode<std::uint64_t>&) override
+    {
+        ClearIf();
+    }
+
+private:
+    template <typename F>
+    void
+    Combine(F combine)
+    {
+        auto combined = operands[0];
+        for (std::size_t index = 1; index < operands.size; index += 1)
+        {
+            combined = combine(combined, operands[index]);
+        }
+        result = std::move(combined);
+    }
+
+    void
+    ClearIf()
+    {
+        result = manager->And(operands[0], manager->Not(operands[1]));
+    }
+};
+
+
+// a part of a expression that is being made from a diagram
+struct BddManager::Text
+{
+    std::string text;
+    int precedence = ATOM_PRECEDENCE;
+    std::size_t tokens = 0;
+
+    void
+    Append(const Text& operand, int parent_precedence)
+    {
+        if (operand.precedence < parent_precedence)
+        {
+            text += '(';
+            text += operand.text;
+            text += ')';
+            tokens += operand.tokens + 2;
+        }
+        else
+        {
+            text += operand.text;
+            tokens += operand.tokens;
+        }
+    }
+
+    // the two operands with the operator between them
+    static Text
+    Join(const Text& lhs, std::string_view op, int precedence, const Text& rhs)
+    {
+        auto joined = Text{};
+        joined.precedence = precedence;
+        joined.Append(lhs, precedence);
+        joined.text += op;
+        joined.tokens += 1;
+        joined.Append(rhs, precedence);
+        return joined;
+    }
+};
+
+
+BddManager::BddManager()
+    : free_list(BDD_NONE)
+    , cache(MIN_CACHE_SIZE)
+    , next_reorder_size(MIN_REORDER_SIZE)
+{
+    nodes.emplace_back(BddNode{TERMINAL_VARIABLE, BDD_FALSE, BDD_FALSE, 0, BDD_NONE});
+    nodes.emplace_back(BddNode{TERMINAL_VARIABLE, BDD_TRUE, BDD_TRUE, 0, BDD_NONE});
+}
+
+
+BddManager::~BddManager() = default;
+
+
+Bdd
+BddManager::Variable(std::string_view name)
+{
+    const auto found = variables_by_name.find(std::string{name});
+    if (found != variables_by_name.end())
+    {
+        return Bdd{this, MakeNode(found->second, BDD_FALSE, BDD_TRUE)};
+    }
+
+    const auto variable = static_cast<std::uint32_t>(names.size());
+    names.emplace_back(name);
+    variables_by_name.emplace(std::string{name}, variable);
+    level_of_variable.emplace_back(static_cast<std::uint32_t>(variable_at_level.size()));
+    variable_at_level.emplace_back(variable);
+    subtables.emplace_back();
+    subtables.back().buckets.assign(MIN_BUCKETS, BDD_NONE);
+    return Bdd{this, MakeNode(variable, BDD_FALSE, BDD_TRUE)};
+}
+
+
+Bdd
+BddManager::True()
+{
+    return Bdd{this, BDD_TRUE};
+}
+
+
+Bdd
+BddManager::False()
+{
+    return Bdd{this, BDD_FALSE};
+}
+
+
+Bdd
+BddManager::And(const Bdd& lhs, const Bdd& rhs)
+{
+    Maintain();
+    return Bdd{this, Apply(Op::AND, lhs.node, rhs.node)};
+}
+
+
+Bdd
+BddManager::Or(const Bdd& lhs, const Bdd& rhs)
+{
+    Maintain();
+    return Bdd{this, Apply(Op::OR, lhs.node, rhs.node)};
+}
+
+
+Bdd
+BddManager::Xor(const Bdd& lhs, const Bdd& rhs)
+{
+    Maintain();
+    return Bdd{this, Apply(Op::XOR, lhs.node, rhs.node)};
+}
+
+
+Bdd
+BddManager::Not(const Bdd& operand)
+{
+    Maintain();
+    return Bdd{this, Apply(Op::XOR, operand.node, BDD_TRUE)};
+}
+
+
+Bdd
+BddManager::FromTree(const Node<std::uint64_t>& root)
+{
+    auto builder = BddBuilder{this};
+    return builder.Build(root);
+}
+
+
+[[nodiscard]] std::size_t
+BddManager::VariableCount() const
+{
+    return names.size();
+}
+
+
+[[nodiscard]] std::size_t
+BddManager::NodeCount() const
+{
+    return LiveCount();
+}
+
+
+[[nodiscard]] std::size_t
+BddManager::NodeCount(const Bdd& function) const
+{
+    std::vector<bool> seen(nodes.size());
+    std::vector<std::uint32_t> stack = {function.node};
+    std::size_t count = 0;
+    while (!stack.empty())
+    {
+        const auto node = stack.back();
+        stack.pop_back();
+        if (seen[node])
+        {
+            continue;
+        }
+        seen[node] = true;
+        count += 1;
+        if (node > BDD_TRUE)
+        {
+            stack.emplace_back(nodes[node].low);
+            stack.emplace_back(nodes[node].high);
+        }
+    }
+    return count;
+}
+
+
+[[nodiscard]] std::vector<std::string>
+BddManager::Order() const
+{
+    std::vector<std::string> order;
+    for (const auto variable: variable_at_level)
+    {
+        order.emplace_back(names[variable]);
+    }
+    return order;
+}
+
+
+bool
+BddManager::FindSatisfying(const Bdd& function, BddAssignment* assignment) const
+{
+    assignment->clear();
+    for (const auto& name: names)
+    {
+        assignment->emplace_back(name, false);
+    }
+    if (function.node == BDD_FALSE)
+    {
+        return false;
+    }
+
+    // every node but false has a path to true in a reduced diagram
+    auto node = function.node;
+    while (node > BDD_TRUE)
+    {
+        const auto& bdd_node = nodes[node];
+        const auto take_high = bdd_node.high != BDD_FALSE;
+        (*assignment)[bdd_node.variable].second = take_high;
+        node = take_high ? bdd_node.high : bdd_node.low;
+    }
+    return true;
+}
+
+
+bool
+BddManager::ToExpression(const Bdd& function, std::size_t max_tokens, std::string* expression)
+{
+    auto text = Text{};
+    if (!AppendText(function.node, max_tokens, &text))
+    {
+        return false;
+    }
+    *expression = std::move(text.text);
+    return true;
+}
+
+
+void
+BddManager::Reorder()
+{
+    Collect();
+    ClearCache();
+
+    // the swaps go through all buckets, so tables that were larger before
+    // are made to fit
+    for (std::uint32_t variable = 0; variable < subtables.size(); variable += 1)
+    {
+        auto bucket_count = MIN_BUCKETS;
+        while (bucket_count < subtables[variable].count)
+        {
+            bucket_count *= 2;
+        }
+        if (bucket_count < subtables[variable].buckets.size())
+        {
+            Rehash(variable, bucket_count);
+        }
+    }
+
+    // the variables with the most nodes gain the most from a better level
+    std::vector<std::uint32_t> variables(names.size());
+    for (std::uint32_t variable = 0; variable < variables.size(); variable += 1)
+    {
+        variables[variable] = variable;
+    }
+    std::stable_sort(variables.begin(), variables.end(), [this](std::uint32_t lhs, std::uint32_t rhs) {
+        return subtables[lhs].count > subtables[rhs].count;
+    });
+    for (const auto variable: variables)
+    {
+        // a variable without nodes is the same at any level
+        if (subtables[variable].count > 0)
+        {
+            Sift(variable);
+        }
+    }
+}
+
+
+void
+BddManager::SetAutoReorder(bool enabled)
+{
+    auto_reorder = enabled;
+}
+
+
+void
+BddManager::Ref(std::uint32_t node)
+{
+    if (node > BDD_TRUE && nodes[node].refs == 0)
+    {
+        dead_count -= 1;
+        Ref(nodes[node].low);
+        Ref(nodes[node].high);
+    }
+    nodes[node].refs += 1;
+}
+
+
+void
+BddManager::Deref(std::uint32_t node)
+{
+    nodes[node].refs -= 1;
+    if (node > BDD_TRUE && nodes[node].refs == 0)
+    {
+        dead_count += 1;
+        Deref(nodes[node].low);
+        Deref(nodes[node].high);
+    }
+}
+
+
+[[nodiscard]] std::uint32_t
+BddManager::Level(std::uint32_t node) const
+{
+    const auto variable = nodes[node].variable;
+    return variable == TERMINAL_VARIABLE ? static_cast<std::uint32_t>(names.size()) : level_of_variable[variable];
+}
+
+
+[[nodiscard]] std::size_t
+BddManager::LiveCount() const
+{
+    return nodes.size() - free_count - dead_count;
+}
+
+
+[[nodiscard]] std::uint32_t
+BddManager::Find(std::uint32_t variable, std::uint32_t low, std::uint32_t high) const
+{
+    const auto& table = subtables[variable];
+    auto node = table.buckets[HashChildren(low, high) & (table.buckets.size() - 1)];
+    while (node != BDD_NONE && (nodes[node].low != low || nodes[node].high != high))
+    {
+        node = nodes[node].next;
+    }
+    return node;
+}
+
+
+std::uint32_t
+BddManager::MakeNode(std::uint32_t variable, std::uint32_t low, std::uint32_t high)
+{
+    if (low == high)
+    {
+        return low;
+    }
+    const auto found = Find(variable, low, high);
+    if (found != BDD_NONE)
+    {
+        return found;
+    }
+
+    auto node = free_list;
+    if (node != BDD_NONE)
+    {
+        free_list = nodes[node].next;
+        free_count -= 1;
+    }
+    else
+    {
+        node = static_cast<std::uint32_t>(nodes.size());
+        nodes.emplace_back();
+    }
+    nodes[node] = BddNode{variable, low, high, 0, BDD_NONE};
+    dead_count += 1;
+    Insert(node);
+    return node;
+}
+
+
+void
+BddManager::Insert(std::uint32_t node)
+{
+    auto& table = subtables[nodes[node].variable];
+    if (table.count >= table.buckets.size() * 2)
+    {
+        Rehash(nodes[node].variable, table.buckets.size() * 2);
+    }
+
+    auto& bucket = table.buckets[HashChildren(nodes[node].low, nodes[node].high) & (table.buckets.size() - 1)];
+    nodes[node].next = bucket;
+    bucket = node;
+    table.count += 1;
+}
+
+
+void
+BddManager::Rehash(std::uint32_t variable, std::size_t bucket_count)
+{
+    auto& table = subtables[variable];
+    std::vector<std::uint32_t> buckets(bucket_count, BDD_NONE);
+    for (auto chain: table.buckets)
+    {
+        while (chain != BDD_NONE)
+        {
+            const auto next = nodes[chain].next;
+            auto& bucket = buckets[HashChildren(nodes[chain].low, nodes[chain].high) & (bucket_count - 1)];
+            nodes[chain].next = bucket;
+            bucket = chain;
+            chain = next;
+        }
+    }
+    table.buckets = std::move(buckets);
+}
+
+
+void
+BddManager::Remove(std::uint32_t node)
+{
+    auto& table = subtables[nodes[node].variable];
+    auto* link = &table.buckets[HashChildren(nodes[node].low, nodes[node].high) & (table.buckets.size() - 1)];
+    while (*link != node)
+    {
+        link = &nodes[*link].next;
+    }
+    *link = nodes[node].next;
+    table.count -= 1;
+}
+
+
+void
+BddManager::Free(std::uint32_t node)
+{
+    Remove(node);
+    dead_count -= 1;
+    nodes[node].next = free_list;
+    free_list = node;
+    free_count += 1;
+}
+
+
+std::uint32_t
+BddManager::Apply(Op op, std::uint32_t lhs, std::uint32_t rhs)
+{
+    switch (op)
+    {
+    case Op::AND:
+        if (lhs == BDD_FALSE || rhs == BDD_FALSE)
+        {
+            return BDD_FALSE;
+        }
+        if (lhs == BDD_TRUE || lhs == rhs)
+        {
+            return rhs;
+        }
+        if (rhs == BDD_TRUE)
+        {
+            return lhs;
+        }
+        break;
+    case Op::OR:
+        if (lhs == BDD_TRUE || rhs == BDD_TRUE)
+        {
+            return BDD_TRUE;
+        }
+        if (lhs == BDD_FALSE || lhs == rhs)
+        {
+            return rhs;
+        }
+        if (rhs == BDD_FALSE)
+        {
+            return lhs;
+        }
+        break;
+    case Op::XOR:
+        if (lhs == rhs)
+        {
+            return BDD_FALSE;
+        }
+        if (lhs == BDD_FALSE)
+        {
+            return rhs;
+        }
+        if (rhs == BDD_FALSE)
+        {
+            return lhs;
+        }
+        break;
+    }
+
+    // all operations are commutative
+    if (lhs > rhs)
+    {
+        std::swap(lhs, rhs);
+    }
+    auto& entry = cache[(HashChildren(lhs, rhs) + static_cast<std::size_t>(op)) & (cache.size() - 1)];
+    if (entry.used && entry.op == op && entry.lhs == lhs && entry.rhs == rhs)
+    {
+        return entry.result;
+    }
+
+    const auto level = std::min(Level(lhs), Level(rhs));
+    const auto variable = variable_at_level[level];
+    const auto cofactor = [&](std::uint32_t node, bool high) {
+        if (Level(node) != level)
+        {
+            return node;
+        }
+        return high ? nodes[node].high : nodes[node].low;
+    };
+    const auto low = Apply(op, cofactor(lhs, false), cofactor(rhs, false));
+    const auto high = Apply(op, cofactor(lhs, true), cofactor(rhs, true));
+    const auto result = MakeNode(variable, low, high);
+
+    // the cache only grows between operations so the entry is still there
+    entry = CacheEntry{lhs, rhs, result, op, true};
+    return result;
+}
+
+
+void
+BddManager::Maintain()
+{
+    if (dead_count >= MIN_COLLECT_SIZE && dead_count * 2 >= nodes.size() - free_count)
+    {
+        Collect();
+    }
+
+    const auto live = LiveCount();
+    if (auto_reorder && live >= next_reorder_size)
+    {
+        Reorder();
+        next_reorder_size = std::max(MIN_REORDER_SIZE, LiveCount() * 2);
+    }
+
+    // the cache grows with the diagrams
+    auto cache_size = cache.size();
+    while (cache_size < live && cache_size < MAX_CACHE_SIZE)
+    {
+        cache_size *= 2;
+    }
+    if (cache_size > cache.size())
+    {
+        cache.assign(cache_size, CacheEntry{});
+    }
+}
+
+
+void
+BddManager::Collect()
+{
+    if (dead_count == 0)
+    {
+        return;
+    }
+
+    for (auto& table: subtables)
+    {
+        for (auto& chain: table.buckets)
+        {
+            auto node = chain;
+            while (node != BDD_NONE)
+            {
+                const auto next = nodes[node].next;
+                if (nodes[node].refs == 0)
+                {
+                    Free(node);
+                }
+                node = next;
+            }
+        }
+    }
+    ClearCache();
+}
+
+
+void
+BddManager::ClearCache()
+{
+    std::fill(cache.begin(), cache.end(), CacheEntry{});
+}
+
+
+void
+BddManager::Swap(std::uint32_t level)
+{
+    const auto upper = variable_at_level[level];
+    const auto lower = variable_at_level[level + 1];
+
+    // the nodes of the upper variable that depend on the lower one
+    auto& moved = swapped;
+    moved.clear();
+    for (auto chain: subtables[upper].buckets)
+    {
+        for (auto node = chain; node != BDD_NONE; node = nodes[node].next)
+        {
+            if (nodes[nodes[node].low].variable == lower || nodes[nodes[node].high].variable == lower)
+            {
+                moved.emplace_back(node);
+            }
+        }
+    }
+    for (const auto node: moved)
+    {
+        Remove(node);
+    }
+
+    variable_at_level[level] = lower;
+    variable_at_level[level + 1] = upper;
+    level_of_variable[lower] = level;
+    level_of_variable[upper] = level + 1;
+
+    // f = upper ? (lower ? f11 : f10) : (lower ? f01 : f00) keeps its
+    // node and becomes lower ? (upper ? f11 : f01) : (upper ? f10 : f00)
+    for (const auto node: moved)
+    {
+        const auto f0 = nodes[node].low;
+        const auto f1 = nodes[node].high;
+        const auto cofactor = [this, lower](std::uint32_t child, bool high) {
+            if (nodes[child].variable != lower)
+            {
+                return child;
+            }
+            return high ? nodes[child].high : nodes[child].low;
+        };
+
+        const auto high = MakeNode(upper, cofactor(f0, true), cofactor(f1, true));
+        Ref(high);
+        const auto low = MakeNode(upper, cofactor(f0, false), cofactor(f1, false));
+        Ref(low);
+
+        // nodes of the lower variable that were only used by moved nodes
+        // are freed, the nodes below them are children of the new nodes
+        for (const auto child: {f0, f1})
+        {
+            Deref(child);
+            if (nodes[child].variable == lower && nodes[child].refs == 0)
+            {
+                Free(child);
+            }
+        }
+
+        nodes[node].variable = lower;
+        nodes[node].low = low;
+        nodes[node].high = high;
+        Insert(node);
+    }
+}
+
+
+void
+BddManager::Sift(std::uint32_t variable)
+{
+    const auto bottom = static_cast<std::uint32_t>(names.size() - 1);
+    auto level = level_of_variable[variable];
+    auto best_level = level;
+    auto best_size = LiveCount();
+
+    const auto moved_to = [&](std::uint32_t new_level) {
+        level = new_level;
+        const auto size = LiveCount();
+        if (size < best_size)
+        {
+            best_size = size;
+            best_level = level;
+        }
+        return static_cast<double>(size) <= static_cast<double>(best_size) * MAX_SIFT_GROWTH;
+    };
+
+    const auto sift_down = [&]() {
+        while (level < bottom)
+        {
+            Swap(level);
+            if (!moved_to(level + 1))
+            {
+                break;
+            }
+        }
+    };
+    const auto sift_up = [&]() {
+        while (level > 0)
+        {
+            Swap(level - 1);
+            if (!moved_to(level - 1))
+            {
+                break;
+            }
+        }
+    };
+
+    // the nearer end first since that way is walked twice
+    if (bottom - level < level)
+    {
+        sift_down();
+        sift_up();
+    }
+    else
+    {
+        sift_up();
+        sift_down();
+    }
+
+    while (level < best_level)
+    {
+        Swap(level);
+        level += 1;
+    }
+    while (level > best_level)
+    {
+        Swap(level - 1);
+        level -= 1;
+    }
+}
+
+
+bool
+BddManager::AppendText(std::uint32_t node, std::size_t max_tokens, Text* text)
+{
+    if (node <= BDD_TRUE)
+    {
+        text->text = node == BDD_TRUE ? "1" : "0";
+        text->tokens = 1;
+        return text->tokens <= max_tokens;
+    }
+
+    const auto low = nodes[node].low;
+    const auto high = nodes[node].high;
+    auto variable = Text{names[nodes[node].variable], ATOM_PRECEDENCE, 1};
+    auto inverted = Text{"~" + variable.text, ATOM_PRECEDENCE - 1, 2};
+
+    // the precedence of the operators, see PRECEDENCE
+    constexpr int OR_PRECEDENCE = 1;
+    constexpr int XOR_PRECEDENCE = 2;
+    constexpr int AND_PRECEDENCE = 3;
+
+    const auto child = [this, max_tokens](std::uint32_t n, Text* child_text) {
+        return AppendText(n, max_tokens, child_text);
+    };
+
+    Text lhs;
+    Text rhs;
+    if (high == BDD_TRUE && low == BDD_FALSE)
+    {
+        *text = std::move(variable);
+    }
+    else if (high == BDD_FALSE && low == BDD_TRUE)
+    {
+        *text = std::move(inverted);
+    }
+    else if (high == BDD_TRUE)
+    {
+        if (!child(low, &rhs))
+        {
+            return false;
+        }
+        *text = Text::Join(variable, " | ", OR_PRECEDENCE, rhs);
+    }
+    else if (low == BDD_FALSE)
+    {
+        if (!child(high, &rhs))
+        {
+            return false;
+        }
+        *text = Text::Join(variable, " & ", AND_PRECEDENCE, rhs);
+    }
+    else if (high == BDD_FALSE)
+    {
+        if (!child(low, &rhs))
+        {
+            return false;
+        }
+        *text = Text::Join(inverted, " & ", AND_PRECEDENCE, rhs);
+    }
+    else if (low == BDD_TRUE)
+    {
+        if (!child(high, &rhs))
+        {
+            return false;
+        }
+        *text = Text::Join(inverted, " | ", OR_PRECEDENCE, rhs);
+    }
+    else if (low == Apply(Op::XOR, high, BDD_TRUE))
+    {
+        // x ? h : ~h is x ^ ~h
+        if (!child(low, &rhs))
+        {
+            return false;
+        }
+        *text = Text::Join(variable, " ^ ", XOR_PRECEDENCE, rhs);
+    }
+    else
+    {
+        if (!child(high, &lhs) || !child(low, &rhs))
+        {
+            return false;
+        }
+        *text = Text::Join(
+                Text::Join(variable, " & ", AND_PRECEDENCE, lhs),
+                " | ",
+                OR_PRECEDENCE,
+                Text::Join(inverted, " & ", AND_PRECEDENCE, rhs));
+    }
+    return text->tokens <= max_tokens;
+}
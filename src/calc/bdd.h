@@ -0,0 +1,269 @@
+#ifndef CALC_BDD_H
+#define CALC_BDD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+template <typename V>
+struct Node;
+
+struct BddManager;
+
+
+// a boolean function of a BddManager, the handle keeps the nodes of the
+// function alive and must not outlive the manager
+//
+// the diagrams are reduced and ordered so two handles of the same manager
+// are equal exactly when their functions are
+struct Bdd
+{
+    Bdd() = default;
+    ~Bdd();
+
+    Bdd(const Bdd& other);
+    Bdd(Bdd&& other) noexcept;
+    Bdd&
+    operator=(const Bdd& other);
+    Bdd&
+    operator=(Bdd&& other) noexcept;
+
+    [[nodiscard]] bool
+    operator==(const Bdd& other) const;
+
+    [[nodiscard]] bool
+    operator!=(const Bdd& other) const;
+
+    [[nodiscard]] bool
+    IsTrue() const;
+
+    [[nodiscard]] bool
+    IsFalse() const;
+
+private:
+    friend struct BddManager;
+
+    Bdd(BddManager* m, std::uint32_t n);
+
+    BddManager* manager = nullptr;
+    std::uint32_t node = 0;
+};
+
+
+// the values of the variables, the variables in the order they were added
+using BddAssignment = std::vector<std::pair<std::string, bool>>;
+
+
+// a reduced ordered binary decision diagram package, the functions of all
+// handles share their nodes
+//
+// every node is in the unique table of its variable so a function is never
+// stored twice, and the results of and, or and xor are kept in a compute
+// cache, nodes count the nodes and handles that point to them and the
+// nodes nothing points to are freed before the next operation once there
+// are many of them
+//
+// the size of a diagram depends a lot on the order of the variables, a new
+// variable is placed below the others and Reorder moves them with sifting,
+// with auto reordering that is done before a operation when the number of
+// nodes has doubled
+struct BddManager
+{
+    BddManager();
+    ~BddManager();
+
+    BddManager(const BddManager&) = delete;
+    BddManager(BddManager&&) = delete;
+    void
+    operator=(const BddManager&) = delete;
+    void
+    operator=(BddManager&&) = delete;
+
+    // the variable with the name, it's added if it's new
+    Bdd
+    Variable(std::string_view name);
+
+    Bdd
+    True();
+
+    Bdd
+    False();
+
+    Bdd
+    And(const Bdd& lhs, const Bdd& rhs);
+
+    Bdd
+    Or(const Bdd& lhs, const Bdd& rhs);
+
+    Bdd
+    Xor(const Bdd& lhs, const Bdd& rhs);
+
+    Bdd
+    Not(const Bdd& operand);
+
+    // the tree as a boolean function like a truth table sees it, variables
+    // are 0 or 1, constants are their lowest bit and a shift by 1 clears
+    // the value, the variables are looked up by name
+    Bdd
+    FromTree(const Node<std::uint64_t>& root);
+
+    [[nodiscard]] std::size_t
+    VariableCount() const;
+
+    // the nodes of all functions, with the two terminals
+    [[nodiscard]] std::size_t
+    NodeCount() const;
+
+    // the nodes of one function, with the terminals it uses
+    [[nodiscard]] std::size_t
+    NodeCount(const Bdd& function) const;
+
+    // the variable names from the top of the diagrams to the bottom
+    [[nodiscard]] std::vector<std::string>
+    Order() const;
+
+    // a assignment of all variables for which the function is true, false
+    // if there is none, variables the function doesn't depend on are 0
+    bool
+    FindSatisfying(const Bdd& function, BddAssignment* assignment) const;
+
+    // a expression with the same function made from the diagram, false if
+    // it would have more than the given number of tokens
+    bool
+    ToExpression(const Bdd& function, std::size_t max_tokens, std::string* expression);
+
+    // moves each variable to the level where the diagrams are smallest
+    void
+    Reorder();
+
+    void
+    SetAutoReorder(bool enabled);
+
+private:
+    friend struct Bdd;
+
+    enum class Op : std::uint8_t
+    {
+        AND,
+        OR,
+        XOR
+    };
+
+    // the terminals are the first two nodes and have no variable, the
+    // refs of a node count its handles and live parents, a dead node has
+    // none and doesn't count for its children but stays in the unique
+    // table until it's collected or used again
+    struct BddNode
+    {
+        std::uint32_t variable;
+        std::uint32_t low;
+        std::uint32_t high;
+        std::uint32_t refs;
+
+        // the next node in the same bucket or the next free node
+        std::uint32_t next;
+    };
+
+    // the nodes of one variable by their children
+    struct Subtable
+    {
+        std::vector<std::uint32_t> buckets;
+        std::size_t count = 0;
+    };
+
+    struct CacheEntry
+    {
+        std::uint32_t lhs;
+        std::uint32_t rhs;
+        std::uint32_t result;
+        Op op;
+        bool used;
+    };
+
+    struct Text;
+
+    std::vector<BddNode> nodes;
+    std::uint32_t free_list;
+    std::size_t free_count = 0;
+
+    // nodes that are dead but still in the tables
+    std::size_t dead_count = 0;
+
+    std::vector<Subtable> subtables;
+    std::vector<CacheEntry> cache;
+
+    std::vector<std::string> names;
+    std::unordered_map<std::string, std::uint32_t> variables_by_name;
+    std::vector<std::uint32_t> variable_at_level;
+    std::vector<std::uint32_t> level_of_variable;
+
+    bool auto_reorder = false;
+    std::size_t next_reorder_size;
+
+    // the nodes a swap moves, kept to reuse the memory
+    std::vector<std::uint32_t> swapped;
+
+    // a node that dies lets go of its children and takes them back when
+    // it's used again
+    void
+    Ref(std::uint32_t node);
+
+    void
+    Deref(std::uint32_t node);
+
+    [[nodiscard]] std::uint32_t
+    Level(std::uint32_t node) const;
+
+    [[nodiscard]] std::size_t
+    LiveCount() const;
+
+    [[nodiscard]] std::uint32_t
+    Find(std::uint32_t variable, std::uint32_t low, std::uint32_t high) const;
+
+    std::uint32_t
+    MakeNode(std::uint32_t variable, std::uint32_t low, std::uint32_t high);
+
+    void
+    Insert(std::uint32_t node);
+
+    void
+    Rehash(std::uint32_t variable, std::size_t bucket_count);
+
+    void
+    Remove(std::uint32_t node);
+
+    // takes a dead node out of its table
+    void
+    Free(std::uint32_t node);
+
+    std::uint32_t
+    Apply(Op op, std::uint32_t lhs, std::uint32_t rhs);
+
+    // garbage collection and auto reordering, only between operations
+    // since the nodes of a unfinished operation have no references
+    void
+    Maintain();
+
+    void
+    Collect();
+
+    void
+    ClearCache();
+
+    // swaps the variables at the level and the level below
+    void
+    Swap(std::uint32_t level);
+
+    void
+    Sift(std::uint32_t variable);
+
+    bool
+    AppendText(std::uint32_t node, std::size_t max_tokens, Text* text);
+};
+
+
+#endif  // CALC_BDD_H
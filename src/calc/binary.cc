@@ -1,65 +1,70 @@
 #include "calc/binary.h"
 
-#include <vector>
-#include <sstream>
-#include <cassert>
+#include <algorithm>
+#include <cstring>
 
 
+constexpr char NIBBLES[16][4] = {
+        {'0', '0', '0', '0'}, {'0', '0', '0', '1'}, {'0', '0', '1', '0'}, {'0', '0', '1', '1'},
+        {'0', '1', '0', '0'}, {'0', '1', '0', '1'}, {'0', '1', '1', '0'}, {'0', '1', '1', '1'},
+        {'1', '0', '0', '0'}, {'1', '0', '0', '1'}, {'1', '0', '1', '0'}, {'1', '0', '1', '1'},
+        {'1', '1', '0', '0'}, {'1', '1', '0', '1'}, {'1', '1', '1', '0'}, {'1', '1', '1', '1'}};
+
+
+// n must not be 0
 int
-ParseBinary(const std::string& str)
+CountLeadingZeros(std::uint64_t n)
 {
-    int n = 0;
-    for (const char c: str)
+#if defined(__GNUC__)
+    return __builtin_clzll(n);
+#else
+    int zeros = 0;
+    while ((n & (std::uint64_t{1} << 63)) == 0)
     {
-        n = n << 1;
-        if (c == '1')
-        {
-            n = n | 0x1;
-        }
-        else if (c == '0')
-        {
-            // nothing
-        }
-        else
-        {
-            assert(0 && "invalid binary");
-        }
+        zeros += 1;
+        n <<= 1;
     }
-    return n;
+    return zeros;
+#endif
 }
 
 
-std::string
-ToBinaryString(int n)
+std::string_view
+FormatBinary(std::uint64_t n, BinaryBuffer* buffer, int min_digits)
 {
-    if (n == 0)
-    {
-        return "0";
-    }
+    const int digits = std::max(min_digits, n == 0 ? 1 : 64 - CountLeadingZeros(n));
+    const int groups = (digits + 3) / 4;
 
-    std::vector<char> c;
-    {
-        int number = n;
-        int i = 0;
-        while (number > 0)
-        {
-            if (i >= 4)
-            {
-                i -= 4;
-                c.emplace_back(' ');
-            }
+    char* out = buffer->data();
 
-            c.emplace_back((number & 0x1) != 0 ? '1' : '0');
-            i += 1;
-            number = number >> 1;
-        }
-    }
+    // the first group is the only one that can be shorter than 4
+    int shift = (groups - 1) * 4;
+    const auto first = static_cast<std::size_t>(digits - shift);
+    std::memcpy(out, NIBBLES[(n >> shift) & 0xf] + (4 - first), first);
+    out += first;
 
-    std::stringstream ss;
-    for (auto i = c.rbegin(); i != c.rend(); i++)
+    while (shift > 0)
     {
-        ss << *i;
+        shift -= 4;
+        *out = ' ';
+        std::memcpy(out + 1, NIBBLES[(n >> shift) & 0xf], 4);
+        out += 5;
     }
-    return ss.str();
+
+    return {buffer->data(), static_cast<std::size_t>(out - buffer->data())};
 }
 
+
+std::string_view
+FormatBinary(int n, BinaryBuffer* buffer)
+{
+    return FormatBinary(std::uint64_t{static_cast<std::uint32_t>(n)}, buffer);
+}
+
+
+std::string
+ToBinaryString(int n)
+{
+    BinaryBuffer buffer;
+    return std::string{FormatBinary(n, &buffer)};
+}
@@ -1,16 +1,27 @@
 #ifndef CALC_BINARY_H
 #define CALC_BINARY_H
 
+#include <array>
+#include <cstdint>
 #include <string>
+#include <string_view>
 
 
-int
-ParseBinary(const std::string& str);
+// 64 digits and a space between each group of 4
+using BinaryBuffer = std::array<char, 64 + 15>;
 
 
+// writes the bits grouped by 4 from the right and without leading zeros
+// unless there are less than min_digits, the result points into the buffer
+std::string_view
+FormatBinary(std::uint64_t n, BinaryBuffer* buffer, int min_digits = 1);
+
+// negative numbers are written as 32 bit two's complement
+std::string_view
+FormatBinary(int n, BinaryBuffer* buffer);
+
 std::string
 ToBinaryString(int n);
 
 
 #endif  // CALC_BINARY_H
-
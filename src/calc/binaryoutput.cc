@@ -0,0 +1,57 @@
+#include "calc/binaryoutput.h"
+
+
+BinaryOutput::BinaryOutput(std::FILE* f, Output* t, std::size_t size)
+    : file(f)
+    , text(t)
+    , flush_size(size)
+{
+    buffer.reserve(flush_size);
+}
+
+
+BinaryOutput::~BinaryOutput()
+{
+    Flush();
+}
+
+
+void
+BinaryOutput::PrintInfo(std::string_view str)
+{
+    text->PrintInfo(str);
+}
+
+
+void
+BinaryOutput::PrintError(std::string_view str)
+{
+    text->PrintError(str);
+}
+
+
+void
+BinaryOutput::PrintRecords(std::string_view records)
+{
+    buffer.append(records);
+    if (buffer.size() >= flush_size)
+    {
+        Flush();
+    }
+}
+
+
+bool
+BinaryOutput::Flush()
+{
+    if (!failed && buffer.size() > 0)
+    {
+        failed = std::fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size();
+    }
+    buffer.clear();
+    if (!failed)
+    {
+        failed = std::fflush(file) != 0;
+    }
+    return !failed;
+}
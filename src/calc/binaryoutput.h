@@ -0,0 +1,43 @@
+#ifndef CALC_BINARYOUTPUT_H
+#define CALC_BINARYOUTPUT_H
+
+#include <cstddef>
+#include <cstdio>
+#include <string_view>
+
+#include <fmt/format.h>
+
+#include "calc/output.h"
+
+
+// collects the records of --binary in a large buffer that is written to
+// the file when it is full or flushed, the text lines are passed on to
+// another output as they are printed
+struct BinaryOutput : public Output
+{
+    BinaryOutput(std::FILE* file, Output* text, std::size_t flush_size = 1024 * 1024);
+    ~BinaryOutput() override;
+
+    void
+    PrintInfo(std::string_view str) override;
+
+    void
+    PrintError(std::string_view str) override;
+
+    void
+    PrintRecords(std::string_view records) override;
+
+    // false if a write has failed, the records after it are dropped
+    bool
+    Flush();
+
+private:
+    std::FILE* file;
+    Output* text;
+    std::size_t flush_size;
+    fmt::memory_buffer buffer;
+    bool failed = false;
+};
+
+
+#endif  // CALC_BINARYOUTPUT_H
@@ -0,0 +1,234 @@
+#ifndef CALC_BITS_H
+#define CALC_BITS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+
+// a unsigned integer that is wider than the builtin types, all bitwise
+// operations work on a whole 64 bit word at a time
+template <std::size_t N>
+struct Bits
+{
+    static_assert(N % 64 == 0, "bits are stored as whole 64 bit words");
+    static constexpr std::size_t WORD_COUNT = N / 64;
+
+    // least significant word first
+    std::array<std::uint64_t, WORD_COUNT> words = {};
+
+    constexpr Bits() = default;
+
+    constexpr explicit Bits(std::uint64_t low) : words{low} {}
+
+    constexpr Bits&
+    operator&=(const Bits& rhs)
+    {
+        for (std::size_t i = 0; i < WORD_COUNT; i += 1)
+        {
+            words[i] &= rhs.words[i];
+        }
+        return *this;
+    }
+
+    constexpr Bits&
+    operator|=(const Bits& rhs)
+    {
+        for (std::size_t i = 0; i < WORD_COUNT; i += 1)
+        {
+            words[i] |= rhs.words[i];
+        }
+        return *this;
+    }
+
+    constexpr Bits&
+    operator^=(const Bits& rhs)
+    {
+        for (std::size_t i = 0; i < WORD_COUNT; i += 1)
+        {
+            words[i] ^= rhs.words[i];
+        }
+        return *this;
+    }
+
+    // whole words move first and then the bits within them, shifting
+    // N or more bits clears every word
+    constexpr Bits&
+    operator<<=(std::size_t count)
+    {
+        const auto word_shift = count / 64;
+        const auto bit_shift = count % 64;
+        for (std::size_t dst = WORD_COUNT; dst > 0; dst -= 1)
+        {
+            std::uint64_t word = 0;
+            if (dst - 1 >= word_shift)
+            {
+                const auto src = dst - 1 - word_shift;
+                word = words[src] << bit_shift;
+                if (bit_shift != 0 && src > 0)
+                {
+                    word |= words[src - 1] >> (64 - bit_shift);
+                }
+            }
+            words[dst - 1] = word;
+        }
+        return *this;
+    }
+
+    constexpr Bits&
+    operator>>=(std::size_t count)
+    {
+        const auto word_shift = count / 64;
+        const auto bit_shift = count % 64;
+        for (std::size_t dst = 0; dst < WORD_COUNT; dst += 1)
+        {
+            std::uint64_t word = 0;
+            if (word_shift < WORD_COUNT - dst)
+            {
+                const auto src = dst + word_shift;
+                word = words[src] >> bit_shift;
+                if (bit_shift != 0 && src + 1 < WORD_COUNT)
+                {
+                    word |= words[src + 1] << (64 - bit_shift);
+                }
+            }
+            words[dst] = word;
+        }
+        return *this;
+    }
+
+    [[nodiscard]] constexpr Bits
+    operator~() const
+    {
+        Bits result;
+        for (std::size_t i = 0; i < WORD_COUNT; i += 1)
+        {
+            result.words[i] = ~words[i];
+        }
+        return result;
+    }
+
+    [[nodiscard]] constexpr bool
+    IsZero() const
+    {
+        for (const auto word: words)
+        {
+            if (word != 0)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    friend constexpr Bits
+    operator&(Bits lhs, const Bits& rhs)
+    {
+        lhs &= rhs;
+        return lhs;
+    }
+
+    friend constexpr Bits
+    operator|(Bits lhs, const Bits& rhs)
+    {
+        lhs |= rhs;
+        return lhs;
+    }
+
+    friend constexpr Bits
+    operator^(Bits lhs, const Bits& rhs)
+    {
+        lhs ^= rhs;
+        return lhs;
+    }
+
+    friend constexpr Bits
+    operator<<(Bits lhs, std::size_t count)
+    {
+        lhs <<= count;
+        return lhs;
+    }
+
+    friend constexpr Bits
+    operator>>(Bits lhs, std::size_t count)
+    {
+        lhs >>= count;
+        return lhs;
+    }
+
+    friend constexpr bool
+    operator==(const Bits& lhs, const Bits& rhs)
+    {
+        for (std::size_t i = 0; i < WORD_COUNT; i += 1)
+        {
+            if (lhs.words[i] != rhs.words[i])
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    friend constexpr bool
+    operator!=(const Bits& lhs, const Bits& rhs)
+    {
+        return !(lhs == rhs);
+    }
+};
+
+
+// value = value * factor + add, false if the result doesn't fit
+template <std::size_t N>
+constexpr bool
+MulAdd(Bits<N>* value, std::uint32_t factor, std::uint32_t add)
+{
+    // 32 bit halves so the products never overflow
+    std::uint64_t carry = add;
+    for (auto& word: value->words)
+    {
+        const std::uint64_t low = (word & 0xffffffff) * factor + carry;
+        const std::uint64_t high = (word >> 32) * factor + (low >> 32);
+        word = (low & 0xffffffff) | (high << 32);
+        carry = high >> 32;
+    }
+    return carry == 0;
+}
+
+
+// the number of bits to shift by, saturated at N since every amount from
+// there on shifts out all bits
+template <std::size_t N>
+constexpr std::size_t
+ShiftAmount(const Bits<N>& amount)
+{
+    for (std::size_t i = 1; i < Bits<N>::WORD_COUNT; i += 1)
+    {
+        if (amount.words[i] != 0)
+        {
+            return N;
+        }
+    }
+    return amount.words[0] < N ? static_cast<std::size_t>(amount.words[0]) : N;
+}
+
+
+// value = value / divisor, returns the remainder
+template <std::size_t N>
+constexpr std::uint32_t
+DivMod(Bits<N>* value, std::uint32_t divisor)
+{
+    std::uint64_t remainder = 0;
+    for (std::size_t i = Bits<N>::WORD_COUNT; i > 0; i -= 1)
+    {
+        auto& word = value->words[i - 1];
+        const std::uint64_t high = (remainder << 32) | (word >> 32);
+        remainder = high % divisor;
+        const std::uint64_t low = (remainder << 32) | (word & 0xffffffff);
+        remainder = low % divisor;
+        word = ((high / divisor) << 32) | (low / divisor);
+    }
+    return static_cast<std::uint32_t>(remainder);
+}
+
+
+#endif  // CALC_BITS_H
@@ -0,0 +1,82 @@
+#include "calc/bufferedoutput.h"
+
+#include <cerrno>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+
+// retries partial and interrupted writes, other errors drop the output
+void
+WriteAll(int fd, const char* data, std::size_t size)
+{
+    while (size > 0)
+    {
+#if defined(_WIN32)
+        const auto written = _write(fd, data, static_cast<unsigned int>(size));
+#else
+        const auto written = ::write(fd, data, size);
+#endif
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return;
+        }
+        data += written;
+        size -= static_cast<std::size_t>(written);
+    }
+}
+
+
+BufferedOutput::BufferedOutput(int info, int error, std::size_t size)
+    : info_fd(info)
+    , error_fd(error)
+    , flush_size(size)
+{
+    buffer.reserve(flush_size);
+}
+
+
+BufferedOutput::~BufferedOutput()
+{
+    Flush();
+}
+
+
+void
+BufferedOutput::PrintInfo(std::string_view str)
+{
+    buffer.append(str);
+    buffer.push_back('\n');
+    if (buffer.size() >= flush_size)
+    {
+        Flush();
+    }
+}
+
+
+void
+BufferedOutput::PrintError(std::string_view str)
+{
+    Flush();
+
+    // the line and the line ending in one write
+    buffer.append(str);
+    buffer.push_back('\n');
+    WriteAll(error_fd, buffer.data(), buffer.size());
+    buffer.clear();
+}
+
+
+void
+BufferedOutput::Flush()
+{
+    WriteAll(info_fd, buffer.data(), buffer.size());
+    buffer.clear();
+}
@@ -0,0 +1,37 @@
+#ifndef CALC_BUFFEREDOUTPUT_H
+#define CALC_BUFFEREDOUTPUT_H
+
+#include <cstddef>
+#include <string_view>
+
+#include <fmt/format.h>
+
+#include "calc/output.h"
+
+
+// collects info lines in a large buffer that is written with a single
+// write(2) when it is full or flushed, errors are written right away
+// after the pending info lines so the order is kept on a terminal
+struct BufferedOutput : public Output
+{
+    BufferedOutput(int info_fd, int error_fd, std::size_t flush_size = 64 * 1024);
+    ~BufferedOutput() override;
+
+    void
+    PrintInfo(std::string_view str) override;
+
+    void
+    PrintError(std::string_view str) override;
+
+    void
+    Flush();
+
+private:
+    int info_fd;
+    int error_fd;
+    std::size_t flush_size;
+    fmt::memory_buffer buffer;
+};
+
+
+#endif  // CALC_BUFFEREDOUTPUT_H
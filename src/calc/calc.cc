@@ -1,23 +1,44 @@
 #include "calc/calc.h"
 
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <iterator>
+#include <limits>
 #include <string>
 #include <sstream>
 #include <utility>
 #include <vector>
 #include <cassert>
+#include <chrono>
 #include <memory>
+#include <optional>
 #include <array>
 #include <string_view>
 
-#include <fmt/core.h>
+#include <fmt/format.h>
 
 #include "calc/errorhandler.h"
+#include "calc/binaryoutput.h"
+#include "calc/records.h"
 #include "calc/token.h"
 #include "calc/input.h"
 #include "calc/lexer.h"
 #include "calc/ast.h"
+#include "calc/bdd.h"
 #include "calc/parser.h"
-#include "calc/binary.h"
+#include "calc/value.h"
+#include "calc/compiler.h"
+#include "calc/optimizer.h"
+#include "calc/vm.h"
+#include "calc/linereader.h"
+#include "calc/threadpool.h"
+#include "calc/truthtable.h"
+#include "calc/ints.h"
+#include "calc/program.h"
+#include "calc/programcache.h"
+#include "calc/server.h"
+#include "calc/stats.h"
 
 
 bool
@@ -39,78 +60,1495 @@ IsCommandLine(char c)
 }
 
 
+// returns the number of bytes printed
+template <typename V>
+std::size_t
+PrintNumber(Output* output, const V& n)
+{
+    // formatted on the stack, the output copies it if it needs to
+    fmt::memory_buffer line;
+    std::size_t printed = 0;
+    const auto print = [&]() {
+        output->PrintInfo({line.data(), line.size()});
+        printed += line.size();
+        line.clear();
+    };
+
+    line.append(std::string_view{"dec: "});
+    AppendDecimal(&line, n);
+    print();
+    line.append(std::string_view{"hex: 0x"});
+    AppendHex(&line, n);
+    print();
+    line.append(std::string_view{"bin: "});
+    AppendBinary(&line, n);
+    print();
+    return printed;
+}
+
+
+// returns the number of bytes printed
+template <typename V>
+std::size_t
+PrintRecord(Output* output, const V& n, bool has_status)
+{
+    RecordBuffer buffer;
+    const auto record = FormatRecord(n, has_status, &buffer);
+    output->PrintRecords(record);
+    return record.size();
+}
+
+
+enum
+{
+    MainCmdErr = -1,
+    MainLexErr = -2,
+    MainEmptyLex = -3,
+    MainParserErr = -4,
+    MainUnboundErr = -5,
+    MainIoErr = -6,
+    MainRemoteErr = -7,
+    MainOk = 0,
+    MainUsage = 0,
+    MainNotEquivalent = 1
+};
+
+
+struct Options
+{
+    bool optimize = true;
+
+    // read expressions from a file, - is stdin
+    bool stream = false;
+    std::string stream_path = "-";
+
+    // number of threads that evaluate the stream
+    std::size_t jobs = 1;
+
+    // the number of bits in a value
+    std::size_t width = 32;
+
+    // print the truth table instead of the value
+    bool truth_table = false;
+
+    // compare two expressions or print smaller ones, with the boolean
+    // values of a truth table
+    bool equiv = false;
+    bool minimize = false;
+
+    // the number of compiled expressions to keep, 0 compiles every time
+    std::size_t cache_size = 0;
+
+    // write the results as records to the binary path instead of as text,
+    // - is stdout, with a status byte before the value if status is set
+    bool binary = false;
+    std::string binary_path;
+    bool status = false;
+
+    // answer the lines of clients on the unix socket at the serve path, or
+    // send the expressions to the server at the client path
+    bool serve = false;
+    std::string serve_path;
+    bool client = false;
+    std::string client_path;
+
+    // the number of lines with errors a stream prints, the rest are counted
+    std::size_t max_errors = std::numeric_limits<std::size_t>::max();
+
+    // print a summary of the phases after the results
+    bool print_stats = false;
+
+    // time the phases, set by --stats or a stats callback
+    bool collect_stats = false;
+};
+
+
+// evaluates one expression after another, reusing the memory between them
+template <typename V>
+struct Evaluator
+{
+    Options options;
+
+    ErrorHandler errors;
+    AstArena arena;
+    std::vector<Token<V>> tokens;
+    Program<V> program;
+
+    // optional and shared with other evaluators
+    ProgramCache<V>* cache;
+    std::shared_ptr<const Program<V>> cached;
+
+    // either the program or the cached one
+    const Program<V>* compiled = &program;
+
+    // the counters are always updated, the phases only timed if collected
+    Stats stats;
+    bool timed = false;
+    std::chrono::steady_clock::time_point lap;
+
+    explicit Evaluator(const Options& o, ProgramCache<V>* c = nullptr)
+        : options(o)
+        , cache(c)
+    {
+    }
+
+    void
+    Count(std::uint64_t Stats::*counter, std::size_t count)
+    {
+        if constexpr (STATS_ENABLED)
+        {
+            stats.*counter += count;
+        }
+    }
+
+    void
+    BeginExpression(std::string_view source)
+    {
+        if constexpr (STATS_ENABLED)
+        {
+            stats.expressions += 1;
+            stats.bytes_in += source.size();
+            timed = options.collect_stats && IsTimedExpression(stats.expressions);
+            if (timed)
+            {
+                stats.timed_expressions += 1;
+                lap = std::chrono::steady_clock::now();
+            }
+        }
+    }
+
+    // the time since the previous phase ended is added to this phase
+    void
+    EndPhase(Phase phase)
+    {
+        if constexpr (STATS_ENABLED)
+        {
+            if (timed)
+            {
+                const auto now = std::chrono::steady_clock::now();
+                const auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(now - lap);
+                stats.nanoseconds[static_cast<std::size_t>(phase)] += static_cast<std::uint64_t>(duration.count());
+                lap = now;
+            }
+        }
+    }
+
+    // the optimized tree of the source, valid until the next source,
+    // errors are left in the error handler
+    int
+    Parse(std::string_view source, Node<V>** parsed)
+    {
+        arena.Reset();
+
+        RunLexer(source, &errors, &tokens);
+        EndPhase(Phase::LEX);
+        Count(&Stats::tokens, tokens.size());
+
+        if (errors.HasErr())
+        {
+            return MainLexErr;
+        }
+
+        if (tokens.empty())
+        {
+            errors.Err(ErrorCode::EMPTY_STATEMENT, source.substr(source.size()));
+            return MainEmptyLex;
+        }
+
+        auto* root = RunParser(tokens, &errors, &arena);
+        EndPhase(Phase::PARSE);
+        Count(&Stats::nodes, arena.ObjectCount());
+
+        if (errors.HasErr())
+        {
+            return MainParserErr;
+        }
+
+        if (options.optimize)
+        {
+            // the boolean modes read the lowest bit and fold shifts like
+            // the truth table and the diagrams do
+            const auto boolean = options.truth_table || options.equiv || options.minimize;
+            root = RunOptimizer(root, &arena, boolean);
+            EndPhase(Phase::OPTIMIZE);
+        }
+        Count(&Stats::arena_bytes, arena.BytesUsed());
+        *parsed = root;
+        return MainOk;
+    }
+
+    // compiles to the compiled program, errors are left in the error handler
+    int
+    Compile(std::string_view source)
+    {
+        errors.Clear();
+        BeginExpression(source);
+
+        if (cache != nullptr)
+        {
+            cached = cache->Find(source, options.optimize);
+            if (cached != nullptr)
+            {
+                compiled = cached.get();
+                Count(&Stats::cache_hits, 1);
+                EndPhase(Phase::COMPILE);
+                return MainOk;
+            }
+        }
+
+        Node<V>* root = nullptr;
+        const auto result = Parse(source, &root);
+        if (result != MainOk)
+        {
+            return result;
+        }
+
+        CompileProgram(*root, &program);
+        compiled = &program;
+
+        if (cache != nullptr)
+        {
+            cached = cache->Insert(source, options.optimize, program);
+        }
+        EndPhase(Phase::COMPILE);
+        return MainOk;
+    }
+
+    // the variable as it's written in the source so the error can point
+    // to it, only used for errors so relexing a cached source is fine
+    std::string_view
+    FindVariable(std::string_view source, std::string_view name)
+    {
+        RunLexer(source, &errors, &tokens);
+        for (const auto& token: tokens)
+        {
+            if (token.type == Token<V>::VARIABLE && token.name == name)
+            {
+                return token.name;
+            }
+        }
+        return name;
+    }
+
+    // prints the result, errors are left in the error handler
+    int
+    Run(std::string_view source, Output* output)
+    {
+        const auto result = Compile(source);
+        if (result != MainOk)
+        {
+            return result;
+        }
+
+        if (!compiled->variables.empty())
+        {
+            errors.Err(ErrorCode::MISSING_VALUE, FindVariable(source, compiled->variables[0]));
+            return MainUnboundErr;
+        }
+
+        const auto value = RunProgram(*compiled, {});
+        EndPhase(Phase::EVAL);
+        const auto printed = options.binary ? PrintRecord(output, value, options.status)
+                                            : PrintNumber(output, value);
+        Count(&Stats::bytes_out, printed);
+        EndPhase(Phase::OUTPUT);
+        return MainOk;
+    }
+
+    // with a status a source without a value still has a record, so the
+    // records line up with the sources
+    void
+    PrintErrorRecord(Output* output)
+    {
+        if (options.binary && options.status && !errors.errors.empty())
+        {
+            RecordBuffer buffer;
+            const auto record = FormatErrorRecord<V>(errors.errors[0].code, &buffer);
+            output->PrintRecords(record);
+            Count(&Stats::bytes_out, record.size());
+        }
+    }
+};
+
+
+template <typename V>
+void
+PrintArgumentErrors(Evaluator<V>* evaluator, int result, Output* output)
+{
+    switch (result)
+    {
+    case MainOk: break;
+    case MainLexErr:
+    case MainParserErr: evaluator->errors.PrintErrors(output); break;
+    default:
+        for (const auto& error: evaluator->errors.errors)
+        {
+            output->PrintError(error.ToString());
+        }
+        break;
+    }
+}
+
+
+template <typename V>
+int
+RunArgument(Evaluator<V>* evaluator, const std::string& source, Output* output)
+{
+    const auto result = evaluator->Run(source, output);
+    if (result != MainOk)
+    {
+        evaluator->PrintErrorRecord(output);
+    }
+    PrintArgumentErrors(evaluator, result, output);
+    return result;
+}
+
+
+int
+RunTruthTable(Evaluator<std::uint64_t>* evaluator, const std::string& source, Output* output)
+{
+    const auto result = evaluator->Compile(source);
+    if (result != MainOk)
+    {
+        PrintArgumentErrors(evaluator, result, output);
+        return result;
+    }
+
+    const auto& variables = evaluator->compiled->variables;
+    if (variables.size() > MAX_TRUTH_TABLE_VARIABLES)
+    {
+        output->PrintError(fmt::format(
+                "Too many variables for a truth table: {} (max {})",
+                variables.size(),
+                MAX_TRUTH_TABLE_VARIABLES));
+        return MainCmdErr;
+    }
+
+    const auto table = TruthTable{*evaluator->compiled};
+    evaluator->EndPhase(Phase::EVAL);
+
+    // the rows are evaluated 64 at a time as they are printed, which costs
+    // less than printing a single row, so all of it is output
+    table.Print(output);
+    evaluator->EndPhase(Phase::OUTPUT);
+    return MainOk;
+}
+
+
+// the expressions as functions of one diagram manager, stops at the first
+// expression with errors
+int
+BuildFunctions(
+        Evaluator<std::uint64_t>* evaluator,
+        const std::vector<std::string>& expressions,
+        BddManager* manager,
+        std::vector<Bdd>* functions,
+        Output* output)
+{
+    for (const auto& expression: expressions)
+    {
+        evaluator->errors.Clear();
+        evaluator->BeginExpression(expression);
+        Node<std::uint64_t>* root = nullptr;
+        const auto result = evaluator->Parse(expression, &root);
+        if (result != MainOk)
+        {
+            PrintArgumentErrors(evaluator, result, output);
+            return result;
+        }
+        functions->emplace_back(manager->FromTree(*root));
+        evaluator->EndPhase(Phase::COMPILE);
+    }
+    return MainOk;
+}
+
+
+// the variables for which the expressions differ if they aren't equivalent
+int
+RunEquivalence(Evaluator<std::uint64_t>* evaluator, const std::vector<std::string>& expressions, Output* output)
+{
+    BddManager manager;
+    manager.SetAutoReorder(true);
+    std::vector<Bdd> functions;
+    const auto result = BuildFunctions(evaluator, expressions, &manager, &functions, output);
+    if (result != MainOk)
+    {
+        return result;
+    }
+
+    if (functions[0] == functions[1])
+    {
+        evaluator->EndPhase(Phase::EVAL);
+        output->PrintInfo("equivalent");
+        evaluator->EndPhase(Phase::OUTPUT);
+        return MainOk;
+    }
+
+    BddAssignment assignment;
+    manager.FindSatisfying(manager.Xor(functions[0], functions[1]), &assignment);
+    evaluator->EndPhase(Phase::EVAL);
+    std::string line = "not equivalent";
+    if (!assignment.empty())
+    {
+        line += " for";
+        for (const auto& [name, value]: assignment)
+        {
+            line += fmt::format(" {}={}", name, value ? 1 : 0);
+        }
+    }
+    output->PrintInfo(line);
+    evaluator->EndPhase(Phase::OUTPUT);
+    return MainNotEquivalent;
+}
+
+
+// the expression made from the reordered diagram when it's shorter than the
+// source, else the source
+int
+RunMinimize(Evaluator<std::uint64_t>* evaluator, const std::string& source, Output* output)
+{
+    BddManager manager;
+    manager.SetAutoReorder(true);
+    std::vector<Bdd> functions;
+    const auto result = BuildFunctions(evaluator, {source}, &manager, &functions, output);
+    if (result != MainOk)
+    {
+        return result;
+    }
+    manager.Reorder();
+
+    std::string minimized;
+    const auto shorter = manager.ToExpression(functions[0], evaluator->tokens.size() - 1, &minimized);
+    evaluator->EndPhase(Phase::EVAL);
+    if (shorter)
+    {
+        output->PrintInfo(minimized);
+    }
+    else
+    {
+        output->PrintInfo(source);
+    }
+    evaluator->EndPhase(Phase::OUTPUT);
+    return MainOk;
+}
+
+
+void
+PrintLineErrors(
+        Output* output,
+        std::size_t line_number,
+        std::string_view line,
+        const Error* errors,
+        std::size_t count)
+{
+    PrintErrors(output, fmt::format("Error on line {}: {}", line_number, line), errors, count);
+}
+
+
+// errors are reported with the line but doesn't stop the stream, when not
+// printed they are left in the error handler
+template <typename V>
+int
+RunLine(Evaluator<V>* evaluator, std::string_view line, std::size_t line_number, Output* output, bool print_errors)
+{
+    const auto result = evaluator->Run(line, output);
+    if (result != MainOk)
+    {
+        evaluator->PrintErrorRecord(output);
+    }
+    if (result == MainOk || result == MainEmptyLex)
+    {
+        // blank lines are allowed in files
+        return MainOk;
+    }
+
+    if (print_errors)
+    {
+        const auto& errors = evaluator->errors.errors;
+        PrintLineErrors(output, line_number, line, errors.data(), errors.size());
+    }
+    return result;
+}
+
+
 void
-PrintNumber(Output* output, int n)
+PrintHiddenErrors(const Options& options, std::size_t error_count, Output* output)
+{
+    if (error_count > options.max_errors)
+    {
+        output->PrintError(fmt::format("{} more lines with errors", error_count - options.max_errors));
+    }
+}
+
+
+// the result is the first error, if any
+template <typename V>
+int
+RunStream(
+        const Options& options,
+        ProgramCache<V>* cache,
+        std::FILE* file,
+        Output* output,
+        Stats* stats)
+{
+    auto evaluator = Evaluator<V>{options, cache};
+    auto reader = LineReader{file};
+    int result = MainOk;
+    std::size_t line_number = 0;
+    std::size_t error_count = 0;
+
+    std::string_view line;
+    while (reader.Next(&line))
+    {
+        line_number += 1;
+        const auto print_errors = error_count < options.max_errors;
+        const auto line_result = RunLine(&evaluator, line, line_number, output, print_errors);
+        if (line_result != MainOk)
+        {
+            error_count += 1;
+        }
+        if (result == MainOk)
+        {
+            result = line_result;
+        }
+        reader.Release();
+    }
+
+    PrintHiddenErrors(options, error_count, output);
+    stats->Add(evaluator.stats);
+    return result;
+}
+
+
+// keeps what a chunk printed so the chunks can be printed in order, all
+// lines share one buffer that keeps its memory when cleared
+struct RecordedOutput : public Output
+{
+    enum class LineKind : std::uint8_t
+    {
+        INFO,
+        ERROR,
+        RECORDS
+    };
+
+    struct Line
+    {
+        LineKind kind;
+        std::size_t end;
+    };
+
+    // the errors of a line, formatted when they are replayed
+    struct LineErrors
+    {
+        // the number of lines printed before them
+        std::size_t position;
+        std::size_t line_number;
+        std::string_view line;
+        std::size_t first;
+        std::size_t count;
+    };
+
+    fmt::memory_buffer text;
+    std::vector<Line> lines;
+    std::vector<Error> errors;
+    std::vector<LineErrors> line_errors;
+
+    // the lines with errors, also those that weren't kept
+    std::size_t error_count = 0;
+
+    void
+    PrintInfo(std::string_view str) override
+    {
+        text.append(str);
+        lines.emplace_back(Line{LineKind::INFO, text.size()});
+    }
+
+    void
+    PrintError(std::string_view str) override
+    {
+        text.append(str);
+        lines.emplace_back(Line{LineKind::ERROR, text.size()});
+    }
+
+    // records that follow each other are replayed with one call, unless
+    // errors are printed between them
+    void
+    PrintRecords(std::string_view records) override
+    {
+        text.append(records);
+        const auto extends_last = !lines.empty() && lines.back().kind == LineKind::RECORDS
+                                  && (line_errors.empty() || line_errors.back().position < lines.size());
+        if (extends_last)
+        {
+            lines.back().end = text.size();
+        }
+        else
+        {
+            lines.emplace_back(Line{LineKind::RECORDS, text.size()});
+        }
+    }
+
+    // the line and errors must stay valid until replayed
+    void
+    AddErrors(std::size_t line_number, std::string_view line, const std::vector<Error>& line_error)
+    {
+        line_errors.emplace_back(LineErrors{lines.size(), line_number, line, errors.size(), line_error.size()});
+        errors.insert(errors.end(), line_error.begin(), line_error.end());
+    }
+
+    void
+    Clear()
+    {
+        text.clear();
+        lines.clear();
+        errors.clear();
+        line_errors.clear();
+        error_count = 0;
+    }
+
+    // prints the errors until the position, as long as errors are left
+    void
+    ReplayErrors(Output* output, std::size_t position, std::size_t* next, std::size_t* errors_left) const
+    {
+        while (*next < line_errors.size() && line_errors[*next].position == position)
+        {
+            const auto& line_error = line_errors[*next];
+            if (*errors_left > 0)
+            {
+                PrintLineErrors(
+                        output,
+                        line_error.line_number,
+                        line_error.line,
+                        errors.data() + line_error.first,
+                        line_error.count);
+                *errors_left -= 1;
+            }
+            *next += 1;
+        }
+    }
+
+    void
+    Replay(Output* output, std::size_t* errors_left) const
+    {
+        std::size_t start = 0;
+        std::size_t next_error = 0;
+        for (std::size_t index = 0; index < lines.size(); index += 1)
+        {
+            ReplayErrors(output, index, &next_error, errors_left);
+            const auto& line = lines[index];
+            const auto str = std::string_view{text.data() + start, line.end - start};
+            switch (line.kind)
+            {
+            case LineKind::INFO: output->PrintInfo(str); break;
+            case LineKind::ERROR: output->PrintError(str); break;
+            case LineKind::RECORDS: output->PrintRecords(str); break;
+            }
+            start = line.end;
+        }
+        ReplayErrors(output, lines.size(), &next_error, errors_left);
+    }
+};
+
+
+constexpr std::size_t LINES_PER_CHUNK = 1024;
+constexpr std::size_t CHUNKS_PER_JOB = 8;
+
+
+// the lines are read a window at a time and each window is split into
+// chunks for the workers, once all chunks are done they are printed in
+// order and the next window is read, so memory use doesn't depend on the
+// size of the file
+template <typename V>
+int
+RunParallelStream(
+        const Options& options,
+        ProgramCache<V>* cache,
+        std::FILE* file,
+        Output* output,
+        Stats* stats)
+{
+    auto pool = ThreadPool{options.jobs};
+
+    // one evaluator for each worker, only the cache is shared
+    std::vector<std::unique_ptr<Evaluator<V>>> evaluators;
+    for (std::size_t worker = 0; worker < pool.Size(); worker += 1)
+    {
+        evaluators.emplace_back(std::make_unique<Evaluator<V>>(options, cache));
+    }
+
+    const auto max_chunks = pool.Size() * CHUNKS_PER_JOB;
+    const auto max_lines = max_chunks * LINES_PER_CHUNK;
+    std::vector<RecordedOutput> outputs(max_chunks);
+    std::vector<int> results(max_chunks);
+
+    // the lines of a window, a mapped file is used in place while the lines
+    // of other files are copied as they are only valid until the next line
+    std::vector<std::string_view> lines;
+    std::string text;
+    std::vector<std::size_t> line_ends;
+
+    auto reader = LineReader{file};
+    int result = MainOk;
+    std::size_t lines_before = 0;
+    bool has_more = true;
+    std::size_t errors_left = options.max_errors;
+    std::size_t error_count = 0;
+
+    while (has_more)
+    {
+        lines.clear();
+        text.clear();
+        line_ends.clear();
+
+        std::string_view line;
+        while (lines.size() < max_lines)
+        {
+            has_more = reader.Next(&line);
+            if (!has_more)
+            {
+                break;
+            }
+            if (reader.IsMapped())
+            {
+                lines.emplace_back(line);
+            }
+            else
+            {
+                text += line;
+                line_ends.emplace_back(text.size());
+                lines.emplace_back();
+            }
+        }
+
+        // the copies can be viewed once the text stops growing
+        for (std::size_t index = 0; index < line_ends.size(); index += 1)
+        {
+            const auto begin = index == 0 ? 0 : line_ends[index - 1];
+            lines[index] = std::string_view{text}.substr(begin, line_ends[index] - begin);
+        }
+
+        const auto chunk_count = (lines.size() + LINES_PER_CHUNK - 1) / LINES_PER_CHUNK;
+        pool.Run(chunk_count, [&](std::size_t chunk, std::size_t worker) {
+            auto* evaluator = evaluators[worker].get();
+            auto* chunk_output = &outputs[chunk];
+            chunk_output->Clear();
+            results[chunk] = MainOk;
+
+            const auto first = chunk * LINES_PER_CHUNK;
+            const auto last = std::min(first + LINES_PER_CHUNK, lines.size());
+            for (auto index = first; index < last; index += 1)
+            {
+                const auto source = lines[index];
+                const auto line_number = lines_before + index + 1;
+                const auto line_result = RunLine(evaluator, source, line_number, chunk_output, false);
+                if (line_result != MainOk)
+                {
+                    // no chunk prints more than the stream may
+                    if (chunk_output->error_count < options.max_errors)
+                    {
+                        chunk_output->AddErrors(line_number, source, evaluator->errors.errors);
+                    }
+                    chunk_output->error_count += 1;
+                }
+                if (results[chunk] == MainOk)
+                {
+                    results[chunk] = line_result;
+                }
+            }
+        });
+
+        for (std::size_t chunk = 0; chunk < chunk_count; chunk += 1)
+        {
+            outputs[chunk].Replay(output, &errors_left);
+            error_count += outputs[chunk].error_count;
+            if (result == MainOk)
+            {
+                result = results[chunk];
+            }
+        }
+
+        lines_before += lines.size();
+        reader.Release();
+    }
+
+    PrintHiddenErrors(options, error_count, output);
+
+    // each worker counted on its own
+    for (const auto& evaluator: evaluators)
+    {
+        stats->Add(evaluator->stats);
+    }
+    return result;
+}
+
+
+template <typename V>
+int
+RunStream(const Options& options, ProgramCache<V>* cache, Output* output, Stats* stats)
 {
-    output->PrintInfo(fmt::format("dec: {}", n));
-    output->PrintInfo(fmt::format("hex: 0x{:x}", n));
-    output->PrintInfo(fmt::format("bin: {}", ToBinaryString(n)));
+    const auto run = [&](std::FILE* file) {
+        return options.jobs > 1 ? RunParallelStream<V>(options, cache, file, output, stats)
+                                : RunStream<V>(options, cache, file, output, stats);
+    };
+
+    if (options.stream_path == "-")
+    {
+        return run(stdin);
+    }
+
+    std::FILE* file = std::fopen(options.stream_path.c_str(), "rb");
+    if (file == nullptr)
+    {
+        output->PrintError(fmt::format("Unable to open {}", options.stream_path));
+        return MainIoErr;
+    }
+    const auto result = run(file);
+    std::fclose(file);
+    return result;
 }
 
 
-enum
+// the cache of a server when no size is given, the point of a server is
+// that the programs stay compiled
+constexpr std::size_t SERVER_CACHE_SIZE = 4096;
+
+// the lines of a reply that are errors start with this, a empty line ends
+// the reply
+constexpr std::string_view REPLY_ERROR_PREFIX = "! ";
+
+
+// writes what is printed for a line to the reply of the client
+struct ReplyOutput : public Output
 {
-    MainCmdErr = -1,
-    MainLexErr = -2,
-    MainEmptyLex = -3,
-    MainParserErr = -4,
-    MainOk = 0,
-    MainUsage = 0
+    std::string* reply = nullptr;
+
+    void
+    PrintInfo(std::string_view str) override
+    {
+        reply->append(str);
+        reply->push_back('\n');
+    }
+
+    void
+    PrintError(std::string_view str) override
+    {
+        reply->append(REPLY_ERROR_PREFIX);
+        reply->append(str);
+        reply->push_back('\n');
+    }
 };
 
 
+// the lines of all clients are run like the lines of a stream, with the
+// line numbers of the client
+template <typename V>
 int
-RunCalcApp(
-        const std::string& appname,
-        const std::vector<std::string>& arguments,
-        Output* output)
+RunServer(const Options& options, ProgramCache<V>* cache, Output* output, Stats* stats)
 {
-    for (const auto& arg: arguments)
+    auto evaluator = Evaluator<V>{options, cache};
+    auto reply_output = ReplyOutput{};
+    auto server = Server{[&](std::size_t line_number, std::string_view line, std::string* reply) {
+        reply_output.reply = reply;
+        RunLine(&evaluator, line, line_number, &reply_output, true);
+        reply->push_back('\n');
+    }};
+
+    std::string error;
+    const auto served = server.Listen(options.serve_path, &error) && server.StopOnSignals(&error)
+                     && server.Run(&error);
+    stats->Add(evaluator.stats);
+    if (!served)
     {
-        if (IsCommandLine(arg[0]))
+        output->PrintError(error);
+        return MainIoErr;
+    }
+    return MainOk;
+}
+
+
+// prints the replies like the server had printed them
+int
+RunClient(const Options& options, const std::vector<std::string>& expressions, Output* output)
+{
+    std::FILE* file = nullptr;
+    if (options.stream)
+    {
+        file = options.stream_path == "-" ? stdin : std::fopen(options.stream_path.c_str(), "rb");
+        if (file == nullptr)
+        {
+            output->PrintError(fmt::format("Unable to open {}", options.stream_path));
+            return MainIoErr;
+        }
+    }
+
+    std::optional<LineReader> reader;
+    if (file != nullptr)
+    {
+        reader.emplace(file);
+    }
+    std::size_t next_expression = 0;
+    const auto next_line = [&](std::string_view* line) {
+        if (reader)
+        {
+            // the line is copied before the next one is read
+            reader->Release();
+            return reader->Next(line);
+        }
+        if (next_expression == expressions.size())
         {
-            output->PrintError(fmt::format("Invalid commandline argument {}", arg));
-            return MainCmdErr;
+            return false;
+        }
+        *line = expressions[next_expression];
+        next_expression += 1;
+        return true;
+    };
+
+    int result = MainOk;
+    const auto on_reply = [&](std::string_view line) {
+        if (line.empty())
+        {
+            return;
+        }
+        if (line.substr(0, REPLY_ERROR_PREFIX.size()) == REPLY_ERROR_PREFIX)
+        {
+            output->PrintError(line.substr(REPLY_ERROR_PREFIX.size()));
+            result = MainRemoteErr;
         }
         else
         {
-            ErrorHandler errors;
+            output->PrintInfo(line);
+        }
+    };
+
+    std::string error;
+    if (!SendRequests(options.client_path, next_line, on_reply, &error))
+    {
+        output->PrintError(error);
+        result = MainIoErr;
+    }
+
+    reader.reset();
+    if (file != nullptr && file != stdin)
+    {
+        std::fclose(file);
+    }
+    return result;
+}
+
+
+template <typename V>
+int
+RunWithWidth(
+        const Options& options,
+        const std::vector<std::string>& expressions,
+        Output* output,
+        Stats* stats)
+{
+    auto cache = ProgramCache<V>{options.cache_size};
+    auto* used_cache = options.cache_size > 0 ? &cache : nullptr;
+
+    if (options.serve)
+    {
+        return RunServer<V>(options, &cache, output, stats);
+    }
+    if (options.stream)
+    {
+        return RunStream<V>(options, used_cache, output, stats);
+    }
+
+    auto evaluator = Evaluator<V>{options, used_cache};
+    int result = MainOk;
+
+    for (const auto& expression: expressions)
+    {
+        result = RunArgument(&evaluator, expression, output);
+        if (result != MainOk)
+        {
+            break;
+        }
+    }
+
+    stats->Add(evaluator.stats);
+    return result;
+}
 
-            const auto tokens = RunLexer(arg, &errors);
 
-            if (errors.HasErr())
+// the expressions or stream with the parsed options
+int
+RunExpressions(
+        const Options& options,
+        const std::vector<std::string>& expressions,
+        Output* output,
+        Stats* stats)
+{
+    if (options.truth_table)
+    {
+        // the values are only 0 or 1
+        auto evaluator = Evaluator<std::uint64_t>{options};
+        int result = MainOk;
+        for (const auto& expression: expressions)
+        {
+            result = RunTruthTable(&evaluator, expression, output);
+            if (result != MainOk)
             {
-                errors.PrintErrors(output);
-                return MainLexErr;
+                break;
             }
+        }
+        stats->Add(evaluator.stats);
+        return result;
+    }
 
-            if (tokens.empty())
+    if (options.equiv || options.minimize)
+    {
+        auto evaluator = Evaluator<std::uint64_t>{options};
+        int result = MainOk;
+        if (options.equiv)
+        {
+            result = RunEquivalence(&evaluator, expressions, output);
+        }
+        else
+        {
+            for (const auto& expression: expressions)
             {
-                output->PrintError("Empty statement");
-                return MainEmptyLex;
+                result = RunMinimize(&evaluator, expression, output);
+                if (result != MainOk)
+                {
+                    break;
+                }
             }
+        }
+        stats->Add(evaluator.stats);
+        return result;
+    }
+
+    switch (options.width)
+    {
+    case 8: return RunWithWidth<std::uint8_t>(options, expressions, output, stats);
+    case 16: return RunWithWidth<std::uint16_t>(options, expressions, output, stats);
+    case 32: return RunWithWidth<std::uint32_t>(options, expressions, output, stats);
+    case 64: return RunWithWidth<std::uint64_t>(options, expressions, output, stats);
+    case 128: return RunWithWidth<Bits<128>>(options, expressions, output, stats);
+    case 256: return RunWithWidth<Bits<256>>(options, expressions, output, stats);
+    case 512: return RunWithWidth<Bits<512>>(options, expressions, output, stats);
+    default:
+        output->PrintError(fmt::format("Invalid width: {}", options.width));
+        return MainCmdErr;
+    }
+}
 
-            auto root = RunParser(tokens, &errors);
 
-            if (errors.HasErr())
+// prints the text lines as errors, so when the records are written to
+// stdout no text ends up between them
+struct ErrorTextOutput : public Output
+{
+    Output* output = nullptr;
+
+    void
+    PrintInfo(std::string_view str) override
+    {
+        output->PrintError(str);
+    }
+
+    void
+    PrintError(std::string_view str) override
+    {
+        output->PrintError(str);
+    }
+};
+
+
+// the results are written to the binary path while the errors and the
+// other text still go to the output
+int
+RunBinary(
+        const Options& options,
+        const std::vector<std::string>& expressions,
+        Output* output,
+        Stats* stats)
+{
+    const auto to_stdout = options.binary_path == "-";
+    std::FILE* file = to_stdout ? stdout : std::fopen(options.binary_path.c_str(), "wb");
+    if (file == nullptr)
+    {
+        output->PrintError(fmt::format("Unable to open {}", options.binary_path));
+        return MainIoErr;
+    }
+
+    int result = MainOk;
+    {
+        auto binary_output = BinaryOutput{file, output};
+        result = RunExpressions(options, expressions, &binary_output, stats);
+        if (!binary_output.Flush())
+        {
+            output->PrintError(fmt::format("Unable to write {}", options.binary_path));
+            if (result == MainOk)
             {
-                errors.PrintErrors(output);
-                return MainParserErr;
+                result = MainIoErr;
             }
+        }
+    }
+
+    if (!to_stdout)
+    {
+        std::fclose(file);
+    }
+    return result;
+}
+
+
+// the server reads the expressions from its clients and the client only
+// sends them, so the options that change the output don't go with them
+bool
+CheckServerOptions(const Options& options, const std::vector<std::string>& expressions, Output* output)
+{
+    if (!options.serve && !options.client)
+    {
+        return true;
+    }
+
+    const auto* mode = options.serve ? "--serve" : "--client";
+    const auto fail = [output, mode](std::string_view other) {
+        output->PrintError(fmt::format("{} can't be used with {}", mode, other));
+        return false;
+    };
+    if (options.serve && options.client)
+    {
+        return fail("--client");
+    }
+    if (options.truth_table)
+    {
+        return fail("--truth-table");
+    }
+    if (options.binary)
+    {
+        return fail("--binary");
+    }
+    if (options.equiv)
+    {
+        return fail("--equiv");
+    }
+    if (options.minimize)
+    {
+        return fail("--minimize");
+    }
+    if (options.serve && options.stream)
+    {
+        return fail("--stream");
+    }
+    if (options.serve && options.jobs > 1)
+    {
+        return fail("--jobs");
+    }
+    if (options.serve && !expressions.empty())
+    {
+        output->PrintError("--serve reads the expressions from its clients");
+        return false;
+    }
+    return true;
+}
+
+
+// the diagram modes work on the expressions of the command line and print
+// expressions instead of values
+bool
+CheckBddOptions(const Options& options, const std::vector<std::string>& expressions, Output* output)
+{
+    if (!options.equiv && !options.minimize)
+    {
+        return true;
+    }
+
+    const auto* mode = options.equiv ? "--equiv" : "--minimize";
+    const auto fail = [output, mode](std::string_view other) {
+        output->PrintError(fmt::format("{} can't be used with {}", mode, other));
+        return false;
+    };
+    if (options.equiv && options.minimize)
+    {
+        return fail("--minimize");
+    }
+    if (options.truth_table)
+    {
+        return fail("--truth-table");
+    }
+    if (options.binary)
+    {
+        return fail("--binary");
+    }
+    if (options.stream)
+    {
+        return fail("--stream");
+    }
+    if (options.equiv && expressions.size() != 2)
+    {
+        output->PrintError("--equiv needs two expressions");
+        return false;
+    }
+    return true;
+}
+
+
+// the truth table is printed as text for the expressions of the command
+// line, checked before --binary opens its file
+bool
+CheckTruthTableOptions(const Options& options, Output* output)
+{
+    if (!options.truth_table)
+    {
+        return true;
+    }
+
+    const auto fail = [output](std::string_view other) {
+        output->PrintError(fmt::format("--truth-table can't be used with {}", other));
+        return false;
+    };
+    if (options.stream)
+    {
+        return fail("--stream");
+    }
+    if (options.binary)
+    {
+        return fail("--binary");
+    }
+    return true;
+}
+
+
+// printed after the usage, one line per option
+constexpr std::array USAGE_OPTIONS = {
+        std::string_view{"  --width N          8, 16, 32 (default), 64, 128, 256 or 512 bit values"},
+        std::string_view{"  --no-opt           evaluate the expressions exactly as written"},
+        std::string_view{"  --truth-table      print the result for every combination of 0 and 1"},
+        std::string_view{"  --equiv            check if two expressions are the same boolean function"},
+        std::string_view{"  --minimize         print each expression as a smaller one when found"},
+        std::string_view{"  --stream [file]    evaluate one expression per line, - or none is stdin"},
+        std::string_view{"  --jobs N           evaluate the lines of a stream on N threads"},
+        std::string_view{"  --cache N          keep the N most recently used compiled expressions"},
+        std::string_view{"  --max-errors N     print only the first N lines with errors"},
+        std::string_view{"  --binary file      write the results as little-endian records, - is stdout"},
+        std::string_view{"  --status           write a status byte before each record of --binary"},
+        std::string_view{"  --stats            print the counters and the time of each phase"},
+        std::string_view{"  --serve socket     answer the lines of clients on a unix socket"},
+        std::string_view{"  --client socket    send the expressions to a server and print the replies"}};
+
+
+// false if the string isn't a positive number
+bool
+ParseCount(const std::string& str, std::size_t* count)
+{
+    int value = 0;
+    const auto* end = str.data() + str.size();
+    const auto [ptr, ec] = std::from_chars(str.data(), end, value);
+    if (ec != std::errc{} || ptr != end || value < 1)
+    {
+        return false;
+    }
+    *count = ToSizet(value);
+    return true;
+}
+
+
+int
+RunCalcApp(
+        const std::string& appname,
+        const std::vector<std::string>& arguments,
+        Output* output)
+{
+    return RunCalcApp(appname, arguments, output, nullptr);
+}
+
+
+int
+RunCalcApp(
+        const std::string& appname,
+        const std::vector<std::string>& arguments,
+        Output* output,
+        const StatsCallback& on_stats)
+{
+    auto options = Options{};
+    std::vector<std::string> expressions;
 
-            PrintNumber(output, root->Calculate());
+    for (std::size_t index = 0; index < arguments.size(); index += 1)
+    {
+        const auto& arg = arguments[index];
+        if (IsCommandLine(arg[0]))
+        {
+            if (arg == "--no-opt")
+            {
+                options.optimize = false;
+            }
+            else if (arg == "--truth-table")
+            {
+                options.truth_table = true;
+            }
+            else if (arg == "--equiv")
+            {
+                options.equiv = true;
+            }
+            else if (arg == "--minimize")
+            {
+                options.minimize = true;
+            }
+            else if (arg == "--stream")
+            {
+                // the path is optional so a option after --stream reads
+                // stdin, a path that starts with - can be written ./-file
+                options.stream = true;
+                const auto has_path = index + 1 < arguments.size()
+                                      && (arguments[index + 1] == "-" || arguments[index + 1].rfind('-', 0) != 0);
+                if (has_path)
+                {
+                    index += 1;
+                    options.stream_path = arguments[index];
+                }
+            }
+            else if (arg == "--jobs")
+            {
+                const auto& jobs = index + 1 < arguments.size() ? arguments[index + 1] : "";
+                if (!ParseCount(jobs, &options.jobs))
+                {
+                    output->PrintError(fmt::format("Invalid number of jobs: {}", jobs));
+                    return MainCmdErr;
+                }
+                index += 1;
+            }
+            else if (arg == "--cache")
+            {
+                const auto& size = index + 1 < arguments.size() ? arguments[index + 1] : "";
+                if (!ParseCount(size, &options.cache_size))
+                {
+                    output->PrintError(fmt::format("Invalid cache size: {}", size));
+                    return MainCmdErr;
+                }
+                index += 1;
+            }
+            else if (arg == "--max-errors")
+            {
+                const auto& count = index + 1 < arguments.size() ? arguments[index + 1] : "";
+                if (!ParseCount(count, &options.max_errors))
+                {
+                    output->PrintError(fmt::format("Invalid number of errors: {}", count));
+                    return MainCmdErr;
+                }
+                index += 1;
+            }
+            else if (arg == "--binary")
+            {
+                if (index + 1 >= arguments.size())
+                {
+                    output->PrintError("--binary needs a file, - is stdout");
+                    return MainCmdErr;
+                }
+                index += 1;
+                options.binary = true;
+                options.binary_path = arguments[index];
+            }
+            else if (arg == "--serve" || arg == "--client")
+            {
+                if (index + 1 >= arguments.size())
+                {
+                    output->PrintError(fmt::format("{} needs a socket path", arg));
+                    return MainCmdErr;
+                }
+                if (!Server::IsSupported())
+                {
+                    output->PrintError(fmt::format("{} isn't supported by this build", arg));
+                    return MainCmdErr;
+                }
+                index += 1;
+                auto& enabled = arg == "--serve" ? options.serve : options.client;
+                auto& path = arg == "--serve" ? options.serve_path : options.client_path;
+                enabled = true;
+                path = arguments[index];
+            }
+            else if (arg == "--status")
+            {
+                options.status = true;
+            }
+            else if (arg == "--stats")
+            {
+                if (!STATS_ENABLED)
+                {
+                    output->PrintError("--stats isn't supported by this build");
+                    return MainCmdErr;
+                }
+                options.print_stats = true;
+            }
+            else if (arg == "--width")
+            {
+                const auto& width = index + 1 < arguments.size() ? arguments[index + 1] : "";
+                if (!ParseCount(width, &options.width))
+                {
+                    output->PrintError(fmt::format("Invalid width: {}", width));
+                    return MainCmdErr;
+                }
+                index += 1;
+            }
+            else
+            {
+                output->PrintError(fmt::format("Invalid commandline argument {}", arg));
+                return MainCmdErr;
+            }
+        }
+        else
+        {
+            expressions.emplace_back(arg);
         }
     }
 
-    if (arguments.empty())
+    if (!options.stream && !options.serve && expressions.empty())
     {
         output->PrintInfo(appname);
         output->PrintInfo(" - print truth table of expressions");
         output->PrintInfo(" - convert between binary and hexadecimal values");
         output->PrintInfo(" - evaluate boolean expressions");
+        output->PrintInfo("");
+        output->PrintInfo("options:");
+        for (const auto line: USAGE_OPTIONS)
+        {
+            output->PrintInfo(line);
+        }
         return MainUsage;
     }
 
-    return MainOk;
-}
+    if (options.status && !options.binary)
+    {
+        output->PrintError("--status can only be used with --binary");
+        return MainCmdErr;
+    }
+
+    if (!CheckServerOptions(options, expressions, output) || !CheckBddOptions(options, expressions, output)
+        || !CheckTruthTableOptions(options, output))
+    {
+        return MainCmdErr;
+    }
+    if (options.serve && options.cache_size == 0)
+    {
+        options.cache_size = SERVER_CACHE_SIZE;
+    }
+
+    options.collect_stats = STATS_ENABLED && (options.print_stats || on_stats != nullptr);
+
+    // the records of --binary - own stdout
+    auto error_text = ErrorTextOutput{};
+    error_text.output = output;
+    auto* text_output = options.binary && options.binary_path == "-" ? &error_text : output;
 
+    auto stats = Stats{};
+    const auto result = options.client   ? RunClient(options, expressions, output)
+                      : options.binary ? RunBinary(options, expressions, text_output, &stats)
+                                       : RunExpressions(options, expressions, output, &stats);
+
+    if (options.collect_stats)
+    {
+        if (options.print_stats)
+        {
+            PrintStats(text_output, stats);
+        }
+        if (on_stats != nullptr)
+        {
+            on_stats(stats);
+        }
+    }
+    return result;
+}
@@ -5,6 +5,7 @@
 #include <string>
 
 #include "calc/output.h"
+#include "calc/stats.h"
 
 int
 RunCalcApp(
@@ -12,4 +13,13 @@ RunCalcApp(
         const std::vector<std::string>& argument,
         Output* output);
 
+// the callback is called once with the stats of the whole run, after the
+// results are printed, it's never called if the build has no stats
+int
+RunCalcApp(
+        const std::string& appname,
+        const std::vector<std::string>& argument,
+        Output* output,
+        const StatsCallback& on_stats);
+
 #endif  // CALC_CALC_H
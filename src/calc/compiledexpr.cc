@@ -0,0 +1,201 @@
+#include "calc/compiledexpr.h"
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+#include "calc/compiler.h"
+#include "calc/errorhandler.h"
+#include "calc/ints.h"
+#include "calc/kernels.h"
+#include "calc/lexer.h"
+#include "calc/optimizer.h"
+#include "calc/parser.h"
+#include "calc/value.h"
+#include "calc/vm.h"
+
+
+// the number of values that are evaluated at once, small enough that all
+// stack blocks stay in the l1 cache
+constexpr std::size_t BATCH_BLOCK_SIZE = 256;
+
+
+// shifts have no kernels, they are rare and the amount can differ for
+// every value, dst = lhs shifted by amount
+template <typename Shift>
+void
+ShiftBlock(
+        std::uint64_t* dst,
+        const std::uint64_t* lhs,
+        const std::uint64_t* amount,
+        std::size_t count,
+        Shift shift)
+{
+    for (std::size_t i = 0; i < count; i += 1)
+    {
+        auto value = lhs[i];
+        shift(&value, amount[i]);
+        dst[i] = value;
+    }
+}
+
+
+template <typename Shift>
+void
+ShiftBlockByConst(std::uint64_t* dst, std::uint64_t amount, std::size_t count, Shift shift)
+{
+    for (std::size_t i = 0; i < count; i += 1)
+    {
+        shift(dst + i, amount);
+    }
+}
+
+
+CompiledExpr::CompiledExpr(Program<std::uint64_t> p) : program(std::move(p))
+{
+}
+
+
+CompiledExpr
+CompiledExpr::FromNode(const Node<std::uint64_t>& root)
+{
+    return CompiledExpr{CompileProgram(root)};
+}
+
+
+[[nodiscard]] const std::vector<std::string>&
+CompiledExpr::Variables() const
+{
+    return program.variables;
+}
+
+
+[[nodiscard]] std::uint64_t
+CompiledExpr::Eval(Span<const std::uint64_t> variables) const
+{
+    assert(variables.size >= program.variables.size() && "missing variable value");
+    return RunProgram(program, variables.data);
+}
+
+
+void
+CompiledExpr::EvalBatch(Span<const std::uint64_t> x, Span<std::uint64_t> out)
+        const
+{
+    assert(program.variables.size() <= 1 && "use the column overload for more than one variable");
+    EvalBatch(Span<const Span<const std::uint64_t>>{&x, 1}, out);
+}
+
+
+void
+CompiledExpr::EvalBatch(
+        Span<const Span<const std::uint64_t>> columns,
+        Span<std::uint64_t> out) const
+{
+    EvalBatch(columns, out, BestKernels());
+}
+
+
+void
+CompiledExpr::EvalBatch(
+        Span<const Span<const std::uint64_t>> columns,
+        Span<std::uint64_t> out,
+        const BatchKernels& kernels) const
+{
+    assert(columns.size >= program.variables.size() && "missing variable column");
+    for (std::size_t column = 0; column < program.variables.size(); column += 1)
+    {
+        assert(columns[column].size == out.size && "column size mismatch");
+    }
+
+    // same as the scalar vm but every register is a block of values, the
+    // top of the stack is the output so the result needs no extra copy
+    std::vector<std::uint64_t> stack(ToSizet(program.stack_size) * BATCH_BLOCK_SIZE);
+
+    for (std::size_t start = 0; start < out.size; start += BATCH_BLOCK_SIZE)
+    {
+        const auto count = std::min(BATCH_BLOCK_SIZE, out.size - start);
+        std::uint64_t* top = out.data + start;
+        std::uint64_t* sp = stack.data();
+
+        for (const auto& instruction: program.code)
+        {
+            const auto index = ToSizet(instruction.value);
+            switch (instruction.op)
+            {
+            case OpCode::PUSH:
+                std::copy(top, top + count, sp);
+                sp += BATCH_BLOCK_SIZE;
+                std::fill(top, top + count, program.constants[index]);
+                break;
+            case OpCode::PUSH_VAR:
+                std::copy(top, top + count, sp);
+                sp += BATCH_BLOCK_SIZE;
+                std::copy(
+                        columns[index].data + start,
+                        columns[index].data + start + count,
+                        top);
+                break;
+            case OpCode::AND_CONST: kernels.and_const(top, program.constants[index], count); break;
+            case OpCode::OR_CONST: kernels.or_const(top, program.constants[index], count); break;
+            case OpCode::XOR_CONST: kernels.xor_const(top, program.constants[index], count); break;
+            case OpCode::SHL_CONST:
+                ShiftBlockByConst(top, program.constants[index], count, ShiftLeft<std::uint64_t>);
+                break;
+            case OpCode::SHR_CONST:
+                ShiftBlockByConst(top, program.constants[index], count, ShiftRight<std::uint64_t>);
+                break;
+            case OpCode::AND_VAR:
+                kernels.and_array(top, columns[index].data + start, count);
+                break;
+            case OpCode::OR_VAR:
+                kernels.or_array(top, columns[index].data + start, count);
+                break;
+            case OpCode::XOR_VAR:
+                kernels.xor_array(top, columns[index].data + start, count);
+                break;
+            case OpCode::SHL_VAR:
+                ShiftBlock(top, top, columns[index].data + start, count, ShiftLeft<std::uint64_t>);
+                break;
+            case OpCode::SHR_VAR:
+                ShiftBlock(top, top, columns[index].data + start, count, ShiftRight<std::uint64_t>);
+                break;
+            case OpCode::AND:
+                sp -= BATCH_BLOCK_SIZE;
+                kernels.and_array(top, sp, count);
+                break;
+            case OpCode::OR:
+                sp -= BATCH_BLOCK_SIZE;
+                kernels.or_array(top, sp, count);
+                break;
+            case OpCode::XOR:
+                sp -= BATCH_BLOCK_SIZE;
+                kernels.xor_array(top, sp, count);
+                break;
+            case OpCode::SHL:
+                sp -= BATCH_BLOCK_SIZE;
+                ShiftBlock(top, sp, top, count, ShiftLeft<std::uint64_t>);
+                break;
+            case OpCode::SHR:
+                sp -= BATCH_BLOCK_SIZE;
+                ShiftBlock(top, sp, top, count, ShiftRight<std::uint64_t>);
+                break;
+            case OpCode::NOT: kernels.xor_const(top, AllBits<std::uint64_t>(), count); break;
+            }
+        }
+    }
+}
+
+
+CompiledExpr
+CompileExpression(const std::string& source, ErrorHandler* errors)
+{
+    AstArena arena;
+    const auto tokens = RunLexer<std::uint64_t>(source, errors);
+    if (errors->HasErr())
+    {
+        return CompiledExpr::FromNode(ErrorNode<std::uint64_t>{});
+    }
+    auto* root = RunParser(tokens, errors, &arena);
+    return CompiledExpr::FromNode(*RunOptimizer(root, &arena));
+}
@@ -0,0 +1,59 @@
+#ifndef CALC_COMPILEDEXPR_H
+#define CALC_COMPILEDEXPR_H
+
+#include <cstdint>
+#include <string>
+
+#include "calc/program.h"
+#include "calc/span.h"
+
+template <typename V>
+struct Node;
+struct ErrorHandler;
+struct BatchKernels;
+
+
+// a expression that is ready to be evaluated over many 64 bit values
+struct CompiledExpr
+{
+    Program<std::uint64_t> program;
+
+    CompiledExpr() = default;
+    explicit CompiledExpr(Program<std::uint64_t> p);
+
+    static CompiledExpr
+    FromNode(const Node<std::uint64_t>& root);
+
+    // the names of the variables, in the order the values are expected
+    [[nodiscard]] const std::vector<std::string>&
+    Variables() const;
+
+    // evaluate a single set of variables
+    [[nodiscard]] std::uint64_t
+    Eval(Span<const std::uint64_t> variables) const;
+
+    // evaluate a expression with at most one variable over all values in x
+    void
+    EvalBatch(Span<const std::uint64_t> x, Span<std::uint64_t> out) const;
+
+    // evaluate with one column per variable, each as long as out
+    void
+    EvalBatch(
+            Span<const Span<const std::uint64_t>> columns,
+            Span<std::uint64_t> out) const;
+
+    // same as above but with explicit kernels instead of the best for this cpu
+    void
+    EvalBatch(
+            Span<const Span<const std::uint64_t>> columns,
+            Span<std::uint64_t> out,
+            const BatchKernels& kernels) const;
+};
+
+
+// lex, parse, optimize and compile a source string
+CompiledExpr
+CompileExpression(const std::string& source, ErrorHandler* errors);
+
+
+#endif  // CALC_COMPILEDEXPR_H
@@ -0,0 +1,252 @@
+#include "calc/compiler.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "calc/ast.h"
+#include "calc/ints.h"
+#include "calc/value.h"
+
+
+// trees can be many thousands of levels deep so the operands of the nodes
+// are compiled from a explicit stack of frames instead of recursing
+template <typename V>
+struct Compiler : public NodeVisitor<V>
+{
+    // a node with operands, the operands after the first are combined
+    // with the result so far by the op as they are compiled
+    struct Frame
+    {
+        std::size_t first_operand;
+        std::size_t count;
+        std::size_t next;
+        OpCode with_const;
+        OpCode with_var;
+        OpCode op;
+        // a operand was pushed and still needs to be combined
+        bool combine;
+    };
+
+    Program<V>* program;
+    int depth = 0;
+    std::vector<Frame> frames;
+    std::vector<const Node<V>*> operands;
+
+    explicit Compiler(Program<V>* p) : program(p) {}
+
+    void
+    Compile(const Node<V>& root)
+    {
+        root.Accept(this);
+        while (!frames.empty())
+        {
+            auto& frame = frames.back();
+            if (frame.combine)
+            {
+                Emit(frame.op);
+                depth -= 1;
+                frame.combine = false;
+            }
+
+            if (frame.next == frame.count)
+            {
+                if (frame.op == OpCode::NOT)
+                {
+                    Emit(OpCode::NOT);
+                }
+                operands.resize(frame.first_operand);
+                frames.pop_back();
+                continue;
+            }
+
+            // the frame can move when a operand adds its own frame
+            const auto index = frame.next;
+            frame.next += 1;
+            const auto& operand = *operands[frame.first_operand + index];
+            if (index == 0)
+            {
+                operand.Accept(this);
+            }
+            else
+            {
+                Operand(operand, frame.with_const, frame.with_var);
+            }
+        }
+    }
+
+    void
+    Emit(OpCode op, int value = 0)
+    {
+        program->code.emplace_back(Instruction{op, value});
+    }
+
+    void
+    OnError(const ErrorNode<V>&) override
+    {
+        Push(AddConstant(V{}));
+    }
+
+    void
+    OnNumber(const NumberNode<V>& node) override
+    {
+        Push(AddConstant(node.value));
+    }
+
+    void
+    OnVariable(const VariableNode<V>& node) override
+    {
+        Push(AddVariable(node), OpCode::PUSH_VAR);
+    }
+
+    void
+    OnAnd(const AndNode<V>& node) override
+    {
+        Chain(node.operands, OpCode::AND_CONST, OpCode::AND_VAR, OpCode::AND);
+    }
+
+    void
+    OnOr(const OrNode<V>& node) override
+    {
+        Chain(node.operands, OpCode::OR_CONST, OpCode::OR_VAR, OpCode::OR);
+    }
+
+    void
+    OnXor(const XorNode<V>& node) override
+    {
+        Chain(node.operands, OpCode::XOR_CONST, OpCode::XOR_VAR, OpCode::XOR);
+    }
+
+    void
+    OnNot(const NotNode<V>& node) override
+    {
+        AddFrame(1, OpCode::NOT, OpCode::NOT, OpCode::NOT);
+        operands.emplace_back(node.operand);
+    }
+
+    void
+    OnShiftLeft(const ShiftLeftNode<V>& node) override
+    {
+        Shift(node.lhs, node.rhs, OpCode::SHL_CONST, OpCode::SHL_VAR, OpCode::SHL);
+    }
+
+    void
+    OnShiftRight(const ShiftRightNode<V>& node) override
+    {
+        Shift(node.lhs, node.rhs, OpCode::SHR_CONST, OpCode::SHR_VAR, OpCode::SHR);
+    }
+
+    // variables are renumbered in the order they are used, so variables that
+    // were removed by the optimizer doesn't leave gaps
+    std::vector<int> slots;
+
+    int
+    AddConstant(const V& value)
+    {
+        program->constants.emplace_back(value);
+        return ToInt(program->constants.size() - 1);
+    }
+
+    int
+    AddVariable(const VariableNode<V>& node)
+    {
+        const auto index = ToSizet(node.index);
+        if (slots.size() <= index)
+        {
+            slots.resize(index + 1, -1);
+        }
+        if (slots[index] < 0)
+        {
+            slots[index] = ToInt(program->variables.size());
+            program->variables.emplace_back(node.name);
+        }
+        return slots[index];
+    }
+
+    void
+    Push(int value, OpCode op = OpCode::PUSH)
+    {
+        Emit(op, value);
+        depth += 1;
+        program->stack_size = std::max(program->stack_size, depth);
+    }
+
+    void
+    AddFrame(std::size_t count, OpCode with_const, OpCode with_var, OpCode op)
+    {
+        frames.push_back(Frame{operands.size(), count, 0, with_const, with_var, op, false});
+    }
+
+    void
+    Chain(const Span<Node<V>*>& chain,
+          OpCode with_const,
+          OpCode with_var,
+          OpCode op)
+    {
+        AddFrame(chain.size, with_const, with_var, op);
+        operands.insert(operands.end(), chain.begin(), chain.end());
+    }
+
+    void
+    Shift(const Node<V>* lhs, const Node<V>* rhs, OpCode with_const, OpCode with_var, OpCode op)
+    {
+        AddFrame(2, with_const, with_var, op);
+        operands.emplace_back(lhs);
+        operands.emplace_back(rhs);
+    }
+
+    void
+    Operand(const Node<V>& rhs, OpCode with_const, OpCode with_var)
+    {
+        // a constant or variable right hand side can be folded into the
+        // operation instead of being pushed and popped again
+        const auto* number = dynamic_cast<const NumberNode<V>*>(&rhs);
+        const auto* variable = dynamic_cast<const VariableNode<V>*>(&rhs);
+        if (number != nullptr)
+        {
+            Emit(with_const, AddConstant(number->value));
+        }
+        else if (variable != nullptr)
+        {
+            Emit(with_var, AddVariable(*variable));
+        }
+        else
+        {
+            // the op of the frame combines it once it's compiled
+            frames.back().combine = true;
+            rhs.Accept(this);
+        }
+    }
+};
+
+
+template <typename V>
+Program<V>
+CompileProgram(const Node<V>& root)
+{
+    Program<V> program;
+    CompileProgram(root, &program);
+    return program;
+}
+
+
+template <typename V>
+void
+CompileProgram(const Node<V>& root, Program<V>* program)
+{
+    program->code.clear();
+    program->stack_size = 0;
+    program->variables.clear();
+    program->constants.clear();
+    program->table.clear();
+
+    auto compiler = Compiler<V>{program};
+    compiler.Compile(root);
+}
+
+
+#define INSTANTIATE(V) \
+    template Program<V> CompileProgram(const Node<V>& root); \
+    template void CompileProgram(const Node<V>& root, Program<V>* program);
+CALC_FOR_EACH_VALUE(INSTANTIATE)
+#undef INSTANTIATE
@@ -0,0 +1,22 @@
+#ifndef CALC_COMPILER_H
+#define CALC_COMPILER_H
+
+#include "calc/program.h"
+
+template <typename V>
+struct Node;
+
+
+// flatten a node tree to a program that can be run with RunProgram
+template <typename V>
+Program<V>
+CompileProgram(const Node<V>& root);
+
+
+// same as above but reuses the memory of a existing program
+template <typename V>
+void
+CompileProgram(const Node<V>& root, Program<V>* program);
+
+
+#endif  // CALC_COMPILER_H
@@ -0,0 +1,10 @@
+#include "calc/constant.h"
+
+#include <cstdlib>
+
+
+void
+MalformedConstantExpression()
+{
+    std::abort();
+}
@@ -0,0 +1,166 @@
+#ifndef CALC_CONSTANT_H
+#define CALC_CONSTANT_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "calc/errorhandler.h"
+#include "calc/grammar.h"
+#include "calc/scanner.h"
+#include "calc/token.h"
+#include "calc/value.h"
+
+
+// expressions without variables evaluated at compile time, with the same
+// scanner and grammar as the runtime, the operators are applied as they are
+// reduced so no tree is built
+
+
+// the tokens and the stacks are fixed size arrays
+constexpr std::size_t MAX_CONSTANT_TOKENS = 256;
+
+
+template <typename V>
+struct ConstantResult
+{
+    V value;
+
+    // the first error, if any
+    bool failed;
+    Error error;
+};
+
+
+// the operands are the values
+template <typename V>
+struct ConstantBuilder
+{
+    using Operand = V;
+
+    bool failed = false;
+    Error error = {};
+
+    constexpr V
+    MakeNumber(const Token<V>& token)
+    {
+        return token.value;
+    }
+
+    constexpr V
+    MakeVariable(const Token<V>& token)
+    {
+        Err(ErrorCode::MISSING_VALUE, token.name, token.type);
+        return V{};
+    }
+
+    constexpr V
+    MakeNot(V operand)
+    {
+        return Complement(operand);
+    }
+
+    constexpr V
+    MakeBinary(TokenType<V> type, V lhs, V rhs)
+    {
+        switch (type)
+        {
+        case Token<V>::OPAND: lhs &= rhs; break;
+        case Token<V>::OPOR: lhs |= rhs; break;
+        case Token<V>::OPXOR: lhs ^= rhs; break;
+        case Token<V>::OPSHL: ShiftLeft(&lhs, rhs); break;
+        case Token<V>::OPSHR: ShiftRight(&lhs, rhs); break;
+        default: break;
+        }
+        return lhs;
+    }
+
+    constexpr V
+    MakeError()
+    {
+        return V{};
+    }
+
+    constexpr void
+    Err(ErrorCode code, std::string_view text, int token)
+    {
+        if (!failed)
+        {
+            failed = true;
+            error = Error{code, token, text};
+        }
+    }
+
+    [[nodiscard]] constexpr bool
+    HasErr() const
+    {
+        return failed;
+    }
+};
+
+
+// the value of a expression, variables and more than MAX_CONSTANT_TOKENS
+// tokens are errors
+template <typename V>
+constexpr ConstantResult<V>
+EvaluateConstant(std::string_view source)
+{
+    std::array<Token<V>, MAX_CONSTANT_TOKENS> tokens{};
+    std::size_t count = 0;
+
+    auto scanner = Scanner<V>{source};
+    auto token = Token<V>{};
+    while (scanner.Read(&token))
+    {
+        if (count == tokens.size())
+        {
+            return {V{}, true, Error{ErrorCode::TOO_MANY_TOKENS, token.type, token.name}};
+        }
+        tokens[count] = token;
+        count += 1;
+    }
+    if (scanner.failed)
+    {
+        return {V{}, true, Error{scanner.error, 0, scanner.error_text}};
+    }
+    if (count == 0)
+    {
+        return {V{}, true, Error{ErrorCode::EMPTY_STATEMENT, 0, source.substr(source.size())}};
+    }
+
+    std::array<V, MAX_CONSTANT_TOKENS> operands{};
+    std::array<TokenType<V>, MAX_CONSTANT_TOKENS> operators{};
+    auto builder = ConstantBuilder<V>{};
+    auto grammar = Grammar<V, ConstantBuilder<V>>{
+            &builder,
+            {tokens.data(), count},
+            {{operands.data(), count}},
+            {{operators.data(), count}}};
+    const auto value = grammar.Parse();
+    return {value, builder.failed, builder.error};
+}
+
+
+// not constexpr so calling it while evaluating a constant is a compile
+// error, at runtime it aborts
+[[noreturn]] void
+MalformedConstantExpression();
+
+
+// the 64 bit value of a expression, "0xff & 0b100"_bb is 4, malformed
+// expressions are compile errors when the literal is a constant
+// expression, so initialize a constexpr variable with it
+constexpr std::uint64_t
+operator""_bb(const char* source, std::size_t size)
+{
+    const auto result = EvaluateConstant<std::uint64_t>({source, size});
+    if (result.failed)
+    {
+        MalformedConstantExpression();
+    }
+    return result.value;
+}
+
+
+#endif  // CALC_CONSTANT_H
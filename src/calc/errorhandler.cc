@@ -1,14 +1,106 @@
 #include "calc/errorhandler.h"
 
-#include <fmt/core.h>
+#include <functional>
+#include <iterator>
 
 #include "calc/output.h"
+#include "calc/token.h"
+
+
+[[nodiscard]] std::size_t
+Error::Offset(std::string_view source) const
+{
+    // the text can view another buffer, std::less orders any pointers
+    // while < on pointers into different objects is unspecified
+    const auto* begin = source.data();
+    const auto* end = begin + source.size();
+    const std::less<const char*> before{};
+    if (before(text.data(), begin) || before(end, text.data()))
+    {
+        return NO_OFFSET;
+    }
+    return static_cast<std::size_t>(text.data() - begin);
+}
+
+
+void
+Error::AppendMessage(fmt::memory_buffer* out) const
+{
+    const auto append_token = [&]() {
+        out->append(TokenTypeName(token));
+        if (IsOperandType(token))
+        {
+            out->push_back('(');
+            out->append(text);
+            out->push_back(')');
+        }
+    };
+    const auto character = text.empty() ? '\0' : text[0];
+
+    auto it = std::back_inserter(*out);
+    switch (code)
+    {
+    case ErrorCode::NUMBER_TOO_LARGE:
+        fmt::format_to(it, "Number is too large: {}", text);
+        break;
+    case ErrorCode::INVALID_NUMBER_START:
+        fmt::format_to(it, "Numbers must start with a number, but started with '{}' ({})", character, static_cast<int>(character));
+        break;
+    case ErrorCode::MISSING_HEX_DIGITS:
+        fmt::format_to(it, "Numbers started with 0x must contain atleast one hexa character but was continued with {}", character);
+        break;
+    case ErrorCode::INVALID_BINARY_DIGIT:
+        fmt::format_to(it, "binary numbers can't contain other than 0 or 1, read: {}", character);
+        break;
+    case ErrorCode::MISSING_BINARY_DIGITS:
+        fmt::format_to(it, "Numbers started with 0b must contain atleast one binary character but was continued with {}", character);
+        break;
+    case ErrorCode::INVALID_CHARACTER:
+        fmt::format_to(it, "Invalid character: {}", character);
+        break;
+    case ErrorCode::EXPECTED_OPERAND:
+        out->append(std::string_view{"Expected number or variable but got "});
+        append_token();
+        break;
+    case ErrorCode::EXPECTED_OPERATOR:
+        out->append(std::string_view{"Expected OP but got "});
+        append_token();
+        break;
+    case ErrorCode::UNMATCHED_PAREN:
+        out->append(std::string_view{"Unmatched )"});
+        break;
+    case ErrorCode::MISSING_PAREN:
+        out->append(std::string_view{"Missing )"});
+        break;
+    case ErrorCode::EMPTY_STATEMENT:
+        out->append(std::string_view{"Empty statement"});
+        break;
+    case ErrorCode::MISSING_VALUE:
+        fmt::format_to(it, "Missing value for {}", text);
+        break;
+    case ErrorCode::TOO_MANY_TOKENS:
+        fmt::format_to(it, "Too many tokens, stopped at {}", text);
+        break;
+    case ErrorCode::TOO_MANY_VARIABLES:
+        fmt::format_to(it, "Only one variable is allowed, found {}", text);
+        break;
+    }
+}
+
+
+[[nodiscard]] std::string
+Error::ToString() const
+{
+    fmt::memory_buffer buffer;
+    AppendMessage(&buffer);
+    return fmt::to_string(buffer);
+}
 
 
 void
-ErrorHandler::Err(const std::string& str)
+ErrorHandler::Err(ErrorCode code, std::string_view text, int token)
 {
-    errors.emplace_back(str);
+    errors.emplace_back(Error{code, token, text});
 }
 
 
@@ -19,13 +111,46 @@ ErrorHandler::HasErr() const
 }
 
 
-void
-ErrorHandler::PrintErrors(Output* output)
+[[nodiscard]] std::vector<std::string>
+ErrorHandler::Messages() const
 {
-    output->PrintError("Error while parsing:");
-    for (const auto& err: errors)
+    std::vector<std::string> messages;
+    for (const auto& error: errors)
     {
-        output->PrintError(fmt::format(" - {}", err));
+        messages.emplace_back(error.ToString());
     }
+    return messages;
 }
 
+
+void
+ErrorHandler::PrintErrors(Output* output, std::string_view header) const
+{
+    ::PrintErrors(output, header, errors.data(), errors.size());
+}
+
+
+void
+ErrorHandler::Clear()
+{
+    errors.clear();
+}
+
+
+void
+PrintErrors(
+        Output* output,
+        std::string_view header,
+        const Error* errors,
+        std::size_t count)
+{
+    output->PrintError(header);
+    fmt::memory_buffer line;
+    for (std::size_t index = 0; index < count; index += 1)
+    {
+        line.append(std::string_view{" - "});
+        errors[index].AppendMessage(&line);
+        output->PrintError({line.data(), line.size()});
+        line.clear();
+    }
+}
@@ -1,28 +1,107 @@
 #ifndef CALC_ERRORHANDLER_H
 #define CALC_ERRORHANDLER_H
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include <fmt/format.h>
+
 
 struct Output;
 
 
+enum class ErrorCode : std::uint8_t
+{
+    // the text is the number or the character that was read
+    NUMBER_TOO_LARGE,
+    INVALID_NUMBER_START,
+    MISSING_HEX_DIGITS,
+    INVALID_BINARY_DIGIT,
+    MISSING_BINARY_DIGITS,
+    INVALID_CHARACTER,
+
+    // the text and token are the token that was found
+    EXPECTED_OPERAND,
+    EXPECTED_OPERATOR,
+    UNMATCHED_PAREN,
+    MISSING_PAREN,
+
+    EMPTY_STATEMENT,
+
+    // the text is the variable
+    MISSING_VALUE,
+
+    // the text is the first token that didn't fit
+    TOO_MANY_TOKENS,
+
+    // the text is the second variable of a expression that can only have one
+    TOO_MANY_VARIABLES
+};
+
+
+constexpr std::size_t NO_OFFSET = static_cast<std::size_t>(-1);
+
+
+// a error as it was found, the message is only formatted when printed
+//
+// the text points into the source, so the errors must be printed before
+// the source is gone, at the end of the source the text is empty
+struct Error
+{
+    ErrorCode code;
+
+    // the type of the token for the parser errors
+    int token;
+
+    std::string_view text;
+
+    // where the text starts in the source or NO_OFFSET if it's not in it,
+    // the column is the offset + 1
+    [[nodiscard]] std::size_t
+    Offset(std::string_view source) const;
+
+    void
+    AppendMessage(fmt::memory_buffer* out) const;
+
+    [[nodiscard]] std::string
+    ToString() const;
+};
+
+
 // todo: rename to log
 struct ErrorHandler
 {
-    std::vector<std::string> errors;
+    std::vector<Error> errors;
 
     void
-    Err(const std::string& str);
+    Err(ErrorCode code, std::string_view text, int token = 0);
 
     [[nodiscard]] bool
     HasErr() const;
 
+    // the messages of all errors
+    [[nodiscard]] std::vector<std::string>
+    Messages() const;
+
+    void
+    PrintErrors(Output* output, std::string_view header = "Error while parsing:") const;
+
+    // forget all errors so the handler can be reused for the next source
     void
-    PrintErrors(Output* output);
+    Clear();
 };
 
 
-#endif  // CALC_ERRORHANDLER_H
+// prints a header and one line for each of the errors
+void
+PrintErrors(
+        Output* output,
+        std::string_view header,
+        const Error* errors,
+        std::size_t count);
+
 
+#endif  // CALC_ERRORHANDLER_H
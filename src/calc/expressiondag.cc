@@ -0,0 +1,393 @@
+#include "calc/expressiondag.h"
+
+#include <algorithm>
+#include <type_traits>
+
+#include "calc/ast.h"
+#include "calc/errorhandler.h"
+#include "calc/ints.h"
+#include "calc/lexer.h"
+#include "calc/parser.h"
+#include "calc/value.h"
+
+
+constexpr std::uint64_t
+CombineHash(std::uint64_t hash, std::uint64_t value)
+{
+    return hash ^ (value + 0x9e3779b97f4a7c15 + (hash << 6) + (hash >> 2));
+}
+
+
+template <typename V>
+std::enable_if_t<std::is_unsigned_v<V>, std::uint64_t>
+HashValue(V value)
+{
+    return CombineHash(0, value);
+}
+
+
+template <std::size_t N>
+std::uint64_t
+HashValue(const Bits<N>& value)
+{
+    std::uint64_t hash = 0;
+    for (const auto word: value.words)
+    {
+        hash = CombineHash(hash, word);
+    }
+    return hash;
+}
+
+
+// interns the operands before the node, operations on constants are
+// folded before they are interned so only the folded constant is added
+template <typename V>
+struct ExpressionDag<V>::Interner : public NodeVisitor<V>
+{
+    // a interned tree is either a constant or a node
+    struct Operand
+    {
+        bool is_constant;
+        V constant;
+        int id;
+    };
+
+    ExpressionDag<V>* dag;
+
+    // the interned operands of the visited node and the visited node
+    Span<Operand> visited;
+    Operand result{false, V{}, -1};
+
+    explicit Interner(ExpressionDag<V>* d) : dag(d) {}
+
+    // the node of the tree, a constant is interned
+    int
+    Intern(const Node<V>& node)
+    {
+        const auto interned = FoldTree<Operand>(
+                node,
+                [this](const Node<V>& operation, Span<Node<V>* const>, Span<Operand> operands) {
+                    visited = operands;
+                    operation.Accept(this);
+                    return result;
+                });
+        return interned.is_constant ? dag->InternNumber(interned.constant) : interned.id;
+    }
+
+    void
+    Operation(Kind kind)
+    {
+        const auto all_constant = std::all_of(visited.begin(), visited.end(), [](const Operand& operand) {
+            return operand.is_constant;
+        });
+        if (all_constant)
+        {
+            result.constant = visited[0].constant;
+            for (auto operand = visited.begin() + 1; operand != visited.end(); ++operand)
+            {
+                Combine(kind, &result.constant, operand->constant);
+            }
+            if (kind == Kind::NOT)
+            {
+                result.constant = Complement(result.constant);
+            }
+            result.is_constant = true;
+            return;
+        }
+
+        std::vector<int> node_operands;
+        for (const auto& operand: visited)
+        {
+            node_operands.emplace_back(operand.is_constant ? dag->InternNumber(operand.constant) : operand.id);
+        }
+        result.id = dag->Intern(kind, &node_operands);
+        result.is_constant = false;
+    }
+
+    void
+    OnError(const ErrorNode<V>&) override
+    {
+        result.constant = V{};
+        result.is_constant = true;
+    }
+
+    void
+    OnNumber(const NumberNode<V>& node) override
+    {
+        result.constant = node.value;
+        result.is_constant = true;
+    }
+
+    void
+    OnVariable(const VariableNode<V>& node) override
+    {
+        result.id = dag->InternVariable(node.name);
+        result.is_constant = false;
+    }
+
+    void
+    OnAnd(const AndNode<V>&) override
+    {
+        Operation(Kind::AND);
+    }
+
+    void
+    OnOr(const OrNode<V>&) override
+    {
+        Operation(Kind::OR);
+    }
+
+    void
+    OnXor(const XorNode<V>&) override
+    {
+        Operation(Kind::XOR);
+    }
+
+    void
+    OnNot(const NotNode<V>&) override
+    {
+        Operation(Kind::NOT);
+    }
+
+    void
+    OnShiftLeft(const ShiftLeftNode<V>&) override
+    {
+        Operation(Kind::SHIFT_LEFT);
+    }
+
+    void
+    OnShiftRight(const ShiftRightNode<V>&) override
+    {
+        Operation(Kind::SHIFT_RIGHT);
+    }
+};
+
+
+template <typename V>
+ExpressionDag<V>::ExpressionDag() = default;
+
+
+template <typename V>
+ExpressionDag<V>::~ExpressionDag() = default;
+
+
+template <typename V>
+int
+ExpressionDag<V>::Add(std::string_view source, ErrorHandler* errors)
+{
+    // only the dag is kept, the tree is parsed in memory that is reused
+    arena.Reset();
+
+    RunLexer(source, errors, &tokens);
+    if (errors->HasErr())
+    {
+        return -1;
+    }
+    if (tokens.empty())
+    {
+        errors->Err(ErrorCode::EMPTY_STATEMENT, source.substr(source.size()));
+        return -1;
+    }
+
+    const auto* root = RunParser(tokens, errors, &arena);
+    if (errors->HasErr())
+    {
+        return -1;
+    }
+
+    auto interner = Interner{this};
+    roots.emplace_back(interner.Intern(*root));
+    return ToInt(roots.size() - 1);
+}
+
+
+template <typename V>
+std::size_t
+ExpressionDag<V>::ExpressionCount() const
+{
+    return roots.size();
+}
+
+
+template <typename V>
+std::size_t
+ExpressionDag<V>::NodeCount() const
+{
+    return nodes.size();
+}
+
+
+template <typename V>
+const std::vector<std::string>&
+ExpressionDag<V>::Variables() const
+{
+    return variables;
+}
+
+
+template <typename V>
+void
+ExpressionDag<V>::Evaluate(
+        const std::vector<V>& variable_values,
+        std::vector<V>* values,
+        std::vector<V>* results) const
+{
+    values->resize(nodes.size());
+    V* value = values->data();
+
+    // a single pass, the operands are always before the nodes that use them
+    for (std::size_t id = 0; id < nodes.size(); id += 1)
+    {
+        const auto& node = nodes[id];
+        switch (node.kind)
+        {
+        case Kind::NUMBER: value[id] = constants[ToSizet(node.value)]; break;
+        case Kind::VARIABLE: value[id] = variable_values[ToSizet(node.value)]; break;
+        case Kind::NOT: value[id] = Complement(value[operands[ToSizet(node.first)]]); break;
+        default:
+        {
+            const auto* node_operands = operands.data() + node.first;
+            auto result = value[node_operands[0]];
+            for (int operand = 1; operand < node.count; operand += 1)
+            {
+                Combine(node.kind, &result, value[node_operands[operand]]);
+            }
+            value[id] = result;
+            break;
+        }
+        }
+    }
+
+    results->resize(roots.size());
+    for (std::size_t expression = 0; expression < roots.size(); expression += 1)
+    {
+        (*results)[expression] = value[roots[expression]];
+    }
+}
+
+
+template <typename V>
+int
+ExpressionDag<V>::InternNumber(const V& number)
+{
+    const auto hash = CombineHash(HashValue(number), static_cast<std::uint64_t>(Kind::NUMBER));
+    const auto found = index.find(hash);
+    for (auto id = found == index.end() ? -1 : found->second; id >= 0; id = nodes[ToSizet(id)].next)
+    {
+        const auto& node = nodes[ToSizet(id)];
+        if (node.kind == Kind::NUMBER && constants[ToSizet(node.value)] == number)
+        {
+            return id;
+        }
+    }
+
+    constants.emplace_back(number);
+    return AddNode(SharedNode{Kind::NUMBER, ToInt(constants.size() - 1), 0, 0, hash, -1}, nullptr);
+}
+
+
+template <typename V>
+int
+ExpressionDag<V>::InternVariable(std::string_view name)
+{
+    const auto found = variable_nodes.find(std::string{name});
+    if (found != variable_nodes.end())
+    {
+        return found->second;
+    }
+
+    const auto variable = ToInt(variables.size());
+    variables.emplace_back(name);
+    const auto hash = CombineHash(static_cast<std::uint64_t>(variable), static_cast<std::uint64_t>(Kind::VARIABLE));
+    const auto id = AddNode(SharedNode{Kind::VARIABLE, variable, 0, 0, hash, -1}, nullptr);
+    variable_nodes.emplace(name, id);
+    return id;
+}
+
+
+template <typename V>
+int
+ExpressionDag<V>::Intern(Kind kind, std::vector<int>* node_operands)
+{
+    // a & b and b & a are the same node
+    if (kind == Kind::AND || kind == Kind::OR || kind == Kind::XOR)
+    {
+        std::sort(node_operands->begin(), node_operands->end());
+    }
+
+    auto hash = static_cast<std::uint64_t>(kind);
+    for (const auto operand: *node_operands)
+    {
+        hash = CombineHash(hash, static_cast<std::uint64_t>(operand));
+    }
+
+    const auto found = index.find(hash);
+    for (auto id = found == index.end() ? -1 : found->second; id >= 0; id = nodes[ToSizet(id)].next)
+    {
+        if (IsSame(nodes[ToSizet(id)], kind, 0, *node_operands))
+        {
+            return id;
+        }
+    }
+
+    const auto count = ToInt(node_operands->size());
+    return AddNode(SharedNode{kind, 0, ToInt(operands.size()), count, hash, -1}, node_operands->data());
+}
+
+
+template <typename V>
+int
+ExpressionDag<V>::AddNode(const SharedNode& node, const int* node_operands)
+{
+    const auto id = ToInt(nodes.size());
+    operands.insert(operands.end(), node_operands, node_operands + node.count);
+    nodes.emplace_back(node);
+
+    // chained to the nodes with the same hash
+    const auto found = index.find(node.hash);
+    if (found == index.end())
+    {
+        index.emplace(node.hash, id);
+    }
+    else
+    {
+        nodes.back().next = found->second;
+        found->second = id;
+    }
+    return id;
+}
+
+
+template <typename V>
+bool
+ExpressionDag<V>::IsSame(const SharedNode& node, Kind kind, int value, const std::vector<int>& node_operands) const
+{
+    if (node.kind != kind || node.value != value || ToSizet(node.count) != node_operands.size())
+    {
+        return false;
+    }
+    return std::equal(node_operands.begin(), node_operands.end(), operands.begin() + node.first);
+}
+
+
+template <typename V>
+void
+ExpressionDag<V>::Combine(Kind kind, V* result, const V& operand)
+{
+    switch (kind)
+    {
+    case Kind::AND: *result &= operand; break;
+    case Kind::OR: *result |= operand; break;
+    case Kind::XOR: *result ^= operand; break;
+    case Kind::SHIFT_LEFT: ShiftLeft(result, operand); break;
+    case Kind::SHIFT_RIGHT: ShiftRight(result, operand); break;
+    case Kind::NUMBER:
+    case Kind::VARIABLE:
+    case Kind::NOT: break;
+    }
+}
+
+
+#define INSTANTIATE(V) template struct ExpressionDag<V>;
+CALC_FOR_EACH_VALUE(INSTANTIATE)
+#undef INSTANTIATE
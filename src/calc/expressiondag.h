@@ -0,0 +1,136 @@
+#ifndef CALC_EXPRESSIONDAG_H
+#define CALC_EXPRESSIONDAG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "calc/arena.h"
+#include "calc/token.h"
+
+struct ErrorHandler;
+
+
+// many expressions stored as one dag where identical subexpressions are
+// shared, so a subexpression that a thousand expressions use is stored
+// and evaluated once, and the memory grows with the number of unique
+// subexpressions instead of with the size of the sources
+//
+// the expressions are interned as parsed, not optimized, so a chain keeps
+// the prefixes that other expressions can share, the operands of and, or
+// and xor are sorted so the order they are written in doesn't matter and
+// operations on constants are folded, variables with the same name are
+// the same variable in all expressions
+template <typename V>
+struct ExpressionDag
+{
+    ExpressionDag();
+    ~ExpressionDag();
+
+    ExpressionDag(const ExpressionDag&) = delete;
+    ExpressionDag(ExpressionDag&&) = delete;
+    void
+    operator=(const ExpressionDag&) = delete;
+    void
+    operator=(ExpressionDag&&) = delete;
+
+    // the index of the expression or -1 if it has errors, the errors are
+    // added to the handler and nothing is added to the dag
+    int
+    Add(std::string_view source, ErrorHandler* errors);
+
+    [[nodiscard]] std::size_t
+    ExpressionCount() const;
+
+    // the number of unique subexpressions
+    [[nodiscard]] std::size_t
+    NodeCount() const;
+
+    // the names of the variables of all expressions, in the order the
+    // values are expected
+    [[nodiscard]] const std::vector<std::string>&
+    Variables() const;
+
+    // evaluates every unique subexpression once and writes the result of
+    // each expression, the values are scratch memory that can be reused
+    void
+    Evaluate(const std::vector<V>& variables, std::vector<V>* values, std::vector<V>* results) const;
+
+private:
+    enum class Kind : std::uint8_t
+    {
+        NUMBER,
+        VARIABLE,
+        AND,
+        OR,
+        XOR,
+        NOT,
+        SHIFT_LEFT,
+        SHIFT_RIGHT
+    };
+
+    // the operands are always added before the nodes that use them, so the
+    // nodes are in an order they can be evaluated in
+    struct SharedNode
+    {
+        Kind kind;
+
+        // the index of the constant or the variable
+        int value;
+
+        // the operands are in the operand list
+        int first;
+        int count;
+
+        std::uint64_t hash;
+
+        // the previous node with the same hash or -1
+        int next;
+    };
+
+    struct Interner;
+
+    std::vector<SharedNode> nodes;
+    std::vector<int> operands;
+    std::vector<V> constants;
+    std::vector<std::string> variables;
+
+    // the node of each variable by name
+    std::unordered_map<std::string, int> variable_nodes;
+
+    // the last node with a hash
+    std::unordered_map<std::uint64_t, int> index;
+
+    // the node of each expression
+    std::vector<int> roots;
+
+    // the parse of the expression that is being added
+    AstArena arena;
+    std::vector<Token<V>> tokens;
+
+    // the node of the value, variable or operation, new if there is none
+    int
+    InternNumber(const V& value);
+
+    int
+    InternVariable(std::string_view name);
+
+    int
+    Intern(Kind kind, std::vector<int>* node_operands);
+
+    int
+    AddNode(const SharedNode& node, const int* node_operands);
+
+    [[nodiscard]] bool
+    IsSame(const SharedNode& node, Kind kind, int value, const std::vector<int>& node_operands) const;
+
+    // applies a operation, other than not, to the result and a operand
+    static void
+    Combine(Kind kind, V* result, const V& operand);
+};
+
+
+#endif  // CALC_EXPRESSIONDAG_H
@@ -0,0 +1,239 @@
+#ifndef CALC_GRAMMAR_H
+#define CALC_GRAMMAR_H
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <string_view>
+
+#include "calc/errorhandler.h"
+#include "calc/span.h"
+#include "calc/token.h"
+
+
+template <typename V>
+using TokenType = typename Token<V>::Type;
+
+
+// how tight each token binds as a operator, indexed by the token type, the
+// order follows c and 0 is used for tokens that never are reduced
+constexpr std::array PRECEDENCE{
+        0,  // NUMBER
+        0,  // VARIABLE
+        3,  // OPAND
+        1,  // OPOR
+        2,  // OPXOR
+        5,  // OPNOT
+        4,  // OPSHL
+        4,  // OPSHR
+        0,  // LPAREN
+        0,  // RPAREN
+        0  // EOFTOKEN
+};
+
+
+template <typename V>
+constexpr int
+Precedence(TokenType<V> type)
+{
+    static_assert(PRECEDENCE.size() == Token<V>::EOFTOKEN + 1);
+    return PRECEDENCE[static_cast<std::size_t>(type)];
+}
+
+
+template <typename V>
+constexpr bool
+IsBinaryOperator(TokenType<V> type)
+{
+    return type != Token<V>::OPNOT && Precedence<V>(type) > 0;
+}
+
+
+// a stack that never grows, the memory is allocated up front by the user
+template <typename T>
+struct BoundedStack
+{
+    Span<T> memory;
+    std::size_t size = 0;
+
+    [[nodiscard]] constexpr bool
+    IsEmpty() const
+    {
+        return size == 0;
+    }
+
+    constexpr T&
+    Top()
+    {
+        assert(size > 0);
+        return memory[size - 1];
+    }
+
+    constexpr T
+    Pop()
+    {
+        assert(size > 0);
+        size -= 1;
+        return memory[size];
+    }
+
+    constexpr void
+    Push(T value)
+    {
+        assert(size < memory.size);
+        memory[size] = value;
+        size += 1;
+    }
+};
+
+
+// the shunting-yard parser of the tokens, what the operands are is up to
+// the builder, the parser builds nodes and the constant evaluator values,
+// so both accept the same expressions with the same precedence
+//
+// the builder has a Operand type and the functions
+//   MakeNumber(token), MakeVariable(token), MakeNot(operand),
+//   MakeBinary(type, lhs, rhs), MakeError(), Err(code, text, token)
+//   and HasErr()
+template <typename V, typename Builder>
+struct Grammar
+{
+    using Operand = typename Builder::Operand;
+
+    Builder* builder;
+    Span<const Token<V>> tokens;
+
+    // the operands and the operators that are waiting for their right hand
+    // side, kept in explicit stacks so deep nesting never recurses, every
+    // token pushes at most one entry to one of the stacks
+    BoundedStack<Operand> operands;
+    BoundedStack<TokenType<V>> operators;
+
+    constexpr void
+    Reduce()
+    {
+        const auto op = operators.Pop();
+        auto rhs = operands.Pop();
+        if (op == Token<V>::OPNOT)
+        {
+            operands.Push(builder->MakeNot(rhs));
+            return;
+        }
+
+        auto lhs = operands.Top();
+        operands.Top() = builder->MakeBinary(op, lhs, rhs);
+    }
+
+    // a empty text at the end of the source, for the errors at the end
+    [[nodiscard]] constexpr std::string_view
+    EndOfSource() const
+    {
+        if (tokens.empty())
+        {
+            return {};
+        }
+        const auto last = tokens[tokens.size - 1].name;
+        return last.substr(last.size());
+    }
+
+    // reads a number, a variable or the start of one, true when a operand
+    // was completed and a operator should follow
+    constexpr bool
+    ParseOperand(const Token<V>& token)
+    {
+        switch (token.type)
+        {
+        case Token<V>::NUMBER:
+            operands.Push(builder->MakeNumber(token));
+            return true;
+        case Token<V>::VARIABLE:
+            operands.Push(builder->MakeVariable(token));
+            return true;
+        case Token<V>::OPNOT:
+        case Token<V>::LPAREN:
+            operators.Push(token.type);
+            return false;
+        default:
+            builder->Err(ErrorCode::EXPECTED_OPERAND, token.name, token.type);
+            return false;
+        }
+    }
+
+    // reads a binary operator or the end of a parenthesis, false when a
+    // operand should follow
+    constexpr bool
+    ParseOperator(const Token<V>& token)
+    {
+        if (token.type == Token<V>::RPAREN)
+        {
+            while (!operators.IsEmpty() && operators.Top() != Token<V>::LPAREN)
+            {
+                Reduce();
+            }
+            if (operators.IsEmpty())
+            {
+                builder->Err(ErrorCode::UNMATCHED_PAREN, token.name, token.type);
+                return true;
+            }
+            operators.Pop();
+            return true;
+        }
+
+        if (!IsBinaryOperator<V>(token.type))
+        {
+            builder->Err(ErrorCode::EXPECTED_OPERATOR, token.name, token.type);
+            return true;
+        }
+
+        // everything that binds at least as tight is complete, this makes
+        // all binary operators left associative
+        const auto precedence = Precedence<V>(token.type);
+        while (!operators.IsEmpty() && Precedence<V>(operators.Top()) >= precedence)
+        {
+            Reduce();
+        }
+        operators.Push(token.type);
+        return false;
+    }
+
+    constexpr Operand
+    Parse()
+    {
+        bool has_operand = false;
+        for (std::size_t index = 0; index < tokens.size && !builder->HasErr(); index += 1)
+        {
+            const auto& token = tokens[index];
+            has_operand = has_operand ? ParseOperator(token) : ParseOperand(token);
+        }
+
+        if (!builder->HasErr() && !has_operand)
+        {
+            builder->Err(ErrorCode::EXPECTED_OPERAND, EndOfSource(), Token<V>::EOFTOKEN);
+        }
+
+        while (!builder->HasErr() && !operators.IsEmpty())
+        {
+            if (operators.Top() == Token<V>::LPAREN)
+            {
+                builder->Err(ErrorCode::MISSING_PAREN, EndOfSource(), Token<V>::EOFTOKEN);
+            }
+            else
+            {
+                Reduce();
+            }
+        }
+
+        if (builder->HasErr())
+        {
+            return builder->MakeError();
+        }
+        else
+        {
+            assert(operands.size == 1);
+            return operands.Top();
+        }
+    }
+};
+
+
+#endif  // CALC_GRAMMAR_H
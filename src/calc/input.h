@@ -1,17 +1,17 @@
 #ifndef CALC_INPUT_H
 #define CALC_INPUT_H
 
-#include "calc/ints.h"
+#include <cstddef>
 
 
 template <typename T, typename C, typename Default, typename SizeProvider>
 struct Input
 {
     C input;
-    int next = 0;
+    std::size_t next = 0;
 
     // read a single char
-    T
+    constexpr T
     Read()
     {
         if (next >= SizeProvider::Size(input))
@@ -22,20 +22,20 @@ struct Input
         {
             const auto old = next;
             next += 1;
-            return input[ToSizet(old)];
+            return input[old];
         }
     }
 
     // returns true if we have reached eof and read/peek only return 0
-    [[nodiscard]] bool
+    [[nodiscard]] constexpr bool
     IsEof() const
     {
         return next >= SizeProvider::Size(input);
     }
 
     // look ahead 1 character
-    T
-    Peek(int advance = 0)
+    constexpr T
+    Peek(std::size_t advance = 0) const
     {
         if (next + advance >= SizeProvider::Size(input))
         {
@@ -43,7 +43,7 @@ struct Input
         }
         else
         {
-            return input[ToSizet(next + advance)];
+            return input[next + advance];
         }
     }
 };
@@ -3,12 +3,19 @@
 
 #include <cstddef>
 
-int
-ToInt(std::size_t i);
+// defined here so the lexer and parser input loops can inline them
 
-std::size_t
-ToSizet(int i);
+constexpr int
+ToInt(std::size_t i)
+{
+    return static_cast<int>(i);
+}
 
+constexpr std::size_t
+ToSizet(int i)
+{
+    return static_cast<std::size_t>(i);
+}
 
-#endif  // CALC_INTS_H
 
+#endif  // CALC_INTS_H
@@ -0,0 +1,317 @@
+#include "calc/jit.h"
+
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "calc/ints.h"
+#include "calc/vm.h"
+
+#if defined(CALC_ENABLE_JIT) && (defined(__x86_64__) || defined(_M_X64)) && \
+        (defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__))
+#define CALC_JIT
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+
+#ifdef CALC_JIT
+
+// the value stack is the native stack, programs that are deeper than this
+// are left to the vm instead of risking the stack of the caller
+constexpr int MAX_JIT_STACK_SIZE = 4096;
+
+
+// the code follows the system v abi, the variables are in rdi and the
+// result is returned in rax that also holds the top of the stack, rcx and
+// rdx are scratch registers
+struct Assembler
+{
+    std::vector<std::uint8_t> code;
+
+    void
+    Emit(std::initializer_list<std::uint8_t> bytes)
+    {
+        code.insert(code.end(), bytes);
+    }
+
+    void
+    EmitImm32(std::uint32_t value)
+    {
+        for (int shift = 0; shift < 32; shift += 8)
+        {
+            code.emplace_back(static_cast<std::uint8_t>(value >> shift));
+        }
+    }
+
+    void
+    EmitImm64(std::uint64_t value)
+    {
+        EmitImm32(static_cast<std::uint32_t>(value));
+        EmitImm32(static_cast<std::uint32_t>(value >> 32));
+    }
+
+    // the offset of the variable from rdi
+    void
+    EmitVariable(int index)
+    {
+        EmitImm32(static_cast<std::uint32_t>(index) * 8);
+    }
+
+    static bool
+    IsSignExtended32(std::uint64_t value)
+    {
+        const auto low = static_cast<std::uint64_t>(static_cast<std::int64_t>(static_cast<std::int32_t>(value)));
+        return low == value;
+    }
+
+    // register is 0 for rax and 1 for rcx, the shortest form is used
+    void
+    MoveImmediate(std::uint8_t reg, std::uint64_t value)
+    {
+        if (value <= 0xffffffff)
+        {
+            // mov r32, imm32 clears the high half
+            Emit({static_cast<std::uint8_t>(0xb8 + reg)});
+            EmitImm32(static_cast<std::uint32_t>(value));
+        }
+        else if (IsSignExtended32(value))
+        {
+            Emit({0x48, 0xc7, static_cast<std::uint8_t>(0xc0 + reg)});
+            EmitImm32(static_cast<std::uint32_t>(value));
+        }
+        else
+        {
+            Emit({0x48, static_cast<std::uint8_t>(0xb8 + reg)});
+            EmitImm64(value);
+        }
+    }
+
+    // and/or/xor of rax, the opcodes are the rax, imm32 form, the r/m64,
+    // r64 form and the r64, r/m64 form
+    struct Alu
+    {
+        std::uint8_t with_immediate;
+        std::uint8_t with_rcx;
+        std::uint8_t with_memory;
+    };
+
+    static constexpr Alu AND = {0x25, 0x21, 0x23};
+    static constexpr Alu OR = {0x0d, 0x09, 0x0b};
+    static constexpr Alu XOR = {0x35, 0x31, 0x33};
+
+    void
+    AluConstant(const Alu& alu, std::uint64_t value)
+    {
+        if (IsSignExtended32(value))
+        {
+            Emit({0x48, alu.with_immediate});
+            EmitImm32(static_cast<std::uint32_t>(value));
+        }
+        else
+        {
+            MoveImmediate(1, value);
+            Emit({0x48, alu.with_rcx, 0xc8});
+        }
+    }
+
+    void
+    AluVariable(const Alu& alu, int index)
+    {
+        Emit({0x48, alu.with_memory, 0x87});
+        EmitVariable(index);
+    }
+
+    void
+    AluStack(const Alu& alu, int* depth)
+    {
+        *depth -= 1;
+        // pop rcx
+        Emit({0x59});
+        Emit({0x48, alu.with_rcx, 0xc8});
+    }
+
+    // shl/shr is /4 and /5 in the modrm byte
+    void
+    ShiftConstant(bool left, std::uint64_t amount)
+    {
+        if (amount >= 64)
+        {
+            // xor eax, eax
+            Emit({0x31, 0xc0});
+        }
+        else if (amount > 0)
+        {
+            Emit({0x48, 0xc1, static_cast<std::uint8_t>(left ? 0xe0 : 0xe8), static_cast<std::uint8_t>(amount)});
+        }
+    }
+
+    // the cpu only uses the low 6 bits of cl, larger amounts are replaced
+    // with 0 afterwards to match the vm
+    void
+    ShiftByRcx(bool left)
+    {
+        // xor edx, edx
+        Emit({0x31, 0xd2});
+        // shl/shr rax, cl
+        Emit({0x48, 0xd3, static_cast<std::uint8_t>(left ? 0xe0 : 0xe8)});
+        // cmp rcx, 64
+        Emit({0x48, 0x83, 0xf9, 0x40});
+        // cmovae rax, rdx
+        Emit({0x48, 0x0f, 0x43, 0xc2});
+    }
+
+    // the vm stores the empty register on the first push, here that would
+    // leave a value on the native stack so only values are pushed
+    void
+    PushTop(int* depth)
+    {
+        if (*depth > 0)
+        {
+            // push rax
+            Emit({0x50});
+        }
+        *depth += 1;
+    }
+
+    void
+    Assemble(const Program<std::uint64_t>& program)
+    {
+        const auto constant = [&program](const Instruction& instruction) {
+            return program.constants[ToSizet(instruction.value)];
+        };
+
+        int depth = 0;
+        for (const auto& instruction: program.code)
+        {
+            switch (instruction.op)
+            {
+            case OpCode::PUSH:
+                PushTop(&depth);
+                MoveImmediate(0, constant(instruction));
+                break;
+            case OpCode::PUSH_VAR:
+                PushTop(&depth);
+                // mov rax, [rdi + offset]
+                Emit({0x48, 0x8b, 0x87});
+                EmitVariable(instruction.value);
+                break;
+            case OpCode::AND_CONST: AluConstant(AND, constant(instruction)); break;
+            case OpCode::OR_CONST: AluConstant(OR, constant(instruction)); break;
+            case OpCode::XOR_CONST: AluConstant(XOR, constant(instruction)); break;
+            case OpCode::SHL_CONST: ShiftConstant(true, constant(instruction)); break;
+            case OpCode::SHR_CONST: ShiftConstant(false, constant(instruction)); break;
+            case OpCode::AND_VAR: AluVariable(AND, instruction.value); break;
+            case OpCode::OR_VAR: AluVariable(OR, instruction.value); break;
+            case OpCode::XOR_VAR: AluVariable(XOR, instruction.value); break;
+            case OpCode::SHL_VAR:
+            case OpCode::SHR_VAR:
+                // mov rcx, [rdi + offset]
+                Emit({0x48, 0x8b, 0x8f});
+                EmitVariable(instruction.value);
+                ShiftByRcx(instruction.op == OpCode::SHL_VAR);
+                break;
+            case OpCode::AND: AluStack(AND, &depth); break;
+            case OpCode::OR: AluStack(OR, &depth); break;
+            case OpCode::XOR: AluStack(XOR, &depth); break;
+            case OpCode::SHL:
+            case OpCode::SHR:
+                // the amount is the top, mov rcx, rax and pop rax
+                Emit({0x48, 0x89, 0xc1, 0x58});
+                depth -= 1;
+                ShiftByRcx(instruction.op == OpCode::SHL);
+                break;
+            case OpCode::NOT:
+                // not rax
+                Emit({0x48, 0xf7, 0xd0});
+                break;
+            }
+        }
+
+        // everything that was pushed has been popped, ret
+        Emit({0xc3});
+    }
+};
+
+#endif
+
+
+JitProgram::JitProgram(Program<std::uint64_t> p) : program(std::move(p))
+{
+#ifdef CALC_JIT
+    if (program.stack_size > MAX_JIT_STACK_SIZE)
+    {
+        return;
+    }
+
+    Assembler assembler;
+    assembler.Assemble(program);
+
+    const auto page_size = ToSizet(static_cast<int>(sysconf(_SC_PAGESIZE)));
+    const auto size = (assembler.code.size() + page_size - 1) / page_size * page_size;
+    void* mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapped == MAP_FAILED)
+    {
+        return;
+    }
+
+    // never writable and executable at the same time
+    std::memcpy(mapped, assembler.code.data(), assembler.code.size());
+    if (mprotect(mapped, size, PROT_READ | PROT_EXEC) != 0)
+    {
+        munmap(mapped, size);
+        return;
+    }
+
+    memory = mapped;
+    memory_size = size;
+    std::memcpy(&function, &memory, sizeof(function));
+#endif
+}
+
+
+JitProgram::~JitProgram()
+{
+#ifdef CALC_JIT
+    if (memory != nullptr)
+    {
+        munmap(memory, memory_size);
+    }
+#endif
+}
+
+
+[[nodiscard]] bool
+JitProgram::IsSupported()
+{
+#ifdef CALC_JIT
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+[[nodiscard]] bool
+JitProgram::IsNative() const
+{
+    return function != nullptr;
+}
+
+
+[[nodiscard]] std::uint64_t
+JitProgram::Run(const std::uint64_t* variables) const
+{
+    if (function != nullptr)
+    {
+        return function(variables);
+    }
+    return RunProgram(program, variables);
+}
+
+
+[[nodiscard]] const Program<std::uint64_t>&
+JitProgram::GetProgram() const
+{
+    return program;
+}
@@ -0,0 +1,54 @@
+#ifndef CALC_JIT_H
+#define CALC_JIT_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "calc/program.h"
+
+
+// a 64 bit program compiled to native x86-64 code, the top of the stack is
+// kept in a register, constants are immediates and variables are read
+// straight from the array that is passed in a register
+//
+// the jit is only built for x86-64 unix and when ENABLE_JIT is set, when it
+// isn't or the code can't be made executable the vm runs the program
+struct JitProgram
+{
+    explicit JitProgram(Program<std::uint64_t> p);
+    ~JitProgram();
+
+    JitProgram(const JitProgram&) = delete;
+    JitProgram(JitProgram&&) = delete;
+    void
+    operator=(const JitProgram&) = delete;
+    void
+    operator=(JitProgram&&) = delete;
+
+    // true if this build can generate native code at all
+    [[nodiscard]] static bool
+    IsSupported();
+
+    // true if Run calls native code, false if it falls back to the vm
+    [[nodiscard]] bool
+    IsNative() const;
+
+    // variables are indexed like the program variables
+    [[nodiscard]] std::uint64_t
+    Run(const std::uint64_t* variables) const;
+
+    [[nodiscard]] const Program<std::uint64_t>&
+    GetProgram() const;
+
+private:
+    using Function = std::uint64_t (*)(const std::uint64_t* variables);
+
+    Program<std::uint64_t> program;
+
+    void* memory = nullptr;
+    std::size_t memory_size = 0;
+    Function function = nullptr;
+};
+
+
+#endif  // CALC_JIT_H
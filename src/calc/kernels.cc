@@ -0,0 +1,371 @@
+#include "calc/kernels.h"
+
+// sse2 is part of x86-64 so it can always be used there, avx2 needs a
+// runtime check and that is only implemented for gcc and clang
+#if defined(__x86_64__) || defined(_M_X64)
+#define CALC_SSE2_KERNELS
+#include <immintrin.h>
+#if defined(__GNUC__)
+#define CALC_AVX2_KERNELS
+#endif
+#endif
+
+
+///////////////////////////////////////////////////////////////////////////////
+// scalar
+
+void
+ScalarAndConst(std::uint64_t* dst, std::uint64_t value, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; i += 1)
+    {
+        dst[i] &= value;
+    }
+}
+
+
+void
+ScalarOrConst(std::uint64_t* dst, std::uint64_t value, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; i += 1)
+    {
+        dst[i] |= value;
+    }
+}
+
+
+void
+ScalarXorConst(std::uint64_t* dst, std::uint64_t value, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; i += 1)
+    {
+        dst[i] ^= value;
+    }
+}
+
+
+void
+ScalarAndArray(std::uint64_t* dst, const std::uint64_t* src, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; i += 1)
+    {
+        dst[i] &= src[i];
+    }
+}
+
+
+void
+ScalarOrArray(std::uint64_t* dst, const std::uint64_t* src, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; i += 1)
+    {
+        dst[i] |= src[i];
+    }
+}
+
+
+void
+ScalarXorArray(std::uint64_t* dst, const std::uint64_t* src, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; i += 1)
+    {
+        dst[i] ^= src[i];
+    }
+}
+
+
+const BatchKernels&
+ScalarKernels()
+{
+    static const auto kernels = BatchKernels{
+            "scalar",
+            ScalarAndConst,
+            ScalarOrConst,
+            ScalarXorConst,
+            ScalarAndArray,
+            ScalarOrArray,
+            ScalarXorArray};
+    return kernels;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// sse2
+
+#ifdef CALC_SSE2_KERNELS
+
+__m128i
+Sse2Load(const std::uint64_t* src)
+{
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+}
+
+
+void
+Sse2Store(std::uint64_t* dst, __m128i value)
+{
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), value);
+}
+
+
+void
+Sse2AndConst(std::uint64_t* dst, std::uint64_t value, std::size_t count)
+{
+    const auto v = _mm_set1_epi64x(static_cast<long long>(value));
+    std::size_t i = 0;
+    for (; i + 2 <= count; i += 2)
+    {
+        Sse2Store(dst + i, _mm_and_si128(Sse2Load(dst + i), v));
+    }
+    ScalarAndConst(dst + i, value, count - i);
+}
+
+
+void
+Sse2OrConst(std::uint64_t* dst, std::uint64_t value, std::size_t count)
+{
+    const auto v = _mm_set1_epi64x(static_cast<long long>(value));
+    std::size_t i = 0;
+    for (; i + 2 <= count; i += 2)
+    {
+        Sse2Store(dst + i, _mm_or_si128(Sse2Load(dst + i), v));
+    }
+    ScalarOrConst(dst + i, value, count - i);
+}
+
+
+void
+Sse2XorConst(std::uint64_t* dst, std::uint64_t value, std::size_t count)
+{
+    const auto v = _mm_set1_epi64x(static_cast<long long>(value));
+    std::size_t i = 0;
+    for (; i + 2 <= count; i += 2)
+    {
+        Sse2Store(dst + i, _mm_xor_si128(Sse2Load(dst + i), v));
+    }
+    ScalarXorConst(dst + i, value, count - i);
+}
+
+
+void
+Sse2AndArray(std::uint64_t* dst, const std::uint64_t* src, std::size_t count)
+{
+    std::size_t i = 0;
+    for (; i + 2 <= count; i += 2)
+    {
+        Sse2Store(dst + i, _mm_and_si128(Sse2Load(dst + i), Sse2Load(src + i)));
+    }
+    ScalarAndArray(dst + i, src + i, count - i);
+}
+
+
+void
+Sse2OrArray(std::uint64_t* dst, const std::uint64_t* src, std::size_t count)
+{
+    std::size_t i = 0;
+    for (; i + 2 <= count; i += 2)
+    {
+        Sse2Store(dst + i, _mm_or_si128(Sse2Load(dst + i), Sse2Load(src + i)));
+    }
+    ScalarOrArray(dst + i, src + i, count - i);
+}
+
+
+void
+Sse2XorArray(std::uint64_t* dst, const std::uint64_t* src, std::size_t count)
+{
+    std::size_t i = 0;
+    for (; i + 2 <= count; i += 2)
+    {
+        Sse2Store(dst + i, _mm_xor_si128(Sse2Load(dst + i), Sse2Load(src + i)));
+    }
+    ScalarXorArray(dst + i, src + i, count - i);
+}
+
+
+const BatchKernels&
+Sse2Kernels()
+{
+    static const auto kernels = BatchKernels{
+            "sse2",
+            Sse2AndConst,
+            Sse2OrConst,
+            Sse2XorConst,
+            Sse2AndArray,
+            Sse2OrArray,
+            Sse2XorArray};
+    return kernels;
+}
+
+#endif
+
+
+///////////////////////////////////////////////////////////////////////////////
+// avx2
+
+#ifdef CALC_AVX2_KERNELS
+
+#define CALC_TARGET_AVX2 __attribute__((target("avx2")))
+
+CALC_TARGET_AVX2 __m256i
+Avx2Load(const std::uint64_t* src)
+{
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+}
+
+
+CALC_TARGET_AVX2 void
+Avx2Store(std::uint64_t* dst, __m256i value)
+{
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), value);
+}
+
+
+// all avx2 loops are unrolled twice so two loads can be in flight and
+// large columns are limited by memory rather than by the loop itself
+
+CALC_TARGET_AVX2 void
+Avx2AndConst(std::uint64_t* dst, std::uint64_t value, std::size_t count)
+{
+    const auto v = _mm256_set1_epi64x(static_cast<long long>(value));
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const auto a = Avx2Load(dst + i);
+        const auto b = Avx2Load(dst + i + 4);
+        Avx2Store(dst + i, _mm256_and_si256(a, v));
+        Avx2Store(dst + i + 4, _mm256_and_si256(b, v));
+    }
+    ScalarAndConst(dst + i, value, count - i);
+}
+
+
+CALC_TARGET_AVX2 void
+Avx2OrConst(std::uint64_t* dst, std::uint64_t value, std::size_t count)
+{
+    const auto v = _mm256_set1_epi64x(static_cast<long long>(value));
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const auto a = Avx2Load(dst + i);
+        const auto b = Avx2Load(dst + i + 4);
+        Avx2Store(dst + i, _mm256_or_si256(a, v));
+        Avx2Store(dst + i + 4, _mm256_or_si256(b, v));
+    }
+    ScalarOrConst(dst + i, value, count - i);
+}
+
+
+CALC_TARGET_AVX2 void
+Avx2XorConst(std::uint64_t* dst, std::uint64_t value, std::size_t count)
+{
+    const auto v = _mm256_set1_epi64x(static_cast<long long>(value));
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const auto a = Avx2Load(dst + i);
+        const auto b = Avx2Load(dst + i + 4);
+        Avx2Store(dst + i, _mm256_xor_si256(a, v));
+        Avx2Store(dst + i + 4, _mm256_xor_si256(b, v));
+    }
+    ScalarXorConst(dst + i, value, count - i);
+}
+
+
+CALC_TARGET_AVX2 void
+Avx2AndArray(std::uint64_t* dst, const std::uint64_t* src, std::size_t count)
+{
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const auto a = _mm256_and_si256(Avx2Load(dst + i), Avx2Load(src + i));
+        const auto b = _mm256_and_si256(Avx2Load(dst + i + 4), Avx2Load(src + i + 4));
+        Avx2Store(dst + i, a);
+        Avx2Store(dst + i + 4, b);
+    }
+    ScalarAndArray(dst + i, src + i, count - i);
+}
+
+
+CALC_TARGET_AVX2 void
+Avx2OrArray(std::uint64_t* dst, const std::uint64_t* src, std::size_t count)
+{
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const auto a = _mm256_or_si256(Avx2Load(dst + i), Avx2Load(src + i));
+        const auto b = _mm256_or_si256(Avx2Load(dst + i + 4), Avx2Load(src + i + 4));
+        Avx2Store(dst + i, a);
+        Avx2Store(dst + i + 4, b);
+    }
+    ScalarOrArray(dst + i, src + i, count - i);
+}
+
+
+CALC_TARGET_AVX2 void
+Avx2XorArray(std::uint64_t* dst, const std::uint64_t* src, std::size_t count)
+{
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const auto a = _mm256_xor_si256(Avx2Load(dst + i), Avx2Load(src + i));
+        const auto b = _mm256_xor_si256(Avx2Load(dst + i + 4), Avx2Load(src + i + 4));
+        Avx2Store(dst + i, a);
+        Avx2Store(dst + i + 4, b);
+    }
+    ScalarXorArray(dst + i, src + i, count - i);
+}
+
+
+const BatchKernels&
+Avx2Kernels()
+{
+    static const auto kernels = BatchKernels{
+            "avx2",
+            Avx2AndConst,
+            Avx2OrConst,
+            Avx2XorConst,
+            Avx2AndArray,
+            Avx2OrArray,
+            Avx2XorArray};
+    return kernels;
+}
+
+
+bool
+HasAvx2()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+}
+
+#endif
+
+
+///////////////////////////////////////////////////////////////////////////////
+// dispatch
+
+std::vector<const BatchKernels*>
+AvailableKernels()
+{
+    std::vector<const BatchKernels*> kernels;
+    kernels.emplace_back(&ScalarKernels());
+#ifdef CALC_SSE2_KERNELS
+    kernels.emplace_back(&Sse2Kernels());
+#endif
+#ifdef CALC_AVX2_KERNELS
+    if (HasAvx2())
+    {
+        kernels.emplace_back(&Avx2Kernels());
+    }
+#endif
+    return kernels;
+}
+
+
+const BatchKernels&
+BestKernels()
+{
+    static const BatchKernels* best = AvailableKernels().back();
+    return *best;
+}
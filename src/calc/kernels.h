@@ -0,0 +1,39 @@
+#ifndef CALC_KERNELS_H
+#define CALC_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+// the inner loops of batch evaluation, all operate in place on dst
+struct BatchKernels
+{
+    const char* name;
+
+    void (*and_const)(std::uint64_t* dst, std::uint64_t value, std::size_t count);
+    void (*or_const)(std::uint64_t* dst, std::uint64_t value, std::size_t count);
+    void (*xor_const)(std::uint64_t* dst, std::uint64_t value, std::size_t count);
+
+    void (*and_array)(std::uint64_t* dst, const std::uint64_t* src, std::size_t count);
+    void (*or_array)(std::uint64_t* dst, const std::uint64_t* src, std::size_t count);
+    void (*xor_array)(std::uint64_t* dst, const std::uint64_t* src, std::size_t count);
+};
+
+
+// plain loops that work everywhere
+const BatchKernels&
+ScalarKernels();
+
+
+// all kernels that the current cpu can run, scalar first
+std::vector<const BatchKernels*>
+AvailableKernels();
+
+
+// the fastest kernels the current cpu can run, detected once
+const BatchKernels&
+BestKernels();
+
+
+#endif  // CALC_KERNELS_H
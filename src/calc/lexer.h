@@ -2,15 +2,24 @@
 #define CALC_LEXER_H
 
 #include <vector>
-#include <string>
+#include <string_view>
 
 #include "calc/token.h"
 
 struct ErrorHandler;
 
 
-std::vector<Token>
-RunLexer(const std::string& source, ErrorHandler* errors);
+// the tokens point into the source so it must outlive them, numbers that
+// doesn't fit in V are errors
+template <typename V>
+std::vector<Token<V>>
+RunLexer(std::string_view source, ErrorHandler* errors);
+
+
+// same as above but reuses the memory of a existing token list
+template <typename V>
+void
+RunLexer(std::string_view source, ErrorHandler* errors, std::vector<Token<V>>* tokens);
 
 #endif  // CALC_LEXER_H
 
@@ -0,0 +1,163 @@
+#include "calc/linereader.h"
+
+#include <cstring>
+
+#if defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__)
+#define CALC_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+constexpr std::size_t LINE_READER_BUFFER_SIZE = 64 * 1024;
+
+// the memory of a mapped file is given back in steps this large, smaller
+// steps would mostly cost system calls
+constexpr std::size_t LINE_READER_RELEASE_SIZE = 16 * 1024 * 1024;
+
+
+LineReader::LineReader(std::FILE* f, bool allow_map) : file(f)
+{
+    if (!allow_map || !Map())
+    {
+        buffer.resize(LINE_READER_BUFFER_SIZE);
+    }
+}
+
+
+LineReader::~LineReader()
+{
+#ifdef CALC_MMAP
+    if (mapped != nullptr)
+    {
+        munmap(const_cast<char*>(mapped), mapped_size);
+    }
+#endif
+}
+
+
+bool
+LineReader::Map()
+{
+#ifdef CALC_MMAP
+    const int fd = fileno(file);
+    struct stat status = {};
+    if (fd < 0 || fstat(fd, &status) != 0 || !S_ISREG(status.st_mode) || status.st_size <= 0)
+    {
+        return false;
+    }
+
+    // the file is mapped from where it has been read to
+    const auto offset = ftello(file);
+    if (offset != 0)
+    {
+        return false;
+    }
+
+    const auto size = static_cast<std::size_t>(status.st_size);
+    void* memory = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (memory == MAP_FAILED)
+    {
+        return false;
+    }
+    madvise(memory, size, MADV_SEQUENTIAL);
+
+    mapped = static_cast<const char*>(memory);
+    mapped_size = size;
+    end = size;
+    eof = true;
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+[[nodiscard]] bool
+LineReader::IsMapped() const
+{
+    return mapped != nullptr;
+}
+
+
+void
+LineReader::Release()
+{
+#ifdef CALC_MMAP
+    if (mapped == nullptr || start - released < LINE_READER_RELEASE_SIZE)
+    {
+        return;
+    }
+
+    // only whole pages before the current line
+    const auto page_size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    const auto release_end = start / page_size * page_size;
+    madvise(const_cast<char*>(mapped) + released, release_end - released, MADV_DONTNEED);
+    released = release_end;
+#endif
+}
+
+
+bool
+LineReader::Next(std::string_view* line)
+{
+    const char* data = mapped != nullptr ? mapped : buffer.data();
+    while (true)
+    {
+        const auto* first = data + start;
+        const auto* newline = static_cast<const char*>(std::memchr(first, '\n', end - start));
+        if (newline != nullptr)
+        {
+            auto length = static_cast<std::size_t>(newline - first);
+            start += length + 1;
+            if (length > 0 && first[length - 1] == '\r')
+            {
+                length -= 1;
+            }
+            *line = std::string_view{first, length};
+            return true;
+        }
+
+        if (eof)
+        {
+            if (start == end)
+            {
+                return false;
+            }
+
+            // the last line didn't end with a newline
+            *line = std::string_view{first, end - start};
+            start = end;
+            return true;
+        }
+
+        Fill();
+        data = buffer.data();
+    }
+}
+
+
+void
+LineReader::Fill()
+{
+    // move the partial line to the front, and if it already fills the
+    // whole buffer make room for a longer line
+    if (start > 0)
+    {
+        std::memmove(buffer.data(), buffer.data() + start, end - start);
+        end -= start;
+        start = 0;
+    }
+    if (end == buffer.size())
+    {
+        buffer.resize(buffer.size() * 2);
+    }
+
+    const auto read = std::fread(buffer.data() + end, 1, buffer.size() - end, file);
+    end += read;
+    if (read == 0)
+    {
+        eof = true;
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef CALC_LINEREADER_H
+#define CALC_LINEREADER_H
+
+#include <cstdio>
+#include <string_view>
+#include <vector>
+
+
+// reads a file a large chunk at a time and splits it into lines, memory
+// use only depends on the longest line and not on the size of the file
+//
+// regular files are memory mapped instead so the lines point into the
+// file without copying them, pipes and terminals are read in chunks
+struct LineReader
+{
+    explicit LineReader(std::FILE* f, bool allow_map = true);
+    ~LineReader();
+
+    LineReader(const LineReader&) = delete;
+    LineReader(LineReader&&) = delete;
+    void
+    operator=(const LineReader&) = delete;
+    void
+    operator=(LineReader&&) = delete;
+
+    // false when there are no more lines, the line doesn't include the line
+    // ending and is only valid until the next call, unless the file is mapped
+    bool
+    Next(std::string_view* line);
+
+    // true if the lines stay valid until Release instead of only until the
+    // next line is read
+    [[nodiscard]] bool
+    IsMapped() const;
+
+    // the lines that have been read are no longer used, a mapped file gives
+    // back their memory so it doesn't grow with the size of the file
+    void
+    Release();
+
+private:
+    std::FILE* file;
+    std::vector<char> buffer;
+    std::size_t start = 0;
+    std::size_t end = 0;
+    bool eof = false;
+
+    // the mapped file, the lines before released are given back
+    const char* mapped = nullptr;
+    std::size_t mapped_size = 0;
+    std::size_t released = 0;
+
+    void
+    Fill();
+
+    bool
+    Map();
+};
+
+
+#endif  // CALC_LINEREADER_H
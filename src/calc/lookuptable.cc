@@ -0,0 +1,67 @@
+#include "calc/lookuptable.h"
+
+#include <utility>
+#include <vector>
+
+#include "calc/vm.h"
+
+
+// costs in the time of running one vm instruction, a call of the vm has a
+// fixed cost on top of its instructions and a load from the table costs
+// about as much as a instruction, a entry of the table is filled with a
+// call of the vm
+constexpr std::uint64_t CALL_COST = 4;
+constexpr std::uint64_t LOAD_COST = 1;
+
+
+template <typename V>
+[[nodiscard]] bool
+ShouldTabulate(const Program<V>& program, std::uint64_t expected_calls)
+{
+    if constexpr (CAN_TABULATE<V>)
+    {
+        if (program.variables.size() != 1 || !program.table.empty())
+        {
+            return false;
+        }
+
+        // the table pays for itself after a bit more than one call for
+        // each of its entries
+        const auto call_cost = CALL_COST + std::uint64_t{program.code.size()};
+        const auto fill_cost = (std::uint64_t{1} << BIT_WIDTH<V>) * call_cost;
+        return expected_calls >= fill_cost / (call_cost - LOAD_COST);
+    }
+    return false;
+}
+
+
+template <typename V>
+void
+TabulateProgram(Program<V>* program)
+{
+    if constexpr (CAN_TABULATE<V>)
+    {
+        if (program->variables.size() != 1)
+        {
+            return;
+        }
+
+        // the program is run without a table while the table is filled
+        constexpr auto table_size = std::size_t{1} << BIT_WIDTH<V>;
+        auto table = std::vector<V>(table_size);
+        program->table.clear();
+        for (std::size_t value = 0; value < table_size; value += 1)
+        {
+            const auto variable = static_cast<V>(value);
+            table[value] = RunProgram(*program, &variable);
+        }
+        program->table = std::move(table);
+    }
+}
+
+
+#define INSTANTIATE(V) \
+    template bool ShouldTabulate(const Program<V>& program, std::uint64_t expected_calls); \
+    template void TabulateProgram(Program<V>* program);
+CALC_FOR_EACH_VALUE(INSTANTIATE)
+#undef INSTANTIATE
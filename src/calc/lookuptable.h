@@ -0,0 +1,34 @@
+#ifndef CALC_LOOKUPTABLE_H
+#define CALC_LOOKUPTABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "calc/program.h"
+#include "calc/value.h"
+
+// a expression of one variable that is at most this wide has few enough
+// inputs that its result for every input fits in a table
+constexpr std::size_t MAX_TABLE_BITS = 16;
+
+template <typename V>
+constexpr bool CAN_TABULATE = std::is_unsigned_v<V> && BIT_WIDTH<V> <= MAX_TABLE_BITS;
+
+
+// the cost model, true if filling the table of the program pays for itself
+// within the expected number of calls, never true for a program that
+// can't be tabulated
+template <typename V>
+[[nodiscard]] bool
+ShouldTabulate(const Program<V>& program, std::uint64_t expected_calls);
+
+
+// fills the table of the program with its result for every value of its
+// variable, programs that can't be tabulated are left as they are
+template <typename V>
+void
+TabulateProgram(Program<V>* program);
+
+
+#endif  // CALC_LOOKUPTABLE_H
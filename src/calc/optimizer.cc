@@ -0,0 +1,542 @@
+#include "calc/optimizer.h"
+
+#include <algorithm>
+#include <iterator>
+#include <typeinfo>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "calc/value.h"
+
+
+// true if the nodes are of the same type and the same number or variable,
+// the operands are not compared
+template <typename V>
+[[nodiscard]] bool
+IsSameNode(const Node<V>& lhs, const Node<V>& rhs)
+{
+    if (typeid(lhs) != typeid(rhs))
+    {
+        return false;
+    }
+    if (typeid(lhs) == typeid(NumberNode<V>))
+    {
+        return static_cast<const NumberNode<V>&>(lhs).value == static_cast<const NumberNode<V>&>(rhs).value;
+    }
+    if (typeid(lhs) == typeid(VariableNode<V>))
+    {
+        return static_cast<const VariableNode<V>&>(lhs).index == static_cast<const VariableNode<V>&>(rhs).index;
+    }
+    return typeid(lhs) != typeid(ErrorNode<V>);
+}
+
+
+template <typename T, typename V>
+[[nodiscard]] bool
+AppendChainPairs(
+        const Node<V>& lhs,
+        const Node<V>& rhs,
+        std::vector<std::pair<const Node<V>*, const Node<V>*>>* pairs)
+{
+    const auto& left = static_cast<const T&>(lhs).operands;
+    const auto& right = static_cast<const T&>(rhs).operands;
+    if (left.size != right.size)
+    {
+        return false;
+    }
+    for (std::size_t i = 0; i < left.size; i += 1)
+    {
+        pairs->emplace_back(left[i], right[i]);
+    }
+    return true;
+}
+
+
+// appends the operands of two nodes of the same type as pairs, false if
+// they have a different number of operands
+template <typename V>
+[[nodiscard]] bool
+AppendOperandPairs(
+        const Node<V>& lhs,
+        const Node<V>& rhs,
+        std::vector<std::pair<const Node<V>*, const Node<V>*>>* pairs)
+{
+    if (typeid(lhs) == typeid(AndNode<V>))
+    {
+        return AppendChainPairs<AndNode<V>>(lhs, rhs, pairs);
+    }
+    if (typeid(lhs) == typeid(OrNode<V>))
+    {
+        return AppendChainPairs<OrNode<V>>(lhs, rhs, pairs);
+    }
+    if (typeid(lhs) == typeid(XorNode<V>))
+    {
+        return AppendChainPairs<XorNode<V>>(lhs, rhs, pairs);
+    }
+    if (typeid(lhs) == typeid(NotNode<V>))
+    {
+        pairs->emplace_back(static_cast<const NotNode<V>&>(lhs).operand, static_cast<const NotNode<V>&>(rhs).operand);
+    }
+    else if (typeid(lhs) == typeid(ShiftLeftNode<V>))
+    {
+        const auto& left = static_cast<const ShiftLeftNode<V>&>(lhs);
+        const auto& right = static_cast<const ShiftLeftNode<V>&>(rhs);
+        pairs->emplace_back(left.lhs, right.lhs);
+        pairs->emplace_back(left.rhs, right.rhs);
+    }
+    else if (typeid(lhs) == typeid(ShiftRightNode<V>))
+    {
+        const auto& left = static_cast<const ShiftRightNode<V>&>(lhs);
+        const auto& right = static_cast<const ShiftRightNode<V>&>(rhs);
+        pairs->emplace_back(left.lhs, right.lhs);
+        pairs->emplace_back(left.rhs, right.rhs);
+    }
+    return true;
+}
+
+
+template <typename V>
+[[nodiscard]] bool
+IsSameTree(const Node<V>& lhs, const Node<V>& rhs)
+{
+    // most compared nodes are numbers and variables or differ at the top,
+    // those don't need the stack
+    if (!IsSameNode(lhs, rhs))
+    {
+        return false;
+    }
+    if (typeid(lhs) == typeid(NumberNode<V>) || typeid(lhs) == typeid(VariableNode<V>))
+    {
+        return true;
+    }
+
+    // the pairs of nodes that are left to compare, with a explicit stack
+    // since trees can be many thousands of levels deep
+    auto pending = std::vector<std::pair<const Node<V>*, const Node<V>*>>{{&lhs, &rhs}};
+    while (!pending.empty())
+    {
+        const auto [left, right] = pending.back();
+        pending.pop_back();
+        if (!IsSameNode(*left, *right) || !AppendOperandPairs(*left, *right, &pending))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+// the operands of a and/or chain that is being built
+template <typename V>
+struct Operands
+{
+    std::vector<Node<V>*> nodes;
+
+    // variables are by far the most common operand, so they are looked up
+    // by index instead of being compared against every other operand
+    std::unordered_set<int> variables;
+
+    [[nodiscard]] bool
+    Contains(const Node<V>& node) const
+    {
+        if (const auto* variable = dynamic_cast<const VariableNode<V>*>(&node))
+        {
+            return variables.find(variable->index) != variables.end();
+        }
+        return std::any_of(
+                nodes.begin(),
+                nodes.end(),
+                [&node](Node<V>* n) {
+                    return IsSameTree(*n, node);
+                });
+    }
+
+    void
+    Add(Node<V>* node)
+    {
+        // x & x and x | x are both x
+        if (Contains(*node))
+        {
+            return;
+        }
+        if (const auto* variable = dynamic_cast<const VariableNode<V>*>(node))
+        {
+            variables.emplace(variable->index);
+        }
+        nodes.emplace_back(node);
+    }
+};
+
+
+template <typename Other, typename V>
+[[nodiscard]] bool
+IsAbsorbed(Node<V>* node, const Operands<V>& operands)
+{
+    const auto* other = dynamic_cast<const Other*>(node);
+    if (other == nullptr)
+    {
+        return false;
+    }
+    return std::any_of(
+            other->operands.begin(),
+            other->operands.end(),
+            [&operands](Node<V>* n) {
+                return operands.Contains(*n);
+            });
+}
+
+
+// the operands of a node are optimized before the node itself, a node that
+// doesn't change is optimized to null so the tree is only copied where it
+// changes
+template <typename V>
+struct Optimizer
+{
+    AstArena* arena;
+    bool boolean;
+    std::vector<Node<V>*> pending;
+
+    // a boolean shifted by 0 is itself and shifted by 1 is 0
+    static void
+    ClearIf(V* value, const V& condition)
+    {
+        *value &= Complement(condition);
+    }
+
+    // the operands of a node that are optimized before the node
+    void
+    AppendOptimizedOperands(const Node<V>& node, std::vector<Node<V>*>* operands)
+    {
+        if (typeid(node) == typeid(AndNode<V>))
+        {
+            AppendChain(static_cast<const AndNode<V>&>(node), operands);
+        }
+        else if (typeid(node) == typeid(OrNode<V>))
+        {
+            AppendChain(static_cast<const OrNode<V>&>(node), operands);
+        }
+        else if (typeid(node) == typeid(XorNode<V>))
+        {
+            AppendChain(static_cast<const XorNode<V>&>(node), operands);
+        }
+        else
+        {
+            node.AppendOperands(operands);
+        }
+    }
+
+    // (a & b) & c is a & b & c, nested chains of the same type are expanded
+    // before their operands are optimized so long chains aren't copied once
+    // for every level
+    template <typename Same>
+    void
+    AppendChain(const Same& chain, std::vector<Node<V>*>* operands)
+    {
+        for (auto* first: chain.operands)
+        {
+            if (dynamic_cast<const Same*>(first) == nullptr)
+            {
+                operands->emplace_back(first);
+                continue;
+            }
+
+            pending.emplace_back(first);
+            while (!pending.empty())
+            {
+                const auto operand = pending.back();
+                pending.pop_back();
+
+                if (const auto* same = dynamic_cast<const Same*>(operand))
+                {
+                    pending.insert(
+                            pending.end(),
+                            std::make_reverse_iterator(same->operands.end()),
+                            std::make_reverse_iterator(same->operands.begin()));
+                    continue;
+                }
+                operands->emplace_back(operand);
+            }
+        }
+    }
+
+    Node<V>*
+    Optimize(const Node<V>& node, Span<Node<V>*> operands)
+    {
+        if (dynamic_cast<const AndNode<V>*>(&node) != nullptr)
+        {
+            return OptimizeChain<AndNode<V>, OrNode<V>>(
+                    operands,
+                    AllBits<V>(),
+                    V{},
+                    [](V* lhs, const V& rhs) { *lhs &= rhs; });
+        }
+        if (dynamic_cast<const OrNode<V>*>(&node) != nullptr)
+        {
+            return OptimizeChain<OrNode<V>, AndNode<V>>(
+                    operands,
+                    V{},
+                    AllBits<V>(),
+                    [](V* lhs, const V& rhs) { *lhs |= rhs; });
+        }
+        if (dynamic_cast<const XorNode<V>*>(&node) != nullptr)
+        {
+            return OptimizeXor(operands);
+        }
+        if (const auto* complement = dynamic_cast<const NotNode<V>*>(&node))
+        {
+            return OptimizeNot(*complement, operands[0]);
+        }
+        if (const auto* shift = dynamic_cast<const ShiftLeftNode<V>*>(&node))
+        {
+            return OptimizeShift(*shift, operands[0], operands[1], [this](V* lhs, const V& rhs) {
+                if (boolean)
+                {
+                    ClearIf(lhs, rhs);
+                }
+                else
+                {
+                    ShiftLeft(lhs, rhs);
+                }
+            });
+        }
+        if (const auto* shift = dynamic_cast<const ShiftRightNode<V>*>(&node))
+        {
+            return OptimizeShift(*shift, operands[0], operands[1], [this](V* lhs, const V& rhs) {
+                if (boolean)
+                {
+                    ClearIf(lhs, rhs);
+                }
+                else
+                {
+                    ShiftRight(lhs, rhs);
+                }
+            });
+        }
+        return nullptr;
+    }
+
+    Node<V>*
+    OptimizeNot(const NotNode<V>& node, Node<V>* operand)
+    {
+        if (const auto* number = dynamic_cast<const NumberNode<V>*>(operand))
+        {
+            return arena->Make<NumberNode<V>>(Complement(number->value));
+        }
+        // ~~x is x
+        if (const auto* complement = dynamic_cast<const NotNode<V>*>(operand))
+        {
+            return complement->operand;
+        }
+        if (operand == node.operand)
+        {
+            return nullptr;
+        }
+        return arena->Make<NotNode<V>>(operand);
+    }
+
+    template <typename Shift, typename Fold>
+    Node<V>*
+    OptimizeShift(const Shift& node, Node<V>* lhs, Node<V>* rhs, Fold fold)
+    {
+        const auto* lhs_number = dynamic_cast<const NumberNode<V>*>(lhs);
+        const auto* rhs_number = dynamic_cast<const NumberNode<V>*>(rhs);
+        if (lhs_number != nullptr && rhs_number != nullptr)
+        {
+            V value = lhs_number->value;
+            fold(&value, rhs_number->value);
+            return arena->Make<NumberNode<V>>(value);
+        }
+        // 0 shifted is still 0 and x shifted by 0 is x
+        if (lhs_number != nullptr && lhs_number->value == V{})
+        {
+            return lhs;
+        }
+        if (rhs_number != nullptr && rhs_number->value == V{})
+        {
+            return lhs;
+        }
+        if (lhs == node.lhs && rhs == node.rhs)
+        {
+            return nullptr;
+        }
+        return arena->Make<Shift>(lhs, rhs);
+    }
+
+    // x ^ x is 0 so equal operands cancel out in pairs instead of being
+    // merged like in the and/or chains
+    Node<V>*
+    OptimizeXor(Span<Node<V>*> source)
+    {
+        // cancelled operands are set to null and removed at the end
+        auto nodes = std::vector<Node<V>*>{};
+        auto variables = std::unordered_map<int, std::size_t>{};
+        V constant{};
+
+        const auto add = [&](Node<V>* node) {
+            if (const auto* number = dynamic_cast<const NumberNode<V>*>(node))
+            {
+                constant ^= number->value;
+                return;
+            }
+            if (const auto* variable = dynamic_cast<const VariableNode<V>*>(node))
+            {
+                const auto [found, inserted] = variables.emplace(variable->index, nodes.size());
+                if (!inserted)
+                {
+                    nodes[found->second] = nodes[found->second] == nullptr ? node : nullptr;
+                    return;
+                }
+            }
+            else
+            {
+                const auto same = std::find_if(
+                        nodes.begin(),
+                        nodes.end(),
+                        [node](Node<V>* n) {
+                            return n != nullptr && IsSameTree(*n, *node);
+                        });
+                if (same != nodes.end())
+                {
+                    *same = nullptr;
+                    return;
+                }
+            }
+            nodes.emplace_back(node);
+        };
+
+        for (auto* optimized: source)
+        {
+            if (const auto* same = dynamic_cast<const XorNode<V>*>(optimized))
+            {
+                for (const auto& inner: same->operands)
+                {
+                    add(inner);
+                }
+            }
+            else
+            {
+                add(optimized);
+            }
+        }
+
+        nodes.erase(std::remove(nodes.begin(), nodes.end(), nullptr), nodes.end());
+        if (constant != V{} || nodes.empty())
+        {
+            nodes.emplace_back(arena->Make<NumberNode<V>>(constant));
+        }
+
+        if (nodes.size() == 1)
+        {
+            return nodes[0];
+        }
+        return arena->Make<XorNode<V>>(arena->MakeNodes(nodes));
+    }
+
+    // identity is the constant that doesn't change the result (x & ~0)
+    // and absorbing is the one that always is the result (x & 0)
+    template <typename Same, typename Other, typename Fold>
+    Node<V>*
+    OptimizeChain(
+            Span<Node<V>*> source,
+            const V& identity,
+            const V& absorbing,
+            Fold fold)
+    {
+        auto operands = Operands<V>{};
+        V constant = identity;
+
+        const auto add = [&](Node<V>* node) {
+            if (const auto* number = dynamic_cast<const NumberNode<V>*>(node))
+            {
+                fold(&constant, number->value);
+            }
+            else
+            {
+                operands.Add(node);
+            }
+        };
+
+        // a operand can be optimized to a chain of the same type, like
+        // ~~(a & b), so those are expanded again
+        for (auto* optimized: source)
+        {
+            if (const auto* same = dynamic_cast<const Same*>(optimized))
+            {
+                for (const auto& inner: same->operands)
+                {
+                    add(inner);
+                }
+            }
+            else
+            {
+                add(optimized);
+            }
+        }
+
+        if (constant == absorbing)
+        {
+            return arena->Make<NumberNode<V>>(absorbing);
+        }
+
+        // x & (x | y) is x and x | (x & y) is x
+        auto nodes = std::vector<Node<V>*>{};
+        for (const auto& node: operands.nodes)
+        {
+            if (!IsAbsorbed<Other>(node, operands))
+            {
+                nodes.emplace_back(node);
+            }
+        }
+
+        // constants are placed last so the compiler can merge them into the
+        // operation
+        if (constant != identity || nodes.empty())
+        {
+            nodes.emplace_back(arena->Make<NumberNode<V>>(constant));
+        }
+
+        if (nodes.size() == 1)
+        {
+            return nodes[0];
+        }
+        return arena->Make<Same>(arena->MakeNodes(nodes));
+    }
+};
+
+
+template <typename V>
+Node<V>*
+RunOptimizer(Node<V>* root, AstArena* arena, bool boolean)
+{
+    auto optimizer = Optimizer<V>{arena, boolean, {}};
+    auto* optimized = FoldTree<Node<V>*>(
+            *root,
+            [&optimizer](const Node<V>& node, std::vector<Node<V>*>* operands) {
+                optimizer.AppendOptimizedOperands(node, operands);
+            },
+            [&optimizer](const Node<V>& node, Span<Node<V>* const> operands, Span<Node<V>*> optimized_operands) {
+                // numbers, variables and errors are kept as they are
+                if (operands.empty())
+                {
+                    return static_cast<Node<V>*>(nullptr);
+                }
+                for (std::size_t i = 0; i < operands.size; i += 1)
+                {
+                    if (optimized_operands[i] == nullptr)
+                    {
+                        optimized_operands[i] = operands[i];
+                    }
+                }
+                return optimizer.Optimize(node, optimized_operands);
+            });
+    return optimized != nullptr ? optimized : root;
+}
+
+
+#define INSTANTIATE(V) \
+    template bool IsSameTree(const Node<V>& lhs, const Node<V>& rhs); \
+    template Node<V>* RunOptimizer(Node<V>* root, AstArena* arena, bool boolean);
+CALC_FOR_EACH_VALUE(INSTANTIATE)
+#undef INSTANTIATE
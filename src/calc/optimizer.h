@@ -0,0 +1,25 @@
+#ifndef CALC_OPTIMIZER_H
+#define CALC_OPTIMIZER_H
+
+#include "calc/arena.h"
+#include "calc/ast.h"
+
+
+// true if both trees have the same shape, numbers and variables
+template <typename V>
+[[nodiscard]] bool
+IsSameTree(const Node<V>& lhs, const Node<V>& rhs);
+
+
+// folds constants, removes operations that doesn't change the result and
+// flattens and/or chains, the result calculates the same value as the root
+// for all variables, new nodes are allocated in the arena and unchanged
+// nodes are shared with the root, when boolean is set only the lowest bit
+// of the result has to be the same and shifts of constants are folded like
+// a truth table reads them, x << y and x >> y are x & ~y
+template <typename V>
+Node<V>*
+RunOptimizer(Node<V>* root, AstArena* arena, bool boolean = false);
+
+
+#endif  // CALC_OPTIMIZER_H
@@ -5,3 +5,8 @@ Output::Output() = default;
 
 Output::~Output() = default;
 
+
+void
+Output::PrintRecords(std::string_view)
+{
+}
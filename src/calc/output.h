@@ -1,7 +1,7 @@
 #ifndef CALC_OUTPUT_H
 #define CALC_OUTPUT_H
 
-#include <string>
+#include <string_view>
 
 
 struct Output
@@ -16,11 +16,17 @@ struct Output
     void
     operator=(Output&&) = delete;
 
+    // a single line without the line ending
     virtual void
-    PrintInfo(const std::string& str) = 0;
+    PrintInfo(std::string_view str) = 0;
 
     virtual void
-    PrintError(const std::string& str) = 0;
+    PrintError(std::string_view str) = 0;
+
+    // one or more whole records of --binary, outputs that only print text
+    // drop them
+    virtual void
+    PrintRecords(std::string_view records);
 };
 
 
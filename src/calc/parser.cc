@@ -1,115 +1,110 @@
 #include "calc/parser.h"
 
-#include <fmt/core.h>
+#include <cassert>
+#include <cstddef>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
-#include "calc/input.h"
 #include "calc/errorhandler.h"
-
-struct ProvideEofToken
-{
-    static const Token&
-    Provide()
-    {
-        return Token::Eof();
-    }
-};
+#include "calc/grammar.h"
+#include "calc/ints.h"
+#include "calc/value.h"
 
 
-template <typename T>
-struct VectorSizeProvider
+// makes the nodes of the tree, all owned by the arena
+template <typename V>
+struct NodeBuilder
 {
-    static int
-    Size(const std::vector<T>& vec)
-    {
-        return ToInt(vec.size());
-    }
-};
-
+    using Operand = Node<V>*;
 
-using ParserInput = Input<const Token&,
-            std::vector<Token>,
-            ProvideEofToken,
-            VectorSizeProvider<Token>>;
+    ErrorHandler* errors;
+    AstArena* arena;
 
-struct Parser
-{
-    ParserInput input;
+    // variables are numbered in the order they first appear, the names are
+    // owned by the arena
+    std::unordered_map<std::string_view, int> variables;
 
-    ErrorHandler* errors;
-    explicit Parser(ErrorHandler* e) : errors(e) {}
+    Node<V>*
+    MakeNumber(const Token<V>& token)
+    {
+        return arena->Make<NumberNode<V>>(token.value);
+    }
 
-    std::shared_ptr<Node>
-    ParseNumber()
+    Node<V>*
+    MakeVariable(const Token<V>& token)
     {
-        if (input.Peek().type == Token::NUMBER)
-        {
-            return std::make_shared<NumberNode>(input.Read().value);
-        }
-        else
+        const auto found = variables.find(token.name);
+        if (found != variables.end())
         {
-            errors->Err(fmt::format("Expected number but got {}", input.Read().ToString()));
-            return ErrorNode::Make();
+            return arena->Make<VariableNode<V>>(found->first, found->second);
         }
+        const auto index = ToInt(variables.size());
+        const auto stored = arena->MakeString(token.name);
+        variables.emplace(stored, index);
+        return arena->Make<VariableNode<V>>(stored, index);
     }
 
-    std::shared_ptr<Node>
-    Parse()
+    Node<V>*
+    MakeNot(Node<V>* operand)
     {
-        auto root = ParseNumber();
-        if (errors->HasErr())
-        {
-            return ErrorNode::Make();
-        }
+        return arena->Make<NotNode<V>>(operand);
+    }
 
-        while (!input.IsEof())
+    Node<V>*
+    MakeBinary(TokenType<V> type, Node<V>* lhs, Node<V>* rhs)
+    {
+        switch (type)
         {
-            switch (input.Peek().type)
-            {
-            case Token::OPAND: {
-                input.Read();
-                auto lhs = root;
-                auto rhs = ParseNumber();
-                if (errors->HasErr())
-                {
-                    return ErrorNode::Make();
-                }
-                root = std::make_shared<AndNode>(lhs, rhs);
-                break;
-            }
-            case Token::OPOR: {
-                input.Read();
-                auto lhs = root;
-                auto rhs = ParseNumber();
-                if (errors->HasErr())
-                {
-                    return ErrorNode::Make();
-                }
-                root = std::make_shared<OrNode>(lhs, rhs);
-                break;
-            }
-            default:
-                errors->Err(fmt::format("Expected OP but got {}", input.Read().ToString()));
-                return ErrorNode::Make();
-            }
+        case Token<V>::OPAND: return arena->Make<AndNode<V>>(arena->MakeNodes<V>({lhs, rhs}));
+        case Token<V>::OPOR: return arena->Make<OrNode<V>>(arena->MakeNodes<V>({lhs, rhs}));
+        case Token<V>::OPXOR: return arena->Make<XorNode<V>>(arena->MakeNodes<V>({lhs, rhs}));
+        case Token<V>::OPSHL: return arena->Make<ShiftLeftNode<V>>(lhs, rhs);
+        case Token<V>::OPSHR: return arena->Make<ShiftRightNode<V>>(lhs, rhs);
+        default:
+            assert(false && "not a operator");
+            return MakeError();
         }
+    }
 
-        if (errors->HasErr())
-        {
-            return ErrorNode::Make();
-        }
-        else
-        {
-            return root;
-        }
+    Node<V>*
+    MakeError()
+    {
+        return arena->Make<ErrorNode<V>>();
+    }
+
+    void
+    Err(ErrorCode code, std::string_view text, int token)
+    {
+        errors->Err(code, text, token);
+    }
+
+    [[nodiscard]] bool
+    HasErr() const
+    {
+        return errors->HasErr();
     }
 };
 
 
-std::shared_ptr<Node>
-RunParser(const std::vector<Token>& tokens, ErrorHandler* errors)
+template <typename V>
+Node<V>*
+RunParser(const std::vector<Token<V>>& tokens, ErrorHandler* errors, AstArena* arena)
 {
-    auto parser = Parser{errors};
-    parser.input.input = tokens;
-    return parser.Parse();
+    auto builder = NodeBuilder<V>{errors, arena, {}};
+
+    // the stacks are taken from the arena so a reused arena parses without
+    // allocating
+    auto grammar = Grammar<V, NodeBuilder<V>>{
+            &builder,
+            tokens,
+            {arena->MakeArray<Node<V>*>(tokens.size())},
+            {arena->MakeArray<TokenType<V>>(tokens.size())}};
+    return grammar.Parse();
 }
 
+
+#define INSTANTIATE(V) \
+    template Node<V>* RunParser(const std::vector<Token<V>>& tokens, ErrorHandler* errors, AstArena* arena);
+CALC_FOR_EACH_VALUE(INSTANTIATE)
+#undef INSTANTIATE
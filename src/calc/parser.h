@@ -2,16 +2,18 @@
 #define CALC_PARSER_H
 
 #include <vector>
-#include <memory>
 
+#include "calc/arena.h"
 #include "calc/ast.h"
 #include "calc/token.h"
 
 struct ErrorHandler;
 
 
-std::shared_ptr<Node>
-RunParser(const std::vector<Token>& tokens, ErrorHandler* errors);
+// the returned tree is owned by the arena
+template <typename V>
+Node<V>*
+RunParser(const std::vector<Token<V>>& tokens, ErrorHandler* errors, AstArena* arena);
 
 
 #endif  // CALC_PARSER_H
@@ -0,0 +1,84 @@
+#include "calc/program.h"
+
+#include <array>
+#include <string_view>
+
+#include "calc/ints.h"
+#include "calc/value.h"
+
+
+template <typename V>
+[[nodiscard]] std::string
+Program<V>::ToString() const
+{
+    constexpr std::array NAMES{
+            std::string_view{"PUSH"},
+            std::string_view{"PUSH_VAR"},
+            std::string_view{"AND_CONST"},
+            std::string_view{"OR_CONST"},
+            std::string_view{"XOR_CONST"},
+            std::string_view{"SHL_CONST"},
+            std::string_view{"SHR_CONST"},
+            std::string_view{"AND_VAR"},
+            std::string_view{"OR_VAR"},
+            std::string_view{"XOR_VAR"},
+            std::string_view{"SHL_VAR"},
+            std::string_view{"SHR_VAR"},
+            std::string_view{"AND"},
+            std::string_view{"OR"},
+            std::string_view{"XOR"},
+            std::string_view{"SHL"},
+            std::string_view{"SHR"},
+            std::string_view{"NOT"}};
+    using A = decltype(NAMES);
+
+    fmt::memory_buffer buffer;
+    bool first = true;
+    for (const auto& instruction: code)
+    {
+        if (first)
+        {
+            first = false;
+        }
+        else
+        {
+            buffer.push_back(' ');
+        }
+
+        buffer.append(NAMES[static_cast<typename A::size_type>(instruction.op)]);
+
+        switch (instruction.op)
+        {
+        case OpCode::PUSH:
+        case OpCode::AND_CONST:
+        case OpCode::OR_CONST:
+        case OpCode::XOR_CONST:
+        case OpCode::SHL_CONST:
+        case OpCode::SHR_CONST:
+            buffer.push_back('(');
+            AppendDecimal(&buffer, constants[ToSizet(instruction.value)]);
+            buffer.push_back(')');
+            break;
+        case OpCode::PUSH_VAR:
+        case OpCode::AND_VAR:
+        case OpCode::OR_VAR:
+        case OpCode::XOR_VAR:
+        case OpCode::SHL_VAR:
+        case OpCode::SHR_VAR:
+            fmt::format_to(std::back_inserter(buffer), "({})", instruction.value);
+            break;
+        case OpCode::AND:
+        case OpCode::OR:
+        case OpCode::XOR:
+        case OpCode::SHL:
+        case OpCode::SHR:
+        case OpCode::NOT: break;
+        }
+    }
+    return fmt::to_string(buffer);
+}
+
+
+#define INSTANTIATE(V) template struct Program<V>;
+CALC_FOR_EACH_VALUE(INSTANTIATE)
+#undef INSTANTIATE
@@ -0,0 +1,81 @@
+#ifndef CALC_PROGRAM_H
+#define CALC_PROGRAM_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+// the vm keeps the top of the stack in a register so the common
+// "constant on the right hand side" case never touches the stack
+enum class OpCode : std::uint8_t
+{
+    // push the current top and load a constant or variable as the new top
+    PUSH,
+    PUSH_VAR,
+
+    // combine the top with a constant, the top is the left hand side
+    AND_CONST,
+    OR_CONST,
+    XOR_CONST,
+    SHL_CONST,
+    SHR_CONST,
+
+    // combine the top with a variable
+    AND_VAR,
+    OR_VAR,
+    XOR_VAR,
+    SHL_VAR,
+    SHR_VAR,
+
+    // pop a value and combine it with the top, the popped value is the
+    // left hand side
+    AND,
+    OR,
+    XOR,
+    SHL,
+    SHR,
+
+    // replace the top with its complement
+    NOT
+};
+
+
+// the same for all value types, wide constants would make every
+// instruction as large as the widest value
+struct Instruction
+{
+    OpCode op;
+
+    // the index of the constant or the variable
+    int value;
+};
+
+
+// a flat, postfix representation of a node tree
+template <typename V>
+struct Program
+{
+    std::vector<Instruction> code;
+
+    // the deepest the value stack will grow while running the code
+    int stack_size = 0;
+
+    // variable names, indexed by the instruction value
+    std::vector<std::string> variables;
+
+    // constants, indexed by the instruction value
+    std::vector<V> constants;
+
+    // the result for every value of the only variable, indexed by the
+    // value, when it's filled RunProgram loads the result instead of
+    // running the code, see TabulateProgram
+    std::vector<V> table;
+
+    // the constants are written in place of their index
+    [[nodiscard]] std::string
+    ToString() const;
+};
+
+
+#endif  // CALC_PROGRAM_H
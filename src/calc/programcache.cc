@@ -0,0 +1,246 @@
+#include "calc/programcache.h"
+
+#include <utility>
+#include <vector>
+
+#include "calc/arena.h"
+#include "calc/compiler.h"
+#include "calc/errorhandler.h"
+#include "calc/lexer.h"
+#include "calc/lookuptable.h"
+#include "calc/optimizer.h"
+#include "calc/parser.h"
+#include "calc/value.h"
+
+
+bool
+IsSourceSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+
+// whitespace only separates tokens, so leading and trailing whitespace is
+// dropped and every run of it is the same as a single space
+template <typename F>
+void
+ForEachNormalized(std::string_view source, F on_char)
+{
+    bool pending_space = false;
+    bool first = true;
+    for (const char c: source)
+    {
+        if (IsSourceSpace(c))
+        {
+            pending_space = !first;
+            continue;
+        }
+        if (pending_space)
+        {
+            on_char(' ');
+            pending_space = false;
+        }
+        on_char(c);
+        first = false;
+    }
+}
+
+
+// fnv-1a of the normalized source followed by the optimize flag
+std::uint64_t
+HashSource(std::string_view source, bool optimize)
+{
+    std::uint64_t hash = 0xcbf29ce484222325;
+    const auto add = [&hash](unsigned char c) {
+        hash ^= c;
+        hash *= 0x100000001b3;
+    };
+    ForEachNormalized(source, [&add](char c) { add(static_cast<unsigned char>(c)); });
+    add(optimize ? 1 : 0);
+    return hash;
+}
+
+
+bool
+IsSameSource(const std::string& normalized, std::string_view source)
+{
+    std::size_t next = 0;
+    bool same = true;
+    ForEachNormalized(source, [&](char c) {
+        same = same && next < normalized.size() && normalized[next] == c;
+        next += 1;
+    });
+    return same && next == normalized.size();
+}
+
+
+std::string
+NormalizeSource(std::string_view source)
+{
+    std::string normalized;
+    normalized.reserve(source.size());
+    ForEachNormalized(source, [&normalized](char c) { normalized.push_back(c); });
+    return normalized;
+}
+
+
+template <typename V>
+ProgramCache<V>::ProgramCache(std::size_t c) : capacity(c)
+{
+}
+
+
+template <typename V>
+[[nodiscard]] std::shared_ptr<const Program<V>>
+ProgramCache<V>::Find(std::string_view source, bool optimize)
+{
+    std::uint64_t expected_calls = 0;
+    return Lookup(source, optimize, &expected_calls);
+}
+
+
+template <typename V>
+std::shared_ptr<const Program<V>>
+ProgramCache<V>::Insert(std::string_view source, bool optimize, Program<V> program)
+{
+    return Store(source, optimize, std::move(program), 0);
+}
+
+
+template <typename V>
+[[nodiscard]] std::shared_ptr<const Program<V>>
+ProgramCache<V>::Lookup(std::string_view source, bool optimize, std::uint64_t* expected_calls)
+{
+    const auto hash = HashSource(source, optimize);
+
+    std::lock_guard<std::mutex> lock{mutex};
+    const auto found = index.find(hash);
+    if (found == index.end() || found->second->optimize != optimize
+        || !IsSameSource(found->second->source, source))
+    {
+        misses += 1;
+        return nullptr;
+    }
+
+    hits += 1;
+    entries.splice(entries.begin(), entries, found->second);
+    found->second->expected_calls += *expected_calls;
+    *expected_calls = found->second->expected_calls;
+    return found->second->program;
+}
+
+
+template <typename V>
+std::shared_ptr<const Program<V>>
+ProgramCache<V>::Store(std::string_view source, bool optimize, Program<V> program, std::uint64_t expected_calls)
+{
+    // everything that allocates is done before taking the lock
+    auto shared = std::make_shared<const Program<V>>(std::move(program));
+    if (capacity == 0)
+    {
+        return shared;
+    }
+    const auto hash = HashSource(source, optimize);
+    auto normalized = NormalizeSource(source);
+
+    std::lock_guard<std::mutex> lock{mutex};
+
+    // a other source with the same hash is replaced, it only costs a miss
+    const auto found = index.find(hash);
+    if (found != index.end())
+    {
+        found->second->source = std::move(normalized);
+        found->second->optimize = optimize;
+        found->second->program = shared;
+        found->second->expected_calls = expected_calls;
+        entries.splice(entries.begin(), entries, found->second);
+        return shared;
+    }
+
+    if (entries.size() == capacity)
+    {
+        index.erase(entries.back().hash);
+        entries.pop_back();
+    }
+    entries.emplace_front(Entry{hash, std::move(normalized), optimize, shared, expected_calls});
+    index.emplace(hash, entries.begin());
+    return shared;
+}
+
+
+template <typename V>
+std::shared_ptr<const Program<V>>
+ProgramCache<V>::Compile(std::string_view source, bool optimize, ErrorHandler* errors, std::uint64_t expected_calls)
+{
+    auto found = Lookup(source, optimize, &expected_calls);
+    if (found != nullptr && !ShouldTabulate(*found, expected_calls))
+    {
+        return found;
+    }
+
+    // a cached program that is now called often enough is compiled again
+    // with a table
+    const auto tokens = RunLexer<V>(source, errors);
+    if (errors->HasErr())
+    {
+        return nullptr;
+    }
+
+    AstArena arena;
+    auto* root = RunParser(tokens, errors, &arena);
+    if (errors->HasErr())
+    {
+        return nullptr;
+    }
+    if (optimize)
+    {
+        root = RunOptimizer(root, &arena);
+    }
+
+    auto program = CompileProgram(*root);
+    if (ShouldTabulate(program, expected_calls))
+    {
+        TabulateProgram(&program);
+    }
+    return Store(source, optimize, std::move(program), expected_calls);
+}
+
+
+template <typename V>
+[[nodiscard]] std::size_t
+ProgramCache<V>::Capacity() const
+{
+    return capacity;
+}
+
+
+template <typename V>
+[[nodiscard]] std::size_t
+ProgramCache<V>::Size() const
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    return entries.size();
+}
+
+
+template <typename V>
+[[nodiscard]] std::uint64_t
+ProgramCache<V>::Hits() const
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    return hits;
+}
+
+
+template <typename V>
+[[nodiscard]] std::uint64_t
+ProgramCache<V>::Misses() const
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    return misses;
+}
+
+
+#define INSTANTIATE(V) template struct ProgramCache<V>;
+CALC_FOR_EACH_VALUE(INSTANTIATE)
+#undef INSTANTIATE
@@ -0,0 +1,97 @@
+#ifndef CALC_PROGRAMCACHE_H
+#define CALC_PROGRAMCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "calc/program.h"
+
+struct ErrorHandler;
+
+
+// compiled programs by their source and if they were optimized, when full
+// the least recently used program is evicted, all functions can be called
+// from several threads
+//
+// sources that only differ in whitespace between the tokens are the same,
+// the programs are shared so a evicted program stays valid for as long as
+// someone holds on to it
+template <typename V>
+struct ProgramCache
+{
+    explicit ProgramCache(std::size_t capacity);
+
+    // null on a miss, a hit makes the program the most recently used
+    [[nodiscard]] std::shared_ptr<const Program<V>>
+    Find(std::string_view source, bool optimize);
+
+    // adds or replaces the program for the source, a cache with no
+    // capacity returns the program without keeping it
+    std::shared_ptr<const Program<V>>
+    Insert(std::string_view source, bool optimize, Program<V> program);
+
+    // finds the source or compiles and inserts it, programs with errors
+    // aren't cached, the errors are added to the handler and null returned
+    //
+    // the expected calls of a source add up over all compiles of it, once
+    // ShouldTabulate says they're enough the program is compiled again
+    // with a table that replaces the cached program
+    std::shared_ptr<const Program<V>>
+    Compile(std::string_view source, bool optimize, ErrorHandler* errors, std::uint64_t expected_calls = 0);
+
+    [[nodiscard]] std::size_t
+    Capacity() const;
+
+    [[nodiscard]] std::size_t
+    Size() const;
+
+    [[nodiscard]] std::uint64_t
+    Hits() const;
+
+    [[nodiscard]] std::uint64_t
+    Misses() const;
+
+private:
+    struct Entry
+    {
+        std::uint64_t hash;
+
+        // normalized, different sources can have the same hash
+        std::string source;
+        bool optimize;
+
+        std::shared_ptr<const Program<V>> program;
+
+        // the sum of the calls the compiles of the source expected
+        std::uint64_t expected_calls = 0;
+    };
+
+    // Find that adds to the expected calls of the entry, which are set
+    // to their sum
+    [[nodiscard]] std::shared_ptr<const Program<V>>
+    Lookup(std::string_view source, bool optimize, std::uint64_t* expected_calls);
+
+    // Insert that keeps the expected calls with the program
+    std::shared_ptr<const Program<V>>
+    Store(std::string_view source, bool optimize, Program<V> program, std::uint64_t expected_calls);
+
+    std::size_t capacity;
+
+    mutable std::mutex mutex;
+
+    // most recently used first
+    std::list<Entry> entries;
+    std::unordered_map<std::uint64_t, typename std::list<Entry>::iterator> index;
+
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+};
+
+
+#endif  // CALC_PROGRAMCACHE_H
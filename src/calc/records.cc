@@ -0,0 +1,61 @@
+#include "calc/records.h"
+
+
+const char*
+RecordStatusName(std::uint8_t status)
+{
+    if (status == RECORD_OK)
+    {
+        return "ok";
+    }
+
+    switch (static_cast<ErrorCode>(status - 1))
+    {
+    case ErrorCode::NUMBER_TOO_LARGE: return "number too large";
+    case ErrorCode::INVALID_NUMBER_START: return "invalid number start";
+    case ErrorCode::MISSING_HEX_DIGITS: return "missing hex digits";
+    case ErrorCode::INVALID_BINARY_DIGIT: return "invalid binary digit";
+    case ErrorCode::MISSING_BINARY_DIGITS: return "missing binary digits";
+    case ErrorCode::INVALID_CHARACTER: return "invalid character";
+    case ErrorCode::EXPECTED_OPERAND: return "expected operand";
+    case ErrorCode::EXPECTED_OPERATOR: return "expected operator";
+    case ErrorCode::UNMATCHED_PAREN: return "unmatched paren";
+    case ErrorCode::MISSING_PAREN: return "missing paren";
+    case ErrorCode::EMPTY_STATEMENT: return "empty statement";
+    case ErrorCode::MISSING_VALUE: return "missing value";
+    case ErrorCode::TOO_MANY_TOKENS: return "too many tokens";
+    case ErrorCode::TOO_MANY_VARIABLES: return "too many variables";
+    }
+    return "unknown error";
+}
+
+
+RecordReader::RecordReader(std::string_view d, std::size_t width, bool status)
+    : data(d)
+    , value_size(width / CHAR_BIT)
+    , has_status(status)
+{
+}
+
+
+bool
+RecordReader::Next(Record* record)
+{
+    const auto size = (has_status ? 1 : 0) + value_size;
+    if (data.size() < size)
+    {
+        return false;
+    }
+
+    record->status = has_status ? static_cast<std::uint8_t>(data[0]) : RECORD_OK;
+    record->value = data.substr(has_status ? 1 : 0, value_size);
+    data.remove_prefix(size);
+    return true;
+}
+
+
+std::size_t
+RecordReader::RemainingBytes() const
+{
+    return data.size();
+}
@@ -0,0 +1,156 @@
+#ifndef CALC_RECORDS_H
+#define CALC_RECORDS_H
+
+#include <array>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+#include "calc/bits.h"
+#include "calc/errorhandler.h"
+
+
+// --binary writes each result as a record instead of text, the value as
+// little-endian bytes of the width of the values, with --status the value
+// is after a status byte and lines without a value have a record too
+//
+// there is no header, so a file of records without a status is a plain
+// array of integers
+
+
+// the status of a record with a value, the others are the error code + 1
+constexpr std::uint8_t RECORD_OK = 0;
+
+// the longest record, a status and a 512 bit value
+constexpr std::size_t MAX_RECORD_SIZE = 1 + 512 / CHAR_BIT;
+
+using RecordBuffer = std::array<char, MAX_RECORD_SIZE>;
+
+
+constexpr std::uint8_t
+RecordStatus(ErrorCode code)
+{
+    return static_cast<std::uint8_t>(static_cast<std::uint8_t>(code) + 1);
+}
+
+// the name of the error code of a status, or "ok"
+const char*
+RecordStatusName(std::uint8_t status);
+
+constexpr std::size_t
+RecordSize(std::size_t width, bool has_status)
+{
+    return (has_status ? 1 : 0) + width / CHAR_BIT;
+}
+
+
+// the value as sizeof(V) little-endian bytes, the compiler turns the shifts
+// into a single store on a little-endian machine
+template <typename V>
+constexpr std::enable_if_t<std::is_unsigned_v<V>>
+StoreLittleEndian(char* out, V value)
+{
+    for (std::size_t byte = 0; byte < sizeof(V); byte += 1)
+    {
+        out[byte] = static_cast<char>((value >> (byte * CHAR_BIT)) & 0xffU);
+    }
+}
+
+template <std::size_t N>
+constexpr void
+StoreLittleEndian(char* out, const Bits<N>& value)
+{
+    for (const auto word: value.words)
+    {
+        StoreLittleEndian(out, word);
+        out += sizeof(word);
+    }
+}
+
+
+template <typename V>
+constexpr std::enable_if_t<std::is_unsigned_v<V>, V>
+LoadLittleEndian(const char* bytes)
+{
+    V value = 0;
+    for (std::size_t byte = 0; byte < sizeof(V); byte += 1)
+    {
+        const auto b = static_cast<V>(static_cast<unsigned char>(bytes[byte]));
+        value = static_cast<V>(value | static_cast<V>(b << (byte * CHAR_BIT)));
+    }
+    return value;
+}
+
+template <typename V>
+constexpr std::enable_if_t<!std::is_unsigned_v<V>, V>
+LoadLittleEndian(const char* bytes)
+{
+    V value{};
+    for (auto& word: value.words)
+    {
+        word = LoadLittleEndian<std::uint64_t>(bytes);
+        bytes += sizeof(word);
+    }
+    return value;
+}
+
+
+// the record of a value, the result points into the buffer
+template <typename V>
+std::string_view
+FormatRecord(const V& value, bool has_status, RecordBuffer* buffer)
+{
+    char* out = buffer->data();
+    if (has_status)
+    {
+        *out = static_cast<char>(RECORD_OK);
+        out += 1;
+    }
+    StoreLittleEndian(out, value);
+    return {buffer->data(), RecordSize(sizeof(V) * CHAR_BIT, has_status)};
+}
+
+// the record of a line without a value, only written with a status
+template <typename V>
+std::string_view
+FormatErrorRecord(ErrorCode code, RecordBuffer* buffer)
+{
+    *buffer = {};
+    (*buffer)[0] = static_cast<char>(RecordStatus(code));
+    return {buffer->data(), RecordSize(sizeof(V) * CHAR_BIT, true)};
+}
+
+
+struct Record
+{
+    std::uint8_t status;
+
+    // the little-endian bytes of the value, all zero if the status isn't ok
+    std::string_view value;
+};
+
+
+// splits the bytes that --binary wrote into records, the width and if
+// there is a status must be the ones it was written with
+struct RecordReader
+{
+    RecordReader(std::string_view data, std::size_t width, bool has_status);
+
+    // false when there are no more whole records
+    bool
+    Next(Record* record);
+
+    // the bytes after the last whole record, not 0 if the file was cut short
+    [[nodiscard]] std::size_t
+    RemainingBytes() const;
+
+private:
+    std::string_view data;
+    std::size_t value_size;
+    bool has_status;
+};
+
+
+#endif  // CALC_RECORDS_H
@@ -0,0 +1,222 @@
+#include "calc/ruleindex.h"
+
+#include <algorithm>
+
+#include "calc/compiler.h"
+#include "calc/errorhandler.h"
+#include "calc/ints.h"
+#include "calc/kernels.h"
+#include "calc/lexer.h"
+#include "calc/optimizer.h"
+#include "calc/parser.h"
+#include "calc/vm.h"
+
+
+// n must not be 0
+int
+CountTrailingZeros(std::uint64_t n)
+{
+#if defined(__GNUC__)
+    return __builtin_ctzll(n);
+#else
+    int zeros = 0;
+    while ((n & 1) == 0)
+    {
+        zeros += 1;
+        n >>= 1;
+    }
+    return zeros;
+#endif
+}
+
+
+template <typename F>
+void
+ForEachSetBit(std::uint64_t bits, F on_bit)
+{
+    while (bits != 0)
+    {
+        on_bit(ToSizet(CountTrailingZeros(bits)));
+        bits &= bits - 1;
+    }
+}
+
+
+void
+SetRule(std::vector<std::uint64_t>* bitmap, std::size_t id)
+{
+    (*bitmap)[id / 64] |= std::uint64_t{1} << (id % 64);
+}
+
+
+bool
+HasShift(const Program<std::uint64_t>& program)
+{
+    return std::any_of(program.code.begin(), program.code.end(), [](const Instruction& instruction) {
+        switch (instruction.op)
+        {
+        case OpCode::SHL_CONST:
+        case OpCode::SHR_CONST:
+        case OpCode::SHL_VAR:
+        case OpCode::SHR_VAR:
+        case OpCode::SHL:
+        case OpCode::SHR: return true;
+        default: return false;
+        }
+    });
+}
+
+
+// the second variable as it's written in the source
+std::string_view
+FindOtherVariable(const std::vector<Token<std::uint64_t>>& tokens, const std::string& first)
+{
+    for (const auto& token: tokens)
+    {
+        if (token.type == Token<std::uint64_t>::VARIABLE && token.name != first)
+        {
+            return token.name;
+        }
+    }
+    return {};
+}
+
+
+// below this share of used words the used words are ored one by one
+// instead of all words with the kernel
+constexpr std::size_t SPARSE_BITMAP_RATIO = 8;
+
+
+void
+RuleIndex::RuleBitmap::Set(std::size_t id)
+{
+    auto& word = words[id / 64];
+    if (word == 0)
+    {
+        used.emplace_back(id / 64);
+    }
+    word |= std::uint64_t{1} << (id % 64);
+}
+
+
+void
+RuleIndex::RuleBitmap::OrInto(std::vector<std::uint64_t>* bitmap) const
+{
+    if (used.size() * SPARSE_BITMAP_RATIO < words.size())
+    {
+        for (const auto index: used)
+        {
+            (*bitmap)[index] |= words[index];
+        }
+    }
+    else
+    {
+        BestKernels().or_array(bitmap->data(), words.data(), words.size());
+    }
+}
+
+
+RuleIndex::RuleIndex() = default;
+
+
+RuleIndex::~RuleIndex() = default;
+
+
+int
+RuleIndex::Add(std::string_view source, ErrorHandler* errors)
+{
+    arena.Reset();
+
+    RunLexer(source, errors, &tokens);
+    if (errors->HasErr())
+    {
+        return -1;
+    }
+    if (tokens.empty())
+    {
+        errors->Err(ErrorCode::EMPTY_STATEMENT, source.substr(source.size()));
+        return -1;
+    }
+
+    auto* root = RunParser(tokens, errors, &arena);
+    if (errors->HasErr())
+    {
+        return -1;
+    }
+
+    CompileProgram(*RunOptimizer(root, &arena), &program);
+    if (program.variables.size() > 1)
+    {
+        errors->Err(ErrorCode::TOO_MANY_VARIABLES, FindOtherVariable(tokens, program.variables[0]));
+        return -1;
+    }
+
+    const auto id = rule_count;
+    rule_count += 1;
+    if (id % 64 == 0)
+    {
+        always.emplace_back(0);
+        for (std::size_t bit = 0; bit < 64; bit += 1)
+        {
+            on_set[bit].words.emplace_back(0);
+            on_clear[bit].words.emplace_back(0);
+        }
+    }
+
+    if (HasShift(program))
+    {
+        shift_rules.emplace_back(ShiftRule{ToInt(id), program});
+        return ToInt(id);
+    }
+
+    constexpr std::uint64_t no_bits = 0;
+    constexpr std::uint64_t all_bits = ~no_bits;
+    const auto for_clear = RunProgram(program, &no_bits);
+    const auto for_set = RunProgram(program, &all_bits);
+
+    if ((for_clear & for_set) != 0)
+    {
+        SetRule(&always, id);
+        return ToInt(id);
+    }
+
+    const auto follows_set = for_set & ~for_clear;
+    const auto follows_clear = for_clear & ~for_set;
+    ForEachSetBit(follows_set, [&](std::size_t bit) { on_set[bit].Set(id); });
+    ForEachSetBit(follows_clear, [&](std::size_t bit) { on_clear[bit].Set(id); });
+    set_bits |= follows_set;
+    clear_bits |= follows_clear;
+    return ToInt(id);
+}
+
+
+std::size_t
+RuleIndex::RuleCount() const
+{
+    return rule_count;
+}
+
+
+void
+RuleIndex::Match(std::uint64_t value, RuleMatches* matches) const
+{
+    auto& bitmap = matches->bitmap;
+    bitmap.assign(always.begin(), always.end());
+
+    ForEachSetBit(value & set_bits, [&](std::size_t bit) { on_set[bit].OrInto(&bitmap); });
+    ForEachSetBit(~value & clear_bits, [&](std::size_t bit) { on_clear[bit].OrInto(&bitmap); });
+
+    for (const auto& rule: shift_rules)
+    {
+        if (RunProgram(rule.program, &value) != 0)
+        {
+            SetRule(&bitmap, ToSizet(rule.id));
+        }
+    }
+
+    matches->rules.clear();
+    for (std::size_t word = 0; word < bitmap.size(); word += 1)
+    {
+        ForEachSetBit(bitmap[word], [&](std::size_t bit) { matches->rules.emplace_back(ToInt(word * 64 + bit)); });
+    }
+}
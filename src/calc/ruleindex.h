@@ -0,0 +1,104 @@
+#ifndef CALC_RULEINDEX_H
+#define CALC_RULEINDEX_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "calc/arena.h"
+#include "calc/program.h"
+#include "calc/token.h"
+
+struct ErrorHandler;
+
+
+// the rules that matched a value, the bitmap is scratch memory that is
+// reused between matches
+struct RuleMatches
+{
+    std::vector<std::uint64_t> bitmap;
+
+    // the ids of the rules, in order
+    std::vector<int> rules;
+};
+
+
+// finds the rules, expressions of at most one variable, that are non-zero
+// for a value without evaluating every rule
+//
+// and, or, xor and not work on each bit on its own, so every bit of such a
+// rule is either 0, 1, the bit of the value or its complement, which is
+// found by evaluating the rule for 0 and all bits once when it's added, a
+// rule matches if it has a bit that is 1 or a bit that follows a set bit
+// of the value or a bit that follows a clear bit of the value
+//
+// the rules are indexed with a bitmap of rules for each of those, so a
+// match ors together the bitmaps of the bits of the value a word of rules
+// at a time, rules with shifts are evaluated one by one
+struct RuleIndex
+{
+    RuleIndex();
+    ~RuleIndex();
+
+    RuleIndex(const RuleIndex&) = delete;
+    RuleIndex(RuleIndex&&) = delete;
+    void
+    operator=(const RuleIndex&) = delete;
+    void
+    operator=(RuleIndex&&) = delete;
+
+    // the id of the rule or -1 if it has errors, the ids are given out in
+    // order starting at 0
+    int
+    Add(std::string_view source, ErrorHandler* errors);
+
+    [[nodiscard]] std::size_t
+    RuleCount() const;
+
+    // the rules that are non-zero when the variable is value
+    void
+    Match(std::uint64_t value, RuleMatches* matches) const;
+
+private:
+    struct ShiftRule
+    {
+        int id;
+        Program<std::uint64_t> program;
+    };
+
+    // a bit for each rule, in words of 64 rules, and the words that aren't
+    // zero so a sparse bitmap can be ored without going over all words
+    struct RuleBitmap
+    {
+        std::vector<std::uint64_t> words;
+        std::vector<std::size_t> used;
+
+        void
+        Set(std::size_t id);
+
+        void
+        OrInto(std::vector<std::uint64_t>* bitmap) const;
+    };
+
+    std::size_t rule_count = 0;
+
+    std::vector<std::uint64_t> always;
+    std::array<RuleBitmap, 64> on_set;
+    std::array<RuleBitmap, 64> on_clear;
+
+    // the bits that have a rule, so the empty bitmaps are skipped
+    std::uint64_t set_bits = 0;
+    std::uint64_t clear_bits = 0;
+
+    std::vector<ShiftRule> shift_rules;
+
+    // the rule that is being added
+    AstArena arena;
+    std::vector<Token<std::uint64_t>> tokens;
+    Program<std::uint64_t> program;
+};
+
+
+#endif  // CALC_RULEINDEX_H
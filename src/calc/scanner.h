@@ -0,0 +1,378 @@
+#ifndef CALC_SCANNER_H
+#define CALC_SCANNER_H
+
+#include <cstdint>
+#include <string_view>
+
+#include "calc/errorhandler.h"
+#include "calc/input.h"
+#include "calc/ints.h"
+#include "calc/token.h"
+#include "calc/value.h"
+
+
+// the lexer is constexpr so expressions can be evaluated at compile time,
+// the runtime lexer reads its tokens with the same scanner
+
+
+constexpr bool
+IsSpace(char c)
+{
+    if (c == ' ')
+    {
+        return true;
+    }
+    if (c == '\t')
+    {
+        return true;
+    }
+    if (c == '\n')
+    {
+        return true;
+    }
+    if (c == '\r')
+    {
+        return true;
+    }
+    return false;
+}
+
+
+constexpr bool
+IsBinary(char c)
+{
+    if (c == '0' || c == '1')
+    {
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+
+constexpr bool
+IsNumber(char c)
+{
+    if (c >= '0' && c <= '9')
+    {
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+
+constexpr bool
+IsHexa(char c)
+{
+    if (IsNumber(c))
+    {
+        return true;
+    }
+    if ((c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F'))
+    {
+        return true;
+    }
+    return false;
+}
+
+
+constexpr bool
+IsAz(char c)
+{
+    if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))
+    {
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+
+constexpr bool
+IsIdentifierStart(char c)
+{
+    return IsAz(c) || c == '_';
+}
+
+
+constexpr bool
+IsIdentifier(char c)
+{
+    return IsIdentifierStart(c) || IsNumber(c);
+}
+
+
+constexpr std::uint32_t
+DigitValue(char c)
+{
+    if (c >= 'a' && c <= 'f')
+    {
+        return static_cast<std::uint32_t>(c - 'a' + 10);
+    }
+    if (c >= 'A' && c <= 'F')
+    {
+        return static_cast<std::uint32_t>(c - 'A' + 10);
+    }
+    return static_cast<std::uint32_t>(c - '0');
+}
+
+
+// accumulate the digits in place, returns false if the number doesn't fit
+template <typename V>
+constexpr bool
+ParseDigits(std::string_view digits, std::uint32_t base, V* result)
+{
+    V n{};
+    for (const char c: digits)
+    {
+        if (!MulAdd(&n, base, DigitValue(c)))
+        {
+            return false;
+        }
+    }
+    *result = n;
+    return true;
+}
+
+
+struct ProvideNullChar
+{
+    static constexpr char
+    Provide()
+    {
+        return 0;
+    }
+};
+
+
+struct StringSizeProvider
+{
+    static constexpr std::size_t
+    Size(std::string_view str)
+    {
+        return str.length();
+    }
+};
+
+using LexerInput = Input<char, std::string_view, ProvideNullChar, StringSizeProvider>;
+
+// reads the tokens of a source one at a time
+template <typename V>
+struct Scanner
+{
+    LexerInput input;
+
+    // the first error, nothing is read after it
+    bool failed = false;
+    ErrorCode error = ErrorCode::INVALID_CHARACTER;
+    std::string_view error_text;
+
+    constexpr explicit Scanner(std::string_view source)
+        : input{source}
+    {
+    }
+
+    constexpr void
+    Err(ErrorCode code, std::string_view text)
+    {
+        failed = true;
+        error = code;
+        error_text = text;
+    }
+
+    constexpr void
+    SkipSpaces()
+    {
+        while (!input.IsEof() && IsSpace(input.Peek()))
+        {
+            input.Read();
+        }
+    }
+
+    // the source that has been read since start
+    [[nodiscard]] constexpr std::string_view
+    ReadSince(std::size_t start) const
+    {
+        return input.input.substr(start, input.next - start);
+    }
+
+    // the next character, empty at the end of the source
+    [[nodiscard]] constexpr std::string_view
+    Next() const
+    {
+        return input.input.substr(input.next, 1);
+    }
+
+    constexpr V
+    ParseNumber(std::size_t start, std::size_t digits_start, std::uint32_t base)
+    {
+        V value{};
+        if (!ParseDigits(ReadSince(digits_start), base, &value))
+        {
+            Err(ErrorCode::NUMBER_TOO_LARGE, ReadSince(start));
+            return V{};
+        }
+        return value;
+    }
+
+    constexpr V
+    ReadNumber()
+    {
+        const auto start = input.next;
+        const auto first = input.Peek();
+        if (!IsNumber(first))
+        {
+            Err(ErrorCode::INVALID_NUMBER_START, Next());
+            return V{};
+        }
+        input.Read();
+
+        const auto second = input.Peek();
+
+        if (second == 'x' || second == 'X')
+        {
+            input.Read();  // read the x
+            const auto digits = input.next;
+            while (!input.IsEof() && IsHexa(input.Peek()))
+            {
+                input.Read();
+            }
+            if (digits == input.next)
+            {
+                Err(ErrorCode::MISSING_HEX_DIGITS, Next());
+                return V{};
+            }
+            return ParseNumber(start, digits, 16);
+        }
+        else if (second == 'b' || second == 'B')
+        {
+            input.Read();  // read the b
+            const auto digits = input.next;
+            while (!input.IsEof() && IsNumber(input.Peek()))
+            {
+                if (IsBinary(input.Peek()))
+                {
+                    input.Read();
+                }
+                else
+                {
+                    Err(ErrorCode::INVALID_BINARY_DIGIT, Next());
+                    return V{};
+                }
+            }
+            if (digits == input.next)
+            {
+                Err(ErrorCode::MISSING_BINARY_DIGITS, Next());
+                return V{};
+            }
+            return ParseNumber(start, digits, 2);
+        }
+        else if (IsNumber(second))
+        {
+            while (!input.IsEof() && IsNumber(input.Peek()))
+            {
+                input.Read();
+            }
+            return ParseNumber(start, start, 10);
+        }
+        else
+        {
+            // single character decimal or octal number
+            return ParseNumber(start, start, 10);
+        }
+    }
+
+
+    constexpr std::string_view
+    ReadIdentifier()
+    {
+        const auto start = input.next;
+        while (!input.IsEof() && IsIdentifier(input.Peek()))
+        {
+            input.Read();
+        }
+        return ReadSince(start);
+    }
+
+
+    // reads the next token, false at the end of the source or at a error,
+    // the name of every token is its source
+    constexpr bool
+    Read(Token<V>* token)
+    {
+        SkipSpaces();
+        if (failed || input.IsEof())
+        {
+            return false;
+        }
+
+        const auto start = input.next;
+        const auto c = input.Peek();
+        auto type = Token<V>::EOFTOKEN;
+        V value{};
+        if (IsNumber(c))
+        {
+            type = Token<V>::NUMBER;
+            value = ReadNumber();
+            if (failed)
+            {
+                return false;
+            }
+        }
+        else if (IsIdentifierStart(c))
+        {
+            type = Token<V>::VARIABLE;
+            ReadIdentifier();
+        }
+        else if (c == '<' || c == '>')
+        {
+            input.Read();
+            if (input.Peek() != c)
+            {
+                Err(ErrorCode::INVALID_CHARACTER, ReadSince(start));
+                return false;
+            }
+            input.Read();
+            type = c == '<' ? Token<V>::OPSHL : Token<V>::OPSHR;
+        }
+        else
+        {
+            type = SingleCharacterType(c);
+            if (type == Token<V>::EOFTOKEN)
+            {
+                Err(ErrorCode::INVALID_CHARACTER, Next());
+                return false;
+            }
+            input.Read();
+        }
+
+        *token = Token<V>{type, value, ReadSince(start)};
+        return true;
+    }
+
+    // the operators and parentheses, EOFTOKEN for the other characters
+    static constexpr typename Token<V>::Type
+    SingleCharacterType(char c)
+    {
+        switch (c)
+        {
+        case '&': return Token<V>::OPAND;
+        case '|': return Token<V>::OPOR;
+        case '^': return Token<V>::OPXOR;
+        case '~': return Token<V>::OPNOT;
+        case '(': return Token<V>::LPAREN;
+        case ')': return Token<V>::RPAREN;
+        default: return Token<V>::EOFTOKEN;
+        }
+    }
+};
+
+
+#endif  // CALC_SCANNER_H
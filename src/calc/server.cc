@@ -0,0 +1,623 @@
+#include "calc/server.h"
+
+#include <array>
+#include <cerrno>
+#include <cstring>
+
+#include <fmt/format.h>
+
+#if defined(__linux__)
+#define CALC_EPOLL
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "calc/ints.h"
+#include "calc/span.h"
+
+
+constexpr std::size_t READ_SIZE = 64 * 1024;
+
+// a client with more replies than this waiting isn't read from until they
+// are written, the replies of one read can go over it
+constexpr std::size_t MAX_PENDING_REPLIES = 1024 * 1024;
+
+// a client that sends a longer line is closed
+constexpr std::size_t MAX_LINE_SIZE = 1024 * 1024;
+
+// the client reads replies while it has this much to send
+constexpr std::size_t MAX_PENDING_REQUESTS = 64 * 1024;
+
+constexpr int MAX_EVENTS = 64;
+
+
+#ifdef CALC_EPOLL
+
+std::string
+SystemError(std::string_view what, std::string_view path)
+{
+    return fmt::format("{} {}: {}", what, path, std::strerror(errno));
+}
+
+
+bool
+MakeAddress(const std::string& path, sockaddr_un* address, std::string* error)
+{
+    *address = sockaddr_un{};
+    address->sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address->sun_path))
+    {
+        *error = fmt::format("Invalid socket path {}", path);
+        return false;
+    }
+    std::memcpy(address->sun_path, path.data(), path.size());
+    return true;
+}
+
+
+// -1 with errno set if the connect failed
+int
+ConnectTo(const sockaddr_un& address)
+{
+    const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        return -1;
+    }
+    if (connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+    {
+        const int connect_error = errno;
+        close(fd);
+        errno = connect_error;
+        return -1;
+    }
+    return fd;
+}
+
+
+// EWOULDBLOCK is the same error on linux
+bool
+IsWouldBlock(int error)
+{
+    return error == EAGAIN;
+}
+
+
+// splits the received data into lines and calls the function for each
+// complete one without the line ending, the incomplete end is kept
+template <typename F>
+void
+ForEachLine(std::string* data, F on_line)
+{
+    std::size_t start = 0;
+    for (auto end = data->find('\n'); end != std::string::npos; end = data->find('\n', start))
+    {
+        auto line = std::string_view{*data}.substr(start, end - start);
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.remove_suffix(1);
+        }
+        on_line(line);
+        start = end + 1;
+    }
+    data->erase(0, start);
+}
+
+#endif
+
+
+Server::Server(RequestHandler h) : handler(std::move(h))
+{
+}
+
+
+Server::~Server()
+{
+#ifdef CALC_EPOLL
+    for (auto& entry: clients)
+    {
+        close(entry.first);
+    }
+    for (const auto fd: {listen_fd, epoll_fd, stop_fd, signal_fd})
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+    }
+    if (!path.empty())
+    {
+        unlink(path.c_str());
+    }
+    if (!blocked_signals.empty())
+    {
+        sigset_t signals;
+        sigemptyset(&signals);
+        for (const auto signal: blocked_signals)
+        {
+            sigaddset(&signals, signal);
+        }
+        pthread_sigmask(SIG_UNBLOCK, &signals, nullptr);
+    }
+#endif
+}
+
+
+[[nodiscard]] bool
+Server::IsSupported()
+{
+#ifdef CALC_EPOLL
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+bool
+Server::Listen(const std::string& socket_path, std::string* error)
+{
+#ifdef CALC_EPOLL
+    sockaddr_un address;
+    if (!MakeAddress(socket_path, &address, error))
+    {
+        return false;
+    }
+
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (epoll_fd < 0 || stop_fd < 0 || listen_fd < 0)
+    {
+        *error = SystemError("Unable to listen on", socket_path);
+        return false;
+    }
+
+    // a socket file that nothing answers on is left from a server that
+    // didn't stop cleanly
+    const auto* bind_address = reinterpret_cast<const sockaddr*>(&address);
+    if (bind(listen_fd, bind_address, sizeof(address)) != 0)
+    {
+        if (errno != EADDRINUSE)
+        {
+            *error = SystemError("Unable to listen on", socket_path);
+            return false;
+        }
+        const int other = ConnectTo(address);
+        if (other >= 0)
+        {
+            close(other);
+            *error = fmt::format("A server is already listening on {}", socket_path);
+            return false;
+        }
+        unlink(socket_path.c_str());
+        if (bind(listen_fd, bind_address, sizeof(address)) != 0)
+        {
+            *error = SystemError("Unable to listen on", socket_path);
+            return false;
+        }
+    }
+    path = socket_path;
+
+    if (listen(listen_fd, SOMAXCONN) != 0)
+    {
+        *error = SystemError("Unable to listen on", socket_path);
+        return false;
+    }
+
+    for (const auto fd: {listen_fd, stop_fd})
+    {
+        auto event = epoll_event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event);
+    }
+    return true;
+#else
+    *error = fmt::format("Unable to listen on {}: not supported by this build", socket_path);
+    return false;
+#endif
+}
+
+
+bool
+Server::StopOnSignals(std::string* error)
+{
+#ifdef CALC_EPOLL
+    sigset_t old_signals;
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    if (epoll_fd < 0 || pthread_sigmask(SIG_BLOCK, &signals, &old_signals) != 0)
+    {
+        *error = "Unable to handle signals";
+        return false;
+    }
+    for (const auto signal: {SIGINT, SIGTERM})
+    {
+        if (sigismember(&old_signals, signal) == 0)
+        {
+            blocked_signals.emplace_back(signal);
+        }
+    }
+
+    signal_fd = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (signal_fd < 0)
+    {
+        *error = "Unable to handle signals";
+        return false;
+    }
+    auto event = epoll_event{};
+    event.events = EPOLLIN;
+    event.data.fd = signal_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, signal_fd, &event);
+    return true;
+#else
+    *error = "Unable to handle signals";
+    return false;
+#endif
+}
+
+
+void
+Server::Stop()
+{
+    stopped = true;
+#ifdef CALC_EPOLL
+    if (stop_fd >= 0)
+    {
+        const std::uint64_t one = 1;
+        static_cast<void>(write(stop_fd, &one, sizeof(one)));
+    }
+#endif
+}
+
+
+bool
+Server::Run(std::string* error)
+{
+#ifdef CALC_EPOLL
+    read_buffer.resize(READ_SIZE);
+    std::array<epoll_event, MAX_EVENTS> events;
+
+    while (!stopped)
+    {
+        const int count = epoll_wait(epoll_fd, events.data(), MAX_EVENTS, -1);
+        if (count < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            *error = SystemError("Unable to serve", path);
+            return false;
+        }
+
+        for (const auto& event: Span<const epoll_event>{events.data(), ToSizet(count)})
+        {
+            const int fd = event.data.fd;
+            if (fd == stop_fd)
+            {
+                stopped = true;
+            }
+            else if (fd == signal_fd)
+            {
+                // read so the signal isn't pending when it's unblocked
+                signalfd_siginfo info;
+                static_cast<void>(read(signal_fd, &info, sizeof(info)));
+                stopped = true;
+            }
+            else if (fd == listen_fd)
+            {
+                Accept();
+            }
+            else
+            {
+                const auto found = clients.find(fd);
+                if (found == clients.end())
+                {
+                    continue;
+                }
+                auto* client = found->second.get();
+                const auto readable = (event.events & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0;
+                if (readable && !client->done_reading && !Read(client))
+                {
+                    continue;
+                }
+                if (Write(client))
+                {
+                    Update(client);
+                }
+            }
+        }
+    }
+    return true;
+#else
+    *error = "Unable to serve: not supported by this build";
+    return false;
+#endif
+}
+
+
+void
+Server::Accept()
+{
+#ifdef CALC_EPOLL
+    for (;;)
+    {
+        const int fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+            {
+                continue;
+            }
+            // out of file descriptors leaves the client waiting, the
+            // listening socket stays readable so it's tried again
+            return;
+        }
+
+        auto client = std::make_unique<Client>();
+        client->fd = fd;
+        client->events = EPOLLIN;
+        auto event = epoll_event{};
+        event.events = client->events;
+        event.data.fd = fd;
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0)
+        {
+            close(fd);
+            continue;
+        }
+        clients.emplace(fd, std::move(client));
+    }
+#endif
+}
+
+
+bool
+Server::Read(Client* client)
+{
+#ifdef CALC_EPOLL
+    const auto count = read(client->fd, read_buffer.data(), read_buffer.size());
+    if (count < 0)
+    {
+        if (errno == EINTR || IsWouldBlock(errno))
+        {
+            return true;
+        }
+        Close(client);
+        return false;
+    }
+
+    const auto answer = [this, client](std::string_view line) {
+        client->line_number += 1;
+        handler(client->line_number, line, &client->output);
+    };
+
+    if (count == 0)
+    {
+        // a last line doesn't need a line ending
+        client->done_reading = true;
+        if (!client->input.empty())
+        {
+            client->input.push_back('\n');
+        }
+    }
+    else
+    {
+        client->input.append(read_buffer.data(), static_cast<std::size_t>(count));
+    }
+
+    ForEachLine(&client->input, answer);
+    if (client->input.size() > MAX_LINE_SIZE)
+    {
+        Close(client);
+        return false;
+    }
+    return true;
+#else
+    static_cast<void>(client);
+    return false;
+#endif
+}
+
+
+bool
+Server::Write(Client* client)
+{
+#ifdef CALC_EPOLL
+    auto& output = client->output;
+    std::size_t written = 0;
+    while (written < output.size())
+    {
+        const auto count = send(client->fd, output.data() + written, output.size() - written, MSG_NOSIGNAL);
+        if (count < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (IsWouldBlock(errno))
+            {
+                break;
+            }
+            Close(client);
+            return false;
+        }
+        written += static_cast<std::size_t>(count);
+    }
+    output.erase(0, written);
+    return true;
+#else
+    static_cast<void>(client);
+    return false;
+#endif
+}
+
+
+bool
+Server::Update(Client* client)
+{
+#ifdef CALC_EPOLL
+    if (client->done_reading && client->output.empty())
+    {
+        Close(client);
+        return false;
+    }
+
+    std::uint32_t events = 0;
+    if (!client->done_reading && client->output.size() < MAX_PENDING_REPLIES)
+    {
+        events |= EPOLLIN;
+    }
+    if (!client->output.empty())
+    {
+        events |= EPOLLOUT;
+    }
+    if (events != client->events)
+    {
+        client->events = events;
+        auto event = epoll_event{};
+        event.events = events;
+        event.data.fd = client->fd;
+        epoll_ctl(epoll_fd, EPOLL_CTL_MOD, client->fd, &event);
+    }
+    return true;
+#else
+    static_cast<void>(client);
+    return false;
+#endif
+}
+
+
+void
+Server::Close(Client* client)
+{
+#ifdef CALC_EPOLL
+    const int fd = client->fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    clients.erase(fd);
+#else
+    static_cast<void>(client);
+#endif
+}
+
+
+bool
+SendRequests(
+        const std::string& path,
+        const RequestSource& next_line,
+        const ReplyHandler& on_reply,
+        std::string* error)
+{
+#ifdef CALC_EPOLL
+    sockaddr_un address;
+    if (!MakeAddress(path, &address, error))
+    {
+        return false;
+    }
+    const int fd = ConnectTo(address);
+    if (fd < 0)
+    {
+        *error = SystemError("Unable to connect to", path);
+        return false;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    std::string requests;
+    std::string replies;
+    std::vector<char> buffer(READ_SIZE);
+    bool sending = true;
+    bool shut = false;
+    bool ok = true;
+
+    for (;;)
+    {
+        while (sending && requests.size() < MAX_PENDING_REQUESTS)
+        {
+            std::string_view line;
+            if (!next_line(&line))
+            {
+                sending = false;
+                break;
+            }
+            requests.append(line);
+            requests.push_back('\n');
+        }
+        if (!sending && requests.empty() && !shut)
+        {
+            // the server closes the connection after the last reply
+            shutdown(fd, SHUT_WR);
+            shut = true;
+        }
+
+        auto poll_fd = pollfd{};
+        poll_fd.fd = fd;
+        poll_fd.events = static_cast<short>(requests.empty() ? POLLIN : POLLIN | POLLOUT);
+        if (poll(&poll_fd, 1, -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            *error = SystemError("Unable to talk to", path);
+            ok = false;
+            break;
+        }
+
+        if ((poll_fd.revents & POLLOUT) != 0)
+        {
+            const auto count = send(fd, requests.data(), requests.size(), MSG_NOSIGNAL);
+            if (count < 0 && errno != EINTR && !IsWouldBlock(errno))
+            {
+                *error = SystemError("Unable to send to", path);
+                ok = false;
+                break;
+            }
+            requests.erase(0, count < 0 ? 0 : static_cast<std::size_t>(count));
+        }
+
+        if ((poll_fd.revents & (POLLIN | POLLHUP | POLLERR)) != 0)
+        {
+            const auto count = read(fd, buffer.data(), buffer.size());
+            if (count == 0)
+            {
+                break;
+            }
+            if (count < 0 && errno != EINTR && !IsWouldBlock(errno))
+            {
+                *error = SystemError("Unable to read from", path);
+                ok = false;
+                break;
+            }
+            if (count > 0)
+            {
+                replies.append(buffer.data(), static_cast<std::size_t>(count));
+                ForEachLine(&replies, on_reply);
+            }
+        }
+    }
+
+    if (ok && (sending || !requests.empty()))
+    {
+        *error = fmt::format("{} closed the connection", path);
+        ok = false;
+    }
+    close(fd);
+    return ok;
+#else
+    static_cast<void>(next_line);
+    static_cast<void>(on_reply);
+    *error = fmt::format("Unable to connect to {}: not supported by this build", path);
+    return false;
+#endif
+}
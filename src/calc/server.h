@@ -0,0 +1,139 @@
+#ifndef CALC_SERVER_H
+#define CALC_SERVER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+
+// answers one line of a client by appending to the reply, the line number
+// counts the lines of the client starting at 1
+using RequestHandler = std::function<void(std::size_t line_number, std::string_view line, std::string* reply)>;
+
+
+// a server on a unix domain socket that answers lines from any number of
+// clients with one epoll loop on the calling thread
+//
+// a client can send many lines before it reads any replies, the replies
+// are written in the order of the lines, a client that doesn't read its
+// replies isn't read from until they are written so a slow client can't
+// make the server buffer without limit, once a client stops sending it's
+// closed after its last reply
+//
+// only built on linux, elsewhere Listen fails
+struct Server
+{
+    explicit Server(RequestHandler handler);
+    ~Server();
+
+    Server(const Server&) = delete;
+    Server(Server&&) = delete;
+    void
+    operator=(const Server&) = delete;
+    void
+    operator=(Server&&) = delete;
+
+    // true if this build can serve at all
+    [[nodiscard]] static bool
+    IsSupported();
+
+    // binds the socket and removes it again when the server is destroyed,
+    // a socket file that nothing listens on is left from a server that
+    // didn't stop cleanly and is replaced, false with the error set
+    bool
+    Listen(const std::string& path, std::string* error);
+
+    // SIGINT and SIGTERM stop Run instead of the process, they are blocked
+    // in the calling thread until the server is destroyed, so this only
+    // works when no other thread can receive them
+    bool
+    StopOnSignals(std::string* error);
+
+    // answers clients until Stop is called, false with the error set if
+    // the loop fails
+    bool
+    Run(std::string* error);
+
+    // can be called from any thread
+    void
+    Stop();
+
+private:
+    struct Client
+    {
+        int fd;
+        std::size_t line_number = 0;
+
+        // the start of a line that hasn't been received completely
+        std::string input;
+
+        // replies that haven't been written yet
+        std::string output;
+
+        // the client won't send more lines
+        bool done_reading = false;
+
+        // the events the client is registered for
+        std::uint32_t events = 0;
+    };
+
+    RequestHandler handler;
+
+    std::string path;
+    int listen_fd = -1;
+    int epoll_fd = -1;
+    int stop_fd = -1;
+    int signal_fd = -1;
+
+    std::atomic<bool> stopped = false;
+
+    // the signals StopOnSignals blocked that weren't blocked before
+    std::vector<int> blocked_signals;
+
+    std::unordered_map<int, std::unique_ptr<Client>> clients;
+    std::vector<char> read_buffer;
+
+    void
+    Accept();
+
+    // false if the client was closed
+    bool
+    Read(Client* client);
+
+    bool
+    Write(Client* client);
+
+    bool
+    Update(Client* client);
+
+    void
+    Close(Client* client);
+};
+
+
+// gives the next line to send, false when there are no more lines
+using RequestSource = std::function<bool(std::string_view* line)>;
+
+// called for each line a server sends back, without the line ending
+using ReplyHandler = std::function<void(std::string_view line)>;
+
+
+// sends all lines to the server at the path while the replies are read, so
+// the lines are pipelined instead of waiting for each reply, returns once
+// the server has answered every line, false with the error set if the
+// connection fails
+bool
+SendRequests(
+        const std::string& path,
+        const RequestSource& next_line,
+        const ReplyHandler& on_reply,
+        std::string* error);
+
+
+#endif  // CALC_SERVER_H
@@ -0,0 +1,69 @@
+#ifndef CALC_SPAN_H
+#define CALC_SPAN_H
+
+#include <cstddef>
+#include <vector>
+#include <type_traits>
+
+
+// a non owning view of a contiguous range, until we can depend on c++20
+template <typename T>
+struct Span
+{
+    T* data = nullptr;
+    std::size_t size = 0;
+
+    constexpr Span() = default;
+
+    constexpr Span(T* d, std::size_t s) : data(d), size(s) {}
+
+    // a span of mutable values can be viewed as a span of const values
+    template <
+            typename U,
+            typename = std::enable_if_t<std::is_convertible_v<U (*)[], T (*)[]>>>
+    constexpr Span(const Span<U>& s) : data(s.data), size(s.size)
+    {
+    }
+
+    template <
+            typename V,
+            typename = std::enable_if_t<std::is_convertible_v<V (*)[], T (*)[]>>>
+    Span(std::vector<V>& v) : data(v.data()), size(v.size())
+    {
+    }
+
+    template <
+            typename V,
+            typename = std::enable_if_t<
+                    std::is_convertible_v<const V (*)[], T (*)[]>>>
+    Span(const std::vector<V>& v) : data(v.data()), size(v.size())
+    {
+    }
+
+    constexpr T&
+    operator[](std::size_t index) const
+    {
+        return data[index];
+    }
+
+    constexpr T*
+    begin() const
+    {
+        return data;
+    }
+
+    constexpr T*
+    end() const
+    {
+        return data + size;
+    }
+
+    [[nodiscard]] constexpr bool
+    empty() const
+    {
+        return size == 0;
+    }
+};
+
+
+#endif  // CALC_SPAN_H
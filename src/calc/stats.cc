@@ -0,0 +1,84 @@
+#include "calc/stats.h"
+
+#include <fmt/format.h>
+
+#include "calc/output.h"
+
+
+const char*
+PhaseName(Phase phase)
+{
+    switch (phase)
+    {
+    case Phase::LEX: return "lex";
+    case Phase::PARSE: return "parse";
+    case Phase::OPTIMIZE: return "optimize";
+    case Phase::COMPILE: return "compile";
+    case Phase::EVAL: return "eval";
+    case Phase::OUTPUT: return "output";
+    }
+    return "unknown";
+}
+
+
+void
+Stats::Add(const Stats& other)
+{
+    expressions += other.expressions;
+    timed_expressions += other.timed_expressions;
+    cache_hits += other.cache_hits;
+    tokens += other.tokens;
+    nodes += other.nodes;
+    bytes_in += other.bytes_in;
+    bytes_out += other.bytes_out;
+    arena_bytes += other.arena_bytes;
+    for (std::size_t phase = 0; phase < PHASE_COUNT; phase += 1)
+    {
+        nanoseconds[phase] += other.nanoseconds[phase];
+    }
+}
+
+
+double
+Stats::EstimatedNanoseconds(Phase phase) const
+{
+    if (timed_expressions == 0)
+    {
+        return 0;
+    }
+    const auto ns = static_cast<double>(nanoseconds[static_cast<std::size_t>(phase)]);
+    return ns * static_cast<double>(expressions) / static_cast<double>(timed_expressions);
+}
+
+
+void
+PrintStats(Output* output, const Stats& stats)
+{
+    output->PrintInfo(fmt::format(
+            "stats: {} expressions, {} timed, {} cache hits",
+            stats.expressions,
+            stats.timed_expressions,
+            stats.cache_hits));
+    output->PrintInfo(fmt::format(
+            "stats: {} tokens, {} nodes, {} arena bytes",
+            stats.tokens,
+            stats.nodes,
+            stats.arena_bytes));
+    output->PrintInfo(fmt::format(
+            "stats: {} bytes in, {} bytes out", stats.bytes_in, stats.bytes_out));
+
+    double total = 0;
+    for (std::size_t phase = 0; phase < PHASE_COUNT; phase += 1)
+    {
+        total += stats.EstimatedNanoseconds(static_cast<Phase>(phase));
+    }
+    for (std::size_t phase = 0; phase < PHASE_COUNT; phase += 1)
+    {
+        const auto ns = stats.EstimatedNanoseconds(static_cast<Phase>(phase));
+        output->PrintInfo(fmt::format(
+                "stats: {:<8} {:>12.3f} ms {:>5.1f}%",
+                PhaseName(static_cast<Phase>(phase)),
+                ns / 1e6,
+                total > 0 ? ns / total * 100 : 0.0));
+    }
+}
@@ -0,0 +1,88 @@
+#ifndef CALC_STATS_H
+#define CALC_STATS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+struct Output;
+
+
+// the phases an expression goes through, in order, with --equiv and
+// --minimize building the diagram is compile and comparing or reordering
+// it is eval, a truth table is evaluated while it's printed so it is output
+enum class Phase : std::uint8_t
+{
+    LEX,
+    PARSE,
+    OPTIMIZE,
+    COMPILE,
+    EVAL,
+    OUTPUT
+};
+
+constexpr std::size_t PHASE_COUNT = 6;
+
+
+const char*
+PhaseName(Phase phase);
+
+
+// what a run spent its time on, the counters are exact but only one in
+// STATS_SAMPLE_INTERVAL expressions is timed, reading the clock for every
+// phase of every expression would cost more than the short ones take
+//
+// stats are only collected when built with ENABLE_STATS
+struct Stats
+{
+    std::uint64_t expressions = 0;
+    std::uint64_t timed_expressions = 0;
+    std::uint64_t cache_hits = 0;
+
+    std::uint64_t tokens = 0;
+    std::uint64_t nodes = 0;
+    std::uint64_t bytes_in = 0;
+    std::uint64_t bytes_out = 0;
+
+    // the ast memory, the library doesn't see other allocations
+    std::uint64_t arena_bytes = 0;
+
+    // the time of the timed expressions, by phase
+    std::array<std::uint64_t, PHASE_COUNT> nanoseconds = {};
+
+    // stats of another thread or run
+    void
+    Add(const Stats& other);
+
+    // the time of all expressions estimated from the timed ones
+    [[nodiscard]] double
+    EstimatedNanoseconds(Phase phase) const;
+};
+
+constexpr std::uint64_t STATS_SAMPLE_INTERVAL = 64;
+
+// true if the expression with this number, counting from 1, is timed
+constexpr bool
+IsTimedExpression(std::uint64_t expression)
+{
+    return expression % STATS_SAMPLE_INTERVAL == 1;
+}
+
+// false if the library was built without ENABLE_STATS
+#ifdef CALC_ENABLE_STATS
+constexpr bool STATS_ENABLED = true;
+#else
+constexpr bool STATS_ENABLED = false;
+#endif
+
+
+using StatsCallback = std::function<void(const Stats&)>;
+
+
+// a summary with one line per counter and phase
+void
+PrintStats(Output* output, const Stats& stats);
+
+
+#endif  // CALC_STATS_H
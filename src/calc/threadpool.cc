@@ -0,0 +1,153 @@
+#include "calc/threadpool.h"
+
+#include <cassert>
+
+
+ThreadPool::ThreadPool(std::size_t worker_count)
+    : queues(worker_count == 0 ? 1 : worker_count)
+{
+    for (std::size_t worker = 1; worker < queues.size(); worker += 1)
+    {
+        threads.emplace_back([this, worker]() { Work(worker); });
+    }
+}
+
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        stop = true;
+    }
+    wake.notify_all();
+    for (auto& thread: threads)
+    {
+        thread.join();
+    }
+}
+
+
+std::size_t
+ThreadPool::Size() const
+{
+    return queues.size();
+}
+
+
+void
+ThreadPool::Run(std::size_t count, const Task& task)
+{
+    // split the indices evenly, stealing evens out the rest
+    const auto worker_count = queues.size();
+    for (std::size_t worker = 0; worker < worker_count; worker += 1)
+    {
+        std::lock_guard<std::mutex> lock{queues[worker].mutex};
+        queues[worker].begin = count * worker / worker_count;
+        queues[worker].end = count * (worker + 1) / worker_count;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        current = &task;
+        finished = 0;
+        generation += 1;
+    }
+    wake.notify_all();
+
+    Drain(0, task);
+
+    // a worker only finishes when there is nothing left to steal, so once
+    // all of them are done no task is running and the queues can be reused
+    std::unique_lock<std::mutex> lock{mutex};
+    done.wait(lock, [this]() { return finished == threads.size(); });
+    current = nullptr;
+}
+
+
+void
+ThreadPool::Work(std::size_t worker)
+{
+    std::size_t seen = 0;
+    while (true)
+    {
+        const Task* task = nullptr;
+        {
+            std::unique_lock<std::mutex> lock{mutex};
+            wake.wait(lock, [&]() { return stop || generation != seen; });
+            if (stop)
+            {
+                return;
+            }
+            seen = generation;
+            task = current;
+        }
+
+        assert(task != nullptr);
+        Drain(worker, *task);
+
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            finished += 1;
+        }
+        done.notify_one();
+    }
+}
+
+
+void
+ThreadPool::Drain(std::size_t worker, const Task& task)
+{
+    std::size_t index = 0;
+    while (Pop(worker, &index) || Steal(worker, &index))
+    {
+        task(index, worker);
+    }
+}
+
+
+bool
+ThreadPool::Pop(std::size_t worker, std::size_t* index)
+{
+    auto& queue = queues[worker];
+    std::lock_guard<std::mutex> lock{queue.mutex};
+    if (queue.begin == queue.end)
+    {
+        return false;
+    }
+    *index = queue.begin;
+    queue.begin += 1;
+    return true;
+}
+
+
+bool
+ThreadPool::Steal(std::size_t worker, std::size_t* index)
+{
+    const auto worker_count = queues.size();
+    for (std::size_t offset = 1; offset < worker_count; offset += 1)
+    {
+        auto& victim = queues[(worker + offset) % worker_count];
+
+        // take the back half, only one queue is locked at a time
+        std::size_t begin = 0;
+        std::size_t end = 0;
+        {
+            std::lock_guard<std::mutex> lock{victim.mutex};
+            if (victim.begin == victim.end)
+            {
+                continue;
+            }
+            begin = victim.end - (victim.end - victim.begin + 1) / 2;
+            end = victim.end;
+            victim.end = begin;
+        }
+
+        auto& queue = queues[worker];
+        std::lock_guard<std::mutex> lock{queue.mutex};
+        *index = begin;
+        queue.begin = begin + 1;
+        queue.end = end;
+        return true;
+    }
+    return false;
+}
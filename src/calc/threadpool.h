@@ -0,0 +1,73 @@
+#ifndef CALC_THREADPOOL_H
+#define CALC_THREADPOOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+// a fixed set of workers that run batches of tasks, each worker starts on
+// its own share of a batch and steals from the others once it runs out
+struct ThreadPool
+{
+    // the calling thread is worker 0 so one less thread is started
+    explicit ThreadPool(std::size_t worker_count);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool(ThreadPool&&) = delete;
+    void
+    operator=(const ThreadPool&) = delete;
+    void
+    operator=(ThreadPool&&) = delete;
+
+    using Task = std::function<void(std::size_t index, std::size_t worker)>;
+
+    [[nodiscard]] std::size_t
+    Size() const;
+
+    // calls task for every index below count and waits for all of them,
+    // tasks on the same worker never run at the same time so the worker
+    // can be used to pick per thread state
+    void
+    Run(std::size_t count, const Task& task);
+
+private:
+    // the remaining indices of a worker, the owner takes from the front
+    // and thieves from the back
+    struct Queue
+    {
+        std::mutex mutex;
+        std::size_t begin = 0;
+        std::size_t end = 0;
+    };
+
+    std::vector<Queue> queues;
+    std::vector<std::thread> threads;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const Task* current = nullptr;
+    std::size_t generation = 0;
+    std::size_t finished = 0;
+    bool stop = false;
+
+    void
+    Work(std::size_t worker);
+
+    void
+    Drain(std::size_t worker, const Task& task);
+
+    bool
+    Pop(std::size_t worker, std::size_t* index);
+
+    bool
+    Steal(std::size_t worker, std::size_t* index);
+};
+
+
+#endif  // CALC_THREADPOOL_H
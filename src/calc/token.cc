@@ -2,34 +2,65 @@
 
 #include <array>
 #include <string_view>
-#include <sstream>
 #include <cassert>
 
+#include "calc/ints.h"
+#include "calc/value.h"
 
-[[nodiscard]] std::string
-Token::ToString() const
+
+std::string_view
+TokenTypeName(int type)
 {
     constexpr std::array NAMES{
             std::string_view{"NUMBER"},
+            std::string_view{"VAR"},
             std::string_view{"AND"},
             std::string_view{"OR"},
+            std::string_view{"XOR"},
+            std::string_view{"NOT"},
+            std::string_view{"SHL"},
+            std::string_view{"SHR"},
+            std::string_view{"LPAREN"},
+            std::string_view{"RPAREN"},
             std::string_view{"EOF"}};
-    using A = decltype(NAMES);
+    return NAMES[ToSizet(type)];
+}
 
-    std::stringstream ss;
 
-    ss << NAMES[static_cast<A::size_type>(type)];
+bool
+IsOperandType(int type)
+{
+    return type == Token<std::uint32_t>::NUMBER || type == Token<std::uint32_t>::VARIABLE;
+}
+
+
+template <typename V>
+[[nodiscard]] std::string
+Token<V>::ToString() const
+{
+    fmt::memory_buffer buffer;
+
+    buffer.append(TokenTypeName(type));
 
     if (type == NUMBER)
     {
-        ss << "(" << value << ")";
+        buffer.push_back('(');
+        AppendDecimal(&buffer, value);
+        buffer.push_back(')');
+    }
+    if (type == VARIABLE)
+    {
+        buffer.push_back('(');
+        buffer.append(name);
+        buffer.push_back(')');
     }
-    return ss.str();
+    return fmt::to_string(buffer);
 }
 
 
-Token
-Token::Number(int num)
+template <typename V>
+Token<V>
+Token<V>::Number(const V& num)
 {
     Token ret{};
     ret.type = NUMBER;
@@ -38,35 +69,101 @@ Token::Number(int num)
 }
 
 
-Token
-Token::And()
+template <typename V>
+Token<V>
+Token<V>::Variable(std::string_view identifier)
+{
+    Token ret{};
+    ret.type = VARIABLE;
+    ret.name = identifier;
+    return ret;
+}
+
+
+template <typename V>
+Token<V>
+Token<V>::And()
 {
     return FromType(OPAND);
 }
 
 
-Token
-Token::Or()
+template <typename V>
+Token<V>
+Token<V>::Or()
 {
     return FromType(OPOR);
 }
 
 
-const Token&
-Token::Eof()
+template <typename V>
+Token<V>
+Token<V>::Xor()
+{
+    return FromType(OPXOR);
+}
+
+
+template <typename V>
+Token<V>
+Token<V>::Not()
+{
+    return FromType(OPNOT);
+}
+
+
+template <typename V>
+Token<V>
+Token<V>::ShiftLeft()
+{
+    return FromType(OPSHL);
+}
+
+
+template <typename V>
+Token<V>
+Token<V>::ShiftRight()
+{
+    return FromType(OPSHR);
+}
+
+
+template <typename V>
+Token<V>
+Token<V>::LeftParen()
+{
+    return FromType(LPAREN);
+}
+
+
+template <typename V>
+Token<V>
+Token<V>::RightParen()
+{
+    return FromType(RPAREN);
+}
+
+
+template <typename V>
+const Token<V>&
+Token<V>::Eof()
 {
     static auto Eof = FromType(EOFTOKEN);
     return Eof;
 }
 
 
-Token
-Token::FromType(Type t)
+template <typename V>
+Token<V>
+Token<V>::FromType(Type t)
 {
-    assert(t != NUMBER);
+    assert(t != NUMBER && t != VARIABLE);
     Token ret{};
     ret.type = t;
-    ret.value = 0;
     return ret;
 }
 
+
+#define INSTANTIATE(V) template struct Token<V>;
+CALC_FOR_EACH_VALUE(INSTANTIATE)
+#undef INSTANTIATE
@@ -2,15 +2,24 @@
 #define CALC_TOKEN_H
 
 #include <string>
+#include <string_view>
 
 
+template <typename V>
 struct Token
 {
     enum Type
     {
         NUMBER,
+        VARIABLE,
         OPAND,
         OPOR,
+        OPXOR,
+        OPNOT,
+        OPSHL,
+        OPSHR,
+        LPAREN,
+        RPAREN,
         EOFTOKEN
     };
 
@@ -18,10 +27,17 @@ struct Token
     ToString() const;
 
     Type type;
-    int value;
+    V value;
+
+    // the variable name, points into the lexed source, the lexer sets it
+    // to the source of the other tokens too
+    std::string_view name;
+
+    static Token
+    Number(const V& num);
 
     static Token
-    Number(int num);
+    Variable(std::string_view identifier);
 
     static Token
     And();
@@ -29,6 +45,24 @@ struct Token
     static Token
     Or();
 
+    static Token
+    Xor();
+
+    static Token
+    Not();
+
+    static Token
+    ShiftLeft();
+
+    static Token
+    ShiftRight();
+
+    static Token
+    LeftParen();
+
+    static Token
+    RightParen();
+
     static const Token&
     Eof();
 
@@ -38,5 +72,13 @@ private:
 };
 
 
-#endif  // CALC_TOKEN_H
+// the name of a token type, the types are the same for all values
+std::string_view
+TokenTypeName(int type);
+
+// true if the token type is a number or a variable
+bool
+IsOperandType(int type);
 
+
+#endif  // CALC_TOKEN_H
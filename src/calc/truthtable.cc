@@ -0,0 +1,159 @@
+#include "calc/truthtable.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "calc/ints.h"
+#include "calc/output.h"
+#include "calc/vm.h"
+
+
+// the value of the lowest 6 bits of the row number for 64 rows in a row,
+// the higher bits are the same for all 64 rows
+constexpr std::array<std::uint64_t, 6> ROW_BITS = {
+        0xaaaaaaaaaaaaaaaa,
+        0xcccccccccccccccc,
+        0xf0f0f0f0f0f0f0f0,
+        0xff00ff00ff00ff00,
+        0xffff0000ffff0000,
+        0xffffffff00000000};
+
+
+// a boolean shifted by 0 is itself and shifted by 1 is 0, that is a & ~b,
+// the shifts are replaced so they don't move the rows between the bits
+void
+ReplaceShifts(Program<std::uint64_t>* program)
+{
+    std::vector<Instruction> code;
+    code.reserve(program->code.size());
+    bool pushes_more = false;
+    for (const auto& instruction: program->code)
+    {
+        switch (instruction.op)
+        {
+        case OpCode::SHL_CONST:
+        case OpCode::SHR_CONST:
+            program->constants.emplace_back(~program->constants[ToSizet(instruction.value)]);
+            code.emplace_back(Instruction{OpCode::AND_CONST, ToInt(program->constants.size() - 1)});
+            break;
+        case OpCode::SHL_VAR:
+        case OpCode::SHR_VAR:
+            code.emplace_back(Instruction{OpCode::PUSH_VAR, instruction.value});
+            code.emplace_back(Instruction{OpCode::NOT, 0});
+            code.emplace_back(Instruction{OpCode::AND, 0});
+            pushes_more = true;
+            break;
+        case OpCode::SHL:
+        case OpCode::SHR:
+            code.emplace_back(Instruction{OpCode::NOT, 0});
+            code.emplace_back(Instruction{OpCode::AND, 0});
+            break;
+        default:
+            code.emplace_back(instruction);
+            break;
+        }
+    }
+    program->code = std::move(code);
+
+    // the pushed variable is popped right away so it adds at most one
+    if (pushes_more)
+    {
+        program->stack_size += 1;
+    }
+}
+
+
+TruthTable::TruthTable(Program<std::uint64_t> p) : program(std::move(p))
+{
+    assert(program.variables.size() <= MAX_TRUTH_TABLE_VARIABLES);
+    for (auto& constant: program.constants)
+    {
+        constant = (constant & 1) != 0 ? ~std::uint64_t{0} : 0;
+    }
+    ReplaceShifts(&program);
+}
+
+
+[[nodiscard]] std::size_t
+TruthTable::VariableCount() const
+{
+    return program.variables.size();
+}
+
+
+[[nodiscard]] std::uint64_t
+TruthTable::RowCount() const
+{
+    return std::uint64_t{1} << VariableCount();
+}
+
+
+[[nodiscard]] std::uint64_t
+TruthTable::EvalRows(std::uint64_t first_row) const
+{
+    assert(first_row % 64 == 0);
+
+    const auto count = VariableCount();
+    std::array<std::uint64_t, MAX_TRUTH_TABLE_VARIABLES> words;
+    for (std::size_t variable = 0; variable < count; variable += 1)
+    {
+        const auto bit = count - 1 - variable;
+        if (bit < ROW_BITS.size())
+        {
+            words[variable] = ROW_BITS[bit];
+        }
+        else
+        {
+            words[variable] = ((first_row >> bit) & 1) != 0 ? ~std::uint64_t{0} : 0;
+        }
+    }
+
+    const auto result = RunProgram(program, words.data());
+    const auto rows = RowCount() - first_row;
+    return rows < 64 ? result & ((std::uint64_t{1} << rows) - 1) : result;
+}
+
+
+void
+TruthTable::Print(Output* output) const
+{
+    const auto count = VariableCount();
+
+    // each value is written under the first char of the variable name
+    std::string line;
+    std::vector<std::size_t> columns;
+    for (const auto& name: program.variables)
+    {
+        columns.emplace_back(line.size());
+        line += name;
+        line += ' ';
+    }
+    line += "| result";
+    output->PrintInfo(line);
+
+    std::fill(line.begin(), line.end(), ' ');
+    line.resize(line.size() - 5);
+    line[line.size() - 3] = '|';
+    const auto result_column = line.size() - 1;
+
+    const auto rows = RowCount();
+    for (std::uint64_t first_row = 0; first_row < rows; first_row += 64)
+    {
+        const auto results = EvalRows(first_row);
+        const auto last_row = std::min(rows, first_row + 64);
+        for (auto row = first_row; row < last_row; row += 1)
+        {
+            for (std::size_t variable = 0; variable < count; variable += 1)
+            {
+                const auto bit = (row >> (count - 1 - variable)) & 1;
+                line[columns[variable]] = bit != 0 ? '1' : '0';
+            }
+            line[result_column] = ((results >> (row - first_row)) & 1) != 0 ? '1' : '0';
+            output->PrintInfo(line);
+        }
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef CALC_TRUTHTABLE_H
+#define CALC_TRUTHTABLE_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "calc/program.h"
+
+struct Output;
+
+
+// the most variables a table can have, the rows are counted in 64 bits
+constexpr std::size_t MAX_TRUTH_TABLE_VARIABLES = 63;
+
+
+// evaluates a expression for every combination of 0 and 1 for its variables,
+// each variable is a word with one bit per row so a single run of the
+// program evaluates 64 rows, the first variable is the highest bit of the
+// row number
+struct TruthTable
+{
+    // constants are booleans too, only the lowest bit is used, and shifting
+    // by 1 clears a value
+    explicit TruthTable(Program<std::uint64_t> p);
+
+    [[nodiscard]] std::size_t
+    VariableCount() const;
+
+    [[nodiscard]] std::uint64_t
+    RowCount() const;
+
+    // bit i is the result of row first_row + i, first_row must be a multiple
+    // of 64 and the bits after the last row are 0
+    [[nodiscard]] std::uint64_t
+    EvalRows(std::uint64_t first_row) const;
+
+    // one line per row, the lines are printed as they are evaluated so the
+    // table is never kept in memory
+    void
+    Print(Output* output) const;
+
+private:
+    Program<std::uint64_t> program;
+};
+
+
+#endif  // CALC_TRUTHTABLE_H
@@ -0,0 +1,83 @@
+#include "calc/value.h"
+
+#include <iterator>
+#include <string_view>
+
+
+
+// the number of words that are needed, at least one so 0 is printed
+template <std::size_t N>
+std::size_t
+UsedWords(const Bits<N>& value)
+{
+    std::size_t used = Bits<N>::WORD_COUNT;
+    while (used > 1 && value.words[used - 1] == 0)
+    {
+        used -= 1;
+    }
+    return used;
+}
+
+
+template <std::size_t N>
+void
+AppendDecimal(fmt::memory_buffer* out, const Bits<N>& value)
+{
+    // 9 decimal digits at a time, the largest power of 10 that fits the 32
+    // bit divisor of DivMod
+    constexpr std::uint32_t DIVISOR = 1000000000;
+    std::array<std::uint32_t, (N + 28) / 29> parts = {};
+    std::size_t count = 0;
+
+    auto rest = value;
+    do
+    {
+        parts[count] = DivMod(&rest, DIVISOR);
+        count += 1;
+    } while (!rest.IsZero());
+
+    fmt::format_to(std::back_inserter(*out), "{}", parts[count - 1]);
+    for (std::size_t i = count - 1; i > 0; i -= 1)
+    {
+        fmt::format_to(std::back_inserter(*out), "{:09}", parts[i - 1]);
+    }
+}
+
+
+template <std::size_t N>
+void
+AppendHex(fmt::memory_buffer* out, const Bits<N>& value)
+{
+    const auto used = UsedWords(value);
+    fmt::format_to(std::back_inserter(*out), "{:x}", value.words[used - 1]);
+    for (std::size_t i = used - 1; i > 0; i -= 1)
+    {
+        fmt::format_to(std::back_inserter(*out), "{:016x}", value.words[i - 1]);
+    }
+}
+
+
+template <std::size_t N>
+void
+AppendBinary(fmt::memory_buffer* out, const Bits<N>& value)
+{
+    // 64 is a multiple of 4 so the groups continue over the words
+    BinaryBuffer buffer;
+    const auto used = UsedWords(value);
+    out->append(FormatBinary(value.words[used - 1], &buffer));
+    for (std::size_t i = used - 1; i > 0; i -= 1)
+    {
+        out->push_back(' ');
+        out->append(FormatBinary(value.words[i - 1], &buffer, 64));
+    }
+}
+
+
+#define INSTANTIATE(N) \
+    template void AppendDecimal(fmt::memory_buffer* out, const Bits<N>& value); \
+    template void AppendHex(fmt::memory_buffer* out, const Bits<N>& value); \
+    template void AppendBinary(fmt::memory_buffer* out, const Bits<N>& value);
+INSTANTIATE(128)
+INSTANTIATE(256)
+INSTANTIATE(512)
+#undef INSTANTIATE
@@ -0,0 +1,129 @@
+#ifndef CALC_VALUE_H
+#define CALC_VALUE_H
+
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+
+#include <fmt/format.h>
+
+#include "calc/binary.h"
+#include "calc/bits.h"
+
+
+// the lexer, the nodes and the vm are templates over the type of the values,
+// either one of the unsigned builtin types or a wider Bits, the templates
+// are defined in the .cc files and instantiated for these types
+#define CALC_FOR_EACH_VALUE(MACRO) \
+    MACRO(std::uint8_t) \
+    MACRO(std::uint16_t) \
+    MACRO(std::uint32_t) \
+    MACRO(std::uint64_t) \
+    MACRO(Bits<128>) \
+    MACRO(Bits<256>) \
+    MACRO(Bits<512>)
+
+
+template <typename V>
+constexpr std::size_t BIT_WIDTH = sizeof(V) * CHAR_BIT;
+
+
+template <typename V>
+constexpr V
+AllBits()
+{
+    return static_cast<V>(~V{});
+}
+
+
+// ~ promotes the narrow types to int so the result is cast back
+template <typename V>
+constexpr V
+Complement(const V& value)
+{
+    return static_cast<V>(~value);
+}
+
+
+// the number of bits to shift by, saturated at the width of the type
+template <typename V>
+constexpr std::enable_if_t<std::is_unsigned_v<V>, std::size_t>
+ShiftAmount(V amount)
+{
+    return amount < BIT_WIDTH<V> ? static_cast<std::size_t>(amount) : BIT_WIDTH<V>;
+}
+
+
+// shifts are defined for every amount, unlike the builtin operators,
+// shifting the width or more bits gives 0
+template <typename V>
+constexpr void
+ShiftLeft(V* value, const V& amount)
+{
+    const auto count = ShiftAmount(amount);
+    *value = count < BIT_WIDTH<V> ? static_cast<V>(*value << count) : V{};
+}
+
+template <typename V>
+constexpr void
+ShiftRight(V* value, const V& amount)
+{
+    const auto count = ShiftAmount(amount);
+    *value = count < BIT_WIDTH<V> ? static_cast<V>(*value >> count) : V{};
+}
+
+
+// value = value * factor + add, false if the result doesn't fit
+template <typename V>
+constexpr std::enable_if_t<std::is_unsigned_v<V>, bool>
+MulAdd(V* value, std::uint32_t factor, std::uint32_t add)
+{
+    if (*value > (std::numeric_limits<V>::max() - add) / factor)
+    {
+        return false;
+    }
+    *value = static_cast<V>(*value * factor + add);
+    return true;
+}
+
+
+// appends the text of a value in a base, without a prefix
+template <typename V>
+std::enable_if_t<std::is_unsigned_v<V>>
+AppendDecimal(fmt::memory_buffer* out, V value)
+{
+    fmt::format_to(std::back_inserter(*out), "{}", value);
+}
+
+template <typename V>
+std::enable_if_t<std::is_unsigned_v<V>>
+AppendHex(fmt::memory_buffer* out, V value)
+{
+    fmt::format_to(std::back_inserter(*out), "{:x}", value);
+}
+
+template <typename V>
+std::enable_if_t<std::is_unsigned_v<V>>
+AppendBinary(fmt::memory_buffer* out, V value)
+{
+    BinaryBuffer buffer;
+    out->append(FormatBinary(std::uint64_t{value}, &buffer));
+}
+
+template <std::size_t N>
+void
+AppendDecimal(fmt::memory_buffer* out, const Bits<N>& value);
+
+template <std::size_t N>
+void
+AppendHex(fmt::memory_buffer* out, const Bits<N>& value);
+
+template <std::size_t N>
+void
+AppendBinary(fmt::memory_buffer* out, const Bits<N>& value);
+
+
+#endif  // CALC_VALUE_H
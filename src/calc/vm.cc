@@ -0,0 +1,125 @@
+#include "calc/vm.h"
+
+#include <array>
+#include <cassert>
+
+#include "calc/program.h"
+#include "calc/ints.h"
+#include "calc/lookuptable.h"
+#include "calc/value.h"
+
+
+constexpr int SMALL_STACK_SIZE = 64;
+
+
+template <typename V>
+V
+RunWithStack(const Program<V>& program, const V* variables, V* stack)
+{
+    V top{};
+    V* sp = stack;
+    const V* constants = program.constants.data();
+
+    for (const auto& instruction: program.code)
+    {
+        switch (instruction.op)
+        {
+        case OpCode::PUSH:
+            *sp = top;
+            sp += 1;
+            top = constants[instruction.value];
+            break;
+        case OpCode::PUSH_VAR:
+            *sp = top;
+            sp += 1;
+            top = variables[instruction.value];
+            break;
+        case OpCode::AND_CONST: top &= constants[instruction.value]; break;
+        case OpCode::OR_CONST: top |= constants[instruction.value]; break;
+        case OpCode::XOR_CONST: top ^= constants[instruction.value]; break;
+        case OpCode::SHL_CONST: ShiftLeft(&top, constants[instruction.value]); break;
+        case OpCode::SHR_CONST: ShiftRight(&top, constants[instruction.value]); break;
+        case OpCode::AND_VAR: top &= variables[instruction.value]; break;
+        case OpCode::OR_VAR: top |= variables[instruction.value]; break;
+        case OpCode::XOR_VAR: top ^= variables[instruction.value]; break;
+        case OpCode::SHL_VAR: ShiftLeft(&top, variables[instruction.value]); break;
+        case OpCode::SHR_VAR: ShiftRight(&top, variables[instruction.value]); break;
+        case OpCode::AND:
+            sp -= 1;
+            top = *sp & top;
+            break;
+        case OpCode::OR:
+            sp -= 1;
+            top = *sp | top;
+            break;
+        case OpCode::XOR:
+            sp -= 1;
+            top ^= *sp;
+            break;
+        case OpCode::SHL:
+            sp -= 1;
+            ShiftLeft(sp, top);
+            top = *sp;
+            break;
+        case OpCode::SHR:
+            sp -= 1;
+            ShiftRight(sp, top);
+            top = *sp;
+            break;
+        case OpCode::NOT: top = Complement(top); break;
+        }
+    }
+
+    return top;
+}
+
+
+template <typename V>
+V
+RunWithAnyStack(const Program<V>& program, const V* variables)
+{
+    if constexpr (CAN_TABULATE<V>)
+    {
+        if (!program.table.empty())
+        {
+            return program.table[variables[0]];
+        }
+    }
+
+    // the first push stores the empty register so the stack needs
+    // room for all values that were ever pushed
+    if (program.stack_size <= SMALL_STACK_SIZE)
+    {
+        std::array<V, SMALL_STACK_SIZE> stack;
+        return RunWithStack(program, variables, stack.data());
+    }
+    else
+    {
+        std::vector<V> stack(ToSizet(program.stack_size));
+        return RunWithStack(program, variables, stack.data());
+    }
+}
+
+
+template <typename V>
+[[nodiscard]] V
+RunProgram(const Program<V>& program, const std::vector<V>& variables)
+{
+    assert(variables.size() >= program.variables.size() && "missing variable value");
+    return RunWithAnyStack(program, variables.data());
+}
+
+
+template <typename V>
+[[nodiscard]] V
+RunProgram(const Program<V>& program, const V* variables)
+{
+    return RunWithAnyStack(program, variables);
+}
+
+
+#define INSTANTIATE(V) \
+    template V RunProgram(const Program<V>& program, const std::vector<V>& variables); \
+    template V RunProgram(const Program<V>& program, const V* variables);
+CALC_FOR_EACH_VALUE(INSTANTIATE)
+#undef INSTANTIATE
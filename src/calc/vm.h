@@ -0,0 +1,22 @@
+#ifndef CALC_VM_H
+#define CALC_VM_H
+
+#include <vector>
+
+template <typename V>
+struct Program;
+
+
+// evaluates a compiled program, gives the same result as Node::Calculate
+template <typename V>
+[[nodiscard]] V
+RunProgram(const Program<V>& program, const std::vector<V>& variables);
+
+
+// same as above but the variables only need to be in contiguous memory
+template <typename V>
+[[nodiscard]] V
+RunProgram(const Program<V>& program, const V* variables);
+
+
+#endif  // CALC_VM_H
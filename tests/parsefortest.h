@@ -0,0 +1,29 @@
+#ifndef TESTS_PARSEFORTEST_H
+#define TESTS_PARSEFORTEST_H
+
+#include <string>
+
+#include "catch.hpp"
+
+#include "calc/arena.h"
+#include "calc/ast.h"
+#include "calc/errorhandler.h"
+#include "calc/lexer.h"
+#include "calc/parser.h"
+
+
+// the tree of a source that must lex and parse without errors
+template <typename V>
+Node<V>*
+ParseForTest(const std::string& source, AstArena* arena)
+{
+    ErrorHandler errors;
+    const auto tokens = RunLexer<V>(source, &errors);
+    REQUIRE_FALSE(errors.HasErr());
+    auto* root = RunParser(tokens, &errors, arena);
+    REQUIRE_FALSE(errors.HasErr());
+    return root;
+}
+
+
+#endif  // TESTS_PARSEFORTEST_H
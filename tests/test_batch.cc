@@ -0,0 +1,137 @@
+#include "catch.hpp"
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "calc/compiledexpr.h"
+#include "calc/errorhandler.h"
+#include "calc/kernels.h"
+
+
+CompiledExpr
+CompileForBatch(const std::string& source)
+{
+    ErrorHandler errors;
+    auto expr = CompileExpression(source, &errors);
+    REQUIRE_FALSE(errors.HasErr());
+    return expr;
+}
+
+
+std::vector<std::uint64_t>
+RandomColumn(std::size_t size, unsigned int seed)
+{
+    auto engine = std::mt19937_64{seed};
+    std::vector<std::uint64_t> column(size);
+    for (auto& value: column)
+    {
+        value = engine();
+    }
+    return column;
+}
+
+
+TEST_CASE("batch-single-variable", "[batch]")
+{
+    const auto expr = CompileForBatch("x & 0xff00 | 0x3");
+    const auto x = std::vector<std::uint64_t>{0, 0x1234, 0xffffffffffffffff, 0xab00};
+    auto out = std::vector<std::uint64_t>(x.size());
+
+    expr.EvalBatch(x, out);
+
+    CHECK(out == std::vector<std::uint64_t>{0x3, 0x1203, 0xff03, 0xab03});
+}
+
+
+TEST_CASE("batch-matches-scalar", "[batch]")
+{
+    const auto source = GENERATE(
+            std::string{"42"},
+            std::string{"x"},
+            std::string{"x & 0xff00 | y"},
+            std::string{"x | y & z | 0x10 & x"},
+            std::string{"0xf0f0 & x | y & 0x0ff0 | z & y & x"},
+            std::string{"~x ^ y << 3 ^ z >> (y & 0x3f)"},
+            std::string{"(x << z) ^ (0xff >> x) ^ 0xf0"});
+    const auto size = GENERATE(
+            std::size_t{0},
+            std::size_t{1},
+            std::size_t{7},
+            std::size_t{256},
+            std::size_t{1000});
+
+    const auto expr = CompileForBatch(source);
+
+    std::vector<std::vector<std::uint64_t>> values;
+    std::vector<Span<const std::uint64_t>> columns;
+    for (std::size_t i = 0; i < expr.Variables().size(); i += 1)
+    {
+        values.emplace_back(RandomColumn(size, static_cast<unsigned int>(i + 1)));
+    }
+    for (const auto& column: values)
+    {
+        columns.emplace_back(column);
+    }
+
+    std::vector<std::uint64_t> expected(size);
+    for (std::size_t row = 0; row < size; row += 1)
+    {
+        std::vector<std::uint64_t> variables;
+        for (const auto& column: values)
+        {
+            variables.emplace_back(column[row]);
+        }
+        expected[row] = expr.Eval(variables);
+    }
+
+    for (const auto* kernels: AvailableKernels())
+    {
+        INFO(source);
+        INFO(kernels->name);
+        auto out = std::vector<std::uint64_t>(size);
+        expr.EvalBatch(columns, out, *kernels);
+        CHECK(out == expected);
+    }
+}
+
+
+TEST_CASE("batch-kernels", "[batch]")
+{
+    const auto size = GENERATE(std::size_t{1}, std::size_t{9}, std::size_t{67});
+    const auto src = RandomColumn(size, 42);
+    const auto start = RandomColumn(size, 7);
+    const auto& scalar = ScalarKernels();
+
+    for (const auto* kernels: AvailableKernels())
+    {
+        INFO(kernels->name);
+
+        auto expected = start;
+        auto actual = start;
+
+        scalar.and_const(expected.data(), 0xff00ff00ff00ff00, size);
+        kernels->and_const(actual.data(), 0xff00ff00ff00ff00, size);
+        CHECK(actual == expected);
+
+        scalar.or_const(expected.data(), 0x1111, size);
+        kernels->or_const(actual.data(), 0x1111, size);
+        CHECK(actual == expected);
+
+        scalar.and_array(expected.data(), src.data(), size);
+        kernels->and_array(actual.data(), src.data(), size);
+        CHECK(actual == expected);
+
+        scalar.or_array(expected.data(), src.data(), size);
+        kernels->or_array(actual.data(), src.data(), size);
+        CHECK(actual == expected);
+
+        scalar.xor_const(expected.data(), 0xf0f0f0f0f0f0f0f0, size);
+        kernels->xor_const(actual.data(), 0xf0f0f0f0f0f0f0f0, size);
+        CHECK(actual == expected);
+
+        scalar.xor_array(expected.data(), src.data(), size);
+        kernels->xor_array(actual.data(), src.data(), size);
+        CHECK(actual == expected);
+    }
+}
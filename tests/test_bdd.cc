@@ -0,0 +1,324 @@
+#include "catch.hpp"
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "calc/arena.h"
+#include "calc/bdd.h"
+#include "calc/calc.h"
+#include "calc/compiler.h"
+#include "calc/truthtable.h"
+
+#include "parsefortest.h"
+
+
+constexpr std::size_t BDD_TEST_VARIABLES = 5;
+
+
+// a random expression of the variables a to e
+std::string
+RandomBoolExpression(std::mt19937* random, int depth)
+{
+    const auto pick = [random](int count) { return std::uniform_int_distribution<int>{0, count - 1}(*random); };
+    if (depth == 0 || pick(4) == 0)
+    {
+        if (pick(5) == 0)
+        {
+            return fmt::format("{}", pick(4));
+        }
+        return std::string(1, static_cast<char>('a' + pick(BDD_TEST_VARIABLES)));
+    }
+
+    static const char* const operators[] = {" & ", " | ", " ^ ", " << ", " >> "};
+    if (pick(6) == 0)
+    {
+        return fmt::format("~({})", RandomBoolExpression(random, depth - 1));
+    }
+    return fmt::format(
+            "({}{}{})",
+            RandomBoolExpression(random, depth - 1),
+            operators[pick(5)],
+            RandomBoolExpression(random, depth - 1));
+}
+
+
+// all variables are used in the same order so the rows of the truth table
+// line up, the first variable is the highest bit of a row
+std::uint64_t
+TruthTableRows(const std::string& source, AstArena* arena)
+{
+    const auto* root = ParseForTest<std::uint64_t>(fmt::format("(a | b | c | d | e) & 0 | {}", source), arena);
+    return TruthTable{CompileProgram(*root)}.EvalRows(0);
+}
+
+
+// the function that is only true for the row
+Bdd
+RowFunction(BddManager* manager, std::uint64_t row)
+{
+    auto function = manager->True();
+    for (std::size_t variable = 0; variable < BDD_TEST_VARIABLES; variable += 1)
+    {
+        const auto name = std::string(1, static_cast<char>('a' + variable));
+        const auto value = (row >> (BDD_TEST_VARIABLES - 1 - variable)) & 1;
+        const auto literal = manager->Variable(name);
+        function = manager->And(function, value != 0 ? literal : manager->Not(literal));
+    }
+    return function;
+}
+
+
+// true if the function is true for the row
+bool
+IsTrueFor(BddManager* manager, const Bdd& function, std::uint64_t row)
+{
+    const auto row_function = RowFunction(manager, row);
+    return manager->And(function, row_function) == row_function;
+}
+
+
+TEST_CASE("bdd-matches-truthtable", "[bdd]")
+{
+    AstArena arena;
+    BddManager manager;
+    std::mt19937 random{1234};
+
+    for (int expression = 0; expression < 300; expression += 1)
+    {
+        const auto source = RandomBoolExpression(&random, 4);
+        INFO(source);
+        const auto rows = TruthTableRows(source, &arena);
+        const auto function = manager.FromTree(*ParseForTest<std::uint64_t>(source, &arena));
+        for (std::uint64_t row = 0; row < (std::uint64_t{1} << BDD_TEST_VARIABLES); row += 1)
+        {
+            INFO(row);
+            REQUIRE(IsTrueFor(&manager, function, row) == (((rows >> row) & 1) != 0));
+        }
+    }
+}
+
+
+TEST_CASE("bdd-equivalence", "[bdd]")
+{
+    AstArena arena;
+    BddManager manager;
+    const auto build = [&](const std::string& source) { return manager.FromTree(*ParseForTest<std::uint64_t>(source, &arena)); };
+
+    CHECK(build("a & (b | c)") == build("a & b | c & a"));
+    CHECK(build("~(a | b)") == build("~a & ~b"));
+    CHECK(build("a ^ b") == build("a & ~b | ~a & b"));
+    CHECK(build("a << b") == build("a & ~b"));
+    CHECK(build("a | ~a").IsTrue());
+    CHECK(build("a & ~a").IsFalse());
+    CHECK(build("a & 2 | 3 & b") == build("b"));
+    CHECK(build("a | b") != build("a ^ b"));
+
+    SECTION("random pairs are equal when their truth tables are")
+    {
+        std::mt19937 random{42};
+        int equal_count = 0;
+        for (int pair = 0; pair < 500; pair += 1)
+        {
+            const auto lhs = RandomBoolExpression(&random, 3);
+            const auto rhs = RandomBoolExpression(&random, 3);
+            INFO(lhs << " vs " << rhs);
+            const auto equal = TruthTableRows(lhs, &arena) == TruthTableRows(rhs, &arena);
+            REQUIRE((build(lhs) == build(rhs)) == equal);
+            equal_count += equal ? 1 : 0;
+        }
+        CHECK(equal_count > 0);
+    }
+}
+
+
+TEST_CASE("bdd-satisfying", "[bdd]")
+{
+    AstArena arena;
+    BddManager manager;
+    std::mt19937 random{7};
+    BddAssignment assignment;
+
+    CHECK_FALSE(manager.FindSatisfying(manager.False(), &assignment));
+
+    for (int expression = 0; expression < 200; expression += 1)
+    {
+        const auto source = RandomBoolExpression(&random, 4);
+        INFO(source);
+        const auto function = manager.FromTree(*ParseForTest<std::uint64_t>(source, &arena));
+        if (function.IsFalse())
+        {
+            continue;
+        }
+
+        REQUIRE(manager.FindSatisfying(function, &assignment));
+        auto assigned = manager.True();
+        for (const auto& [name, value]: assignment)
+        {
+            const auto variable = manager.Variable(name);
+            assigned = manager.And(assigned, value ? variable : manager.Not(variable));
+        }
+        REQUIRE(manager.And(function, assigned) == assigned);
+    }
+}
+
+
+TEST_CASE("bdd-reorder", "[bdd]")
+{
+    // a0 = b0 and a1 = b1 ... is exponential when all a come before all b
+    // and linear when they alternate
+    constexpr int pairs = 10;
+    std::string source;
+    for (int pair = 0; pair < pairs; pair += 1)
+    {
+        source += fmt::format("{}~(a{} ^ b{})", pair == 0 ? "" : " & ", pair, pair);
+    }
+
+    AstArena arena;
+    BddManager manager;
+    for (const auto* prefix: {"a", "b"})
+    {
+        for (int pair = 0; pair < pairs; pair += 1)
+        {
+            static_cast<void>(manager.Variable(fmt::format("{}{}", prefix, pair)));
+        }
+    }
+    const auto function = manager.FromTree(*ParseForTest<std::uint64_t>(source, &arena));
+    const auto before = manager.NodeCount(function);
+    CHECK(before > (std::size_t{1} << pairs));
+
+    manager.Reorder();
+    const auto after = manager.NodeCount(function);
+    CHECK(after == 3 * pairs + 2);
+
+    // the handle still has the same function
+    CHECK(manager.FromTree(*ParseForTest<std::uint64_t>(source, &arena)) == function);
+    const auto order = manager.Order();
+    REQUIRE(order.size() == 2 * pairs);
+    for (std::size_t level = 0; level < order.size(); level += 2)
+    {
+        CHECK(order[level].substr(1) == order[level + 1].substr(1));
+    }
+
+    SECTION("auto reorder keeps the diagrams small while building")
+    {
+        BddManager reordering;
+        reordering.SetAutoReorder(true);
+        std::string large;
+        for (int pair = 0; pair < 40; pair += 1)
+        {
+            static_cast<void>(reordering.Variable(fmt::format("a{}", pair)));
+            large += fmt::format("{}(a{} ^ b{})", pair == 0 ? "" : " | ", pair, pair);
+        }
+        // without it the diagram would have more than 2^40 nodes, with it
+        // the nodes grow until the next reorder
+        const auto built = reordering.FromTree(*ParseForTest<std::uint64_t>(large, &arena));
+        CHECK(reordering.NodeCount(built) < 20000);
+        reordering.Reorder();
+        CHECK(reordering.NodeCount(built) == 3 * 40 + 2);
+    }
+}
+
+
+TEST_CASE("bdd-to-expression", "[bdd]")
+{
+    AstArena arena;
+    BddManager manager;
+    std::string expression;
+
+    CHECK(manager.ToExpression(manager.True(), 10, &expression));
+    CHECK(expression == "1");
+
+    const auto function = manager.FromTree(*ParseForTest<std::uint64_t>("a & b | a & c", &arena));
+    REQUIRE(manager.ToExpression(function, 100, &expression));
+    CHECK(expression == "a & (b | c)");
+    CHECK_FALSE(manager.ToExpression(function, 6, &expression));
+
+    std::mt19937 random{99};
+    for (int round = 0; round < 200; round += 1)
+    {
+        const auto source = RandomBoolExpression(&random, 4);
+        INFO(source);
+        const auto random_function = manager.FromTree(*ParseForTest<std::uint64_t>(source, &arena));
+        REQUIRE(manager.ToExpression(random_function, 10000, &expression));
+        INFO(expression);
+        REQUIRE(manager.FromTree(*ParseForTest<std::uint64_t>(expression, &arena)) == random_function);
+    }
+}
+
+
+TEST_CASE("bdd-calc", "[bdd]")
+{
+    struct LineOutput : public Output
+    {
+        std::vector<std::string> lines;
+
+        void
+        PrintInfo(std::string_view str) override
+        {
+            lines.emplace_back(str);
+        }
+
+        void
+        PrintError(std::string_view str) override
+        {
+            lines.emplace_back(fmt::format("ERR {}", str));
+        }
+    };
+    LineOutput output;
+
+    SECTION("equiv")
+    {
+        CHECK(RunCalcApp("calcapp", {"--equiv", "a & (b | c)", "a & b | a & c"}, &output) == 0);
+        CHECK(RunCalcApp("calcapp", {"--equiv", "a | b", "a ^ b"}, &output) == 1);
+        CHECK(RunCalcApp("calcapp", {"--equiv", "1", "0"}, &output) == 1);
+        CHECK(output.lines
+              == std::vector<std::string>{"equivalent", "not equivalent for a=1 b=1", "not equivalent"});
+    }
+
+    SECTION("minimize")
+    {
+        // parentheses are tokens so a & (b | c) is as long as a & b | a & c
+        CHECK(RunCalcApp("calcapp", {"--minimize", "(a | b) & (a | c)", "a & b | a & c", "a & b | a & ~b"}, &output)
+              == 0);
+        CHECK(output.lines == std::vector<std::string>{"a | b & c", "a & b | a & c", "a"});
+    }
+
+    SECTION("optimizer keeps the boolean meaning")
+    {
+        // constant shifts fold to a & ~b and not to the shifted value
+        for (const auto* source: {"a & (1 << 2)", "a | (2 >> 1)", "(3 << 1) ^ a", "~(1 >> 1) & b << a"})
+        {
+            INFO(source);
+            for (const auto* mode: {"--truth-table", "--minimize"})
+            {
+                LineOutput optimized;
+                LineOutput unoptimized;
+                CHECK(RunCalcApp("calcapp", {mode, source}, &optimized) == 0);
+                CHECK(RunCalcApp("calcapp", {mode, "--no-opt", source}, &unoptimized) == 0);
+                CHECK(optimized.lines == unoptimized.lines);
+            }
+        }
+        CHECK(RunCalcApp("calcapp", {"--equiv", "a & (1 << 2)", "a"}, &output) == 0);
+        CHECK(RunCalcApp("calcapp", {"--equiv", "--no-opt", "a & (1 << 2)", "a"}, &output) == 0);
+        CHECK(RunCalcApp("calcapp", {"--truth-table", "a & (1 << 2)"}, &output) == 0);
+        CHECK(output.lines
+              == std::vector<std::string>{"equivalent", "equivalent", "a | result", "0 | 0", "1 | 1"});
+    }
+
+    SECTION("errors")
+    {
+        CHECK(RunCalcApp("calcapp", {"--equiv", "a"}, &output) == -1);
+        CHECK(RunCalcApp("calcapp", {"--minimize", "--truth-table", "a"}, &output) == -1);
+        CHECK(RunCalcApp("calcapp", {"--equiv", "a", "b $"}, &output) == -2);
+        CHECK(output.lines
+              == std::vector<std::string>{
+                      "ERR --equiv needs two expressions",
+                      "ERR --minimize can't be used with --truth-table",
+                      "ERR Error while parsing:",
+                      "ERR  - Invalid character: $"});
+    }
+}
@@ -0,0 +1,40 @@
+#include "catch.hpp"
+
+#include <cstdint>
+#include <string>
+
+#include "calc/binary.h"
+
+
+std::string
+FormatBinary64(std::uint64_t n)
+{
+    BinaryBuffer buffer;
+    return std::string{FormatBinary(n, &buffer)};
+}
+
+
+TEST_CASE("binary-format", "[binary]")
+{
+    CHECK(ToBinaryString(0) == "0");
+    CHECK(ToBinaryString(1) == "1");
+    CHECK(ToBinaryString(0b1010) == "1010");
+    CHECK(ToBinaryString(0b10000) == "1 0000");
+    CHECK(ToBinaryString(0x42) == "100 0010");
+    CHECK(ToBinaryString(2147483647) == "111 1111 1111 1111 1111 1111 1111 1111");
+
+    SECTION("negative")
+    {
+        CHECK(ToBinaryString(-1) == "1111 1111 1111 1111 1111 1111 1111 1111");
+        CHECK(ToBinaryString(-8) == "1111 1111 1111 1111 1111 1111 1111 1000");
+    }
+
+    SECTION("64 bit")
+    {
+        CHECK(FormatBinary64(0) == "0");
+        CHECK(FormatBinary64(std::uint64_t{1} << 32) == "1 0000 0000 0000 0000 0000 0000 0000 0000");
+        CHECK(FormatBinary64(UINT64_MAX)
+              == "1111 1111 1111 1111 1111 1111 1111 1111 "
+                 "1111 1111 1111 1111 1111 1111 1111 1111");
+    }
+}
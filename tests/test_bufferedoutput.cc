@@ -0,0 +1,56 @@
+#include "catch.hpp"
+
+#include <cstdio>
+#include <string>
+
+#include "calc/bufferedoutput.h"
+
+
+// the descriptor of a file, the output writes to it directly
+int
+FileDescriptor(std::FILE* file)
+{
+#if defined(_WIN32)
+    return _fileno(file);
+#else
+    return fileno(file);
+#endif
+}
+
+
+std::string
+ReadAll(std::FILE* file)
+{
+    std::rewind(file);
+    std::string result;
+    char buffer[256];
+    while (true)
+    {
+        const auto size = std::fread(buffer, 1, sizeof(buffer), file);
+        if (size == 0)
+        {
+            return result;
+        }
+        result.append(buffer, size);
+    }
+}
+
+
+TEST_CASE("bufferedoutput-order", "[output]")
+{
+    std::FILE* file = std::tmpfile();
+    REQUIRE(file != nullptr);
+    const int fd = FileDescriptor(file);
+
+    {
+        // small flush size so both the full and the explicit flush are used
+        auto output = BufferedOutput{fd, fd, 8};
+        output.PrintInfo("dec: 1");
+        output.PrintInfo("hex: 0x1");
+        output.PrintError("bad");
+        output.PrintInfo("bin: 1");
+    }
+
+    CHECK(ReadAll(file) == "dec: 1\nhex: 0x1\nbad\nbin: 1\n");
+    std::fclose(file);
+}
@@ -1,5 +1,11 @@
 #include "catch.hpp"
 
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
 #include <fmt/format.h>
 
 #include "calc/calc.h"
@@ -52,15 +58,15 @@ struct VectorOutput : public Output
     std::vector<Line> lines;
 
     void
-    PrintInfo(const std::string& str) override
+    PrintInfo(std::string_view str) override
     {
-        lines.emplace_back(Inf(str));
+        lines.emplace_back(Inf(std::string{str}));
     }
 
     void
-    PrintError(const std::string& str) override
+    PrintError(std::string_view str) override
     {
-        lines.emplace_back(Err(str));
+        lines.emplace_back(Err(std::string{str}));
     }
 };
 
@@ -93,12 +99,31 @@ TEST_CASE("calc-help", "[calc]")
     {
         const auto output = RunCalcApp("calcapp", {}, &lines);
         CHECK(output == 0);
+        REQUIRE(lines.lines.size() > 6);
+        lines.lines.resize(6);
         CHECK(VectorEquals(
                 lines,
                 {Inf("calcapp"),
                  Inf(" - print truth table of expressions"),
                  Inf(" - convert between binary and hexadecimal values"),
-                 Inf(" - evaluate boolean expressions")}));
+                 Inf(" - evaluate boolean expressions"),
+                 Inf(""),
+                 Inf("options:")}));
+    }
+
+    SECTION("help lists the options")
+    {
+        RunCalcApp("calcapp", {}, &lines);
+        for (const auto* option:
+             {"--width", "--no-opt", "--truth-table", "--equiv", "--minimize", "--stream", "--jobs", "--cache",
+              "--max-errors", "--binary", "--status", "--stats", "--serve", "--client"})
+        {
+            INFO(option);
+            const auto listed = std::any_of(lines.lines.begin(), lines.lines.end(), [option](const Line& line) {
+                return line.text.rfind(std::string{"  "} + option + " ", 0) == 0;
+            });
+            CHECK(listed);
+        }
     }
 }
 
@@ -133,6 +158,17 @@ TEST_CASE("calc-convert", "[calc]")
                 lines,
                 {Inf("dec: 10"), Inf("hex: 0xa"), Inf("bin: 1010")}));
     }
+
+    SECTION("largest")
+    {
+        const auto output = RunCalcApp("calcapp", {"2147483647"}, &lines);
+        CHECK(output == 0);
+        CHECK(VectorEquals(
+                lines,
+                {Inf("dec: 2147483647"),
+                 Inf("hex: 0x7fffffff"),
+                 Inf("bin: 111 1111 1111 1111 1111 1111 1111 1111")}));
+    }
 }
 
 TEST_CASE("calc-eval", "[calc]")
@@ -158,6 +194,200 @@ TEST_CASE("calc-eval", "[calc]")
     }
 }
 
+TEST_CASE("calc-options", "[calc]")
+{
+    VectorOutput lines;
+
+    SECTION("no-opt gives the same result")
+    {
+        const auto output = RunCalcApp("calcapp", {"--no-opt", "0b0101 | 0b1100 & 0xff"}, &lines);
+        CHECK(output == 0);
+        CHECK(VectorEquals(
+                lines,
+                {Inf("dec: 13"), Inf("hex: 0xd"), Inf("bin: 1101")}));
+    }
+
+    SECTION("optimizer removes unused variables")
+    {
+        const auto output = RunCalcApp("calcapp", {"x & 0 | 3"}, &lines);
+        CHECK(output == 0);
+        CHECK(VectorEquals(
+                lines,
+                {Inf("dec: 3"), Inf("hex: 0x3"), Inf("bin: 11")}));
+    }
+
+    SECTION("no-opt keeps unused variables")
+    {
+        const auto output = RunCalcApp("calcapp", {"--no-opt", "x & 0 | 3"}, &lines);
+        CHECK(output == -5);
+        CHECK(VectorEquals(lines, {Err("Missing value for x")}));
+    }
+}
+
+TEST_CASE("calc-deep-nesting", "[calc]")
+{
+    // deep enough to overflow the call stack of anything that recurses into
+    // the operands of a node
+    constexpr int DEPTH = 100000;
+    VectorOutput lines;
+
+    SECTION("not")
+    {
+        const auto source = std::string(DEPTH, '~') + "1";
+        CHECK(RunCalcApp("calcapp", {source}, &lines) == 0);
+        CHECK(RunCalcApp("calcapp", {"--no-opt", source}, &lines) == 0);
+        CHECK(VectorEquals(
+                lines,
+                {Inf("dec: 1"), Inf("hex: 0x1"), Inf("bin: 1"),
+                 Inf("dec: 1"), Inf("hex: 0x1"), Inf("bin: 1")}));
+    }
+
+    SECTION("operators")
+    {
+        static const char* const operators[] = {" & 7)", " | 8)", " ^ 3)"};
+        auto source = std::string(DEPTH, '(') + "1";
+        std::uint32_t expected = 1;
+        for (int level = 0; level < DEPTH; level += 1)
+        {
+            source += operators[level % 3];
+            expected = level % 3 == 0 ? expected & 7 : level % 3 == 1 ? expected | 8 : expected ^ 3;
+        }
+
+        CHECK(RunCalcApp("calcapp", {source}, &lines) == 0);
+        CHECK(RunCalcApp("calcapp", {"--no-opt", source}, &lines) == 0);
+        REQUIRE(lines.lines.size() == 6);
+        CHECK(lines.lines[0] == Inf(fmt::format("dec: {}", expected)));
+        CHECK(lines.lines[3] == Inf(fmt::format("dec: {}", expected)));
+    }
+
+    SECTION("truth table and equiv")
+    {
+        const auto source = std::string(DEPTH, '(') + "~a" + std::string(DEPTH, ')');
+        CHECK(RunCalcApp("calcapp", {"--truth-table", source}, &lines) == 0);
+        CHECK(RunCalcApp("calcapp", {"--truth-table", "--no-opt", source}, &lines) == 0);
+        CHECK(RunCalcApp("calcapp", {"--equiv", std::string(DEPTH, '~') + "a", "a"}, &lines) == 0);
+        CHECK(VectorEquals(
+                lines,
+                {Inf("a | result"), Inf("0 | 1"), Inf("1 | 0"),
+                 Inf("a | result"), Inf("0 | 1"), Inf("1 | 0"),
+                 Inf("equivalent")}));
+    }
+}
+
+TEST_CASE("calc-truth-table", "[calc]")
+{
+    VectorOutput lines;
+
+    SECTION("two variables")
+    {
+        const auto output = RunCalcApp("calcapp", {"--truth-table", "a & flag"}, &lines);
+        CHECK(output == 0);
+        CHECK(VectorEquals(
+                lines,
+                {Inf("a flag | result"),
+                 Inf("0 0    | 0"),
+                 Inf("0 1    | 0"),
+                 Inf("1 0    | 0"),
+                 Inf("1 1    | 1")}));
+    }
+
+    SECTION("constant")
+    {
+        const auto output = RunCalcApp("calcapp", {"--truth-table", "1 | 2"}, &lines);
+        CHECK(output == 0);
+        CHECK(VectorEquals(lines, {Inf("| result"), Inf("| 1")}));
+    }
+
+    SECTION("not with stream")
+    {
+        const auto output = RunCalcApp("calcapp", {"--truth-table", "--stream"}, &lines);
+        CHECK(output == -1);
+        CHECK(VectorEquals(lines, {Err("--truth-table can't be used with --stream")}));
+    }
+}
+
+
+TEST_CASE("calc-width", "[calc]")
+{
+    VectorOutput lines;
+
+    SECTION("32 bit is unsigned")
+    {
+        const auto output = RunCalcApp("calcapp", {"0xffffffff"}, &lines);
+        CHECK(output == 0);
+        CHECK(VectorEquals(
+                lines,
+                {Inf("dec: 4294967295"),
+                 Inf("hex: 0xffffffff"),
+                 Inf("bin: 1111 1111 1111 1111 1111 1111 1111 1111")}));
+    }
+
+    SECTION("8 bit")
+    {
+        const auto output = RunCalcApp("calcapp", {"--width", "8", "0xf0 | 0x0f"}, &lines);
+        CHECK(output == 0);
+        CHECK(VectorEquals(
+                lines,
+                {Inf("dec: 255"), Inf("hex: 0xff"), Inf("bin: 1111 1111")}));
+    }
+
+    SECTION("8 bit overflow")
+    {
+        const auto output = RunCalcApp("calcapp", {"--width", "8", "256"}, &lines);
+        CHECK(output == -2);
+        CHECK(VectorEquals(
+                lines,
+                {Err("Error while parsing:"), Err(" - Number is too large: 256")}));
+    }
+
+    SECTION("64 bit")
+    {
+        const auto output = RunCalcApp(
+                "calcapp", {"--width", "64", "0xffff000000000000 | 0x8000000000000000"}, &lines);
+        CHECK(output == 0);
+        CHECK(VectorEquals(
+                lines,
+                {Inf("dec: 18446462598732840960"),
+                 Inf("hex: 0xffff000000000000"),
+                 Inf("bin: 1111 1111 1111 1111 0000 0000 0000 0000 "
+                     "0000 0000 0000 0000 0000 0000 0000 0000")}));
+    }
+
+    SECTION("128 bit")
+    {
+        const auto output = RunCalcApp(
+                "calcapp",
+                {"--width", "128", "0x10000000000000000 | 0xff"},
+                &lines);
+        CHECK(output == 0);
+        CHECK(VectorEquals(
+                lines,
+                {Inf("dec: 18446744073709551871"),
+                 Inf("hex: 0x100000000000000ff"),
+                 Inf("bin: 1 0000 0000 0000 0000 0000 0000 0000 0000 "
+                     "0000 0000 0000 0000 0000 0000 1111 1111")}));
+    }
+
+    SECTION("512 bit")
+    {
+        const auto output = RunCalcApp(
+                "calcapp",
+                {"--width", "512", "1 | 0x80000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000"},
+                &lines);
+        CHECK(output == 0);
+        REQUIRE(lines.lines.size() == 3);
+        CHECK(lines.lines[1] == Inf("hex: 0x80000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000001"));
+    }
+
+    SECTION("invalid width")
+    {
+        const auto output = RunCalcApp("calcapp", {"--width", "12", "1"}, &lines);
+        CHECK(output == -1);
+        CHECK(VectorEquals(lines, {Err("Invalid width: 12")}));
+    }
+}
+
+
 TEST_CASE("calc-error", "[calc]")
 {
     VectorOutput lines;
@@ -169,13 +399,30 @@ TEST_CASE("calc-error", "[calc]")
         CHECK(VectorEquals(lines, {Err("Invalid commandline argument -dog")}));
     }
 
+    SECTION("invalid character")
+    {
+        const auto output = RunCalcApp("calcapp", {"4 $ 2"}, &lines);
+        CHECK(output == -2);
+        CHECK(VectorEquals(
+                lines,
+                {Err("Error while parsing:"), Err(" - Invalid character: $")}));
+    }
+
     SECTION("dog")
     {
         const auto output = RunCalcApp("calcapp", {"dog"}, &lines);
+        CHECK(output == -5);
+        CHECK(VectorEquals(lines, {Err("Missing value for dog")}));
+    }
+
+    SECTION("too large")
+    {
+        const auto output = RunCalcApp("calcapp", {"0x100000000"}, &lines);
         CHECK(output == -2);
         CHECK(VectorEquals(
                 lines,
-                {Err("Error while parsing:"), Err(" - Invalid character: d")}));
+                {Err("Error while parsing:"),
+                 Err(" - Number is too large: 0x100000000")}));
     }
 
     SECTION("empty expression")
@@ -185,3 +432,185 @@ TEST_CASE("calc-error", "[calc]")
         CHECK(VectorEquals(lines, {Err("Empty statement")}));
     }
 }
+
+
+TEST_CASE("calc-stream", "[calc]")
+{
+    VectorOutput lines;
+    const std::string path = "calc-stream-test.txt";
+
+    SECTION("keeps going after an error")
+    {
+        {
+            std::ofstream file{path};
+            file << "3 & 6\n";
+            file << "\n";
+            file << "4 $ 2\r\n";
+            file << "0b1000 | 1";
+        }
+        const auto output = RunCalcApp("calcapp", {"--stream", path}, &lines);
+        std::remove(path.c_str());
+        CHECK(output == -2);
+        CHECK(VectorEquals(
+                lines,
+                {Inf("dec: 2"),
+                 Inf("hex: 0x2"),
+                 Inf("bin: 10"),
+                 Err("Error on line 3: 4 $ 2"),
+                 Err(" - Invalid character: $"),
+                 Inf("dec: 9"),
+                 Inf("hex: 0x9"),
+                 Inf("bin: 1001")}));
+    }
+
+    SECTION("jobs keeps the order")
+    {
+        {
+            std::ofstream file{path};
+            for (int index = 0; index < 5000; index += 1)
+            {
+                file << (index == 1234 ? "1 &" : fmt::format("{} | x & 0", index)) << "\n";
+            }
+        }
+        VectorOutput serial;
+        const auto serial_output = RunCalcApp("calcapp", {"--stream", path}, &serial);
+        const auto output = RunCalcApp("calcapp", {"--stream", path, "--jobs", "4"}, &lines);
+        std::remove(path.c_str());
+        CHECK(serial_output == -4);
+        CHECK(output == -4);
+        REQUIRE(serial.lines.size() == 3 * 4999 + 2);
+        CHECK(serial.lines[3 * 1234] == Err("Error on line 1235: 1 &"));
+        CHECK(VectorEquals(lines, serial.lines));
+    }
+
+    SECTION("max errors")
+    {
+        {
+            std::ofstream file{path};
+            for (int index = 0; index < 5000; index += 1)
+            {
+                file << (index % 1000 == 7 ? "1 &" : "1") << "\n";
+            }
+        }
+        VectorOutput serial;
+        const auto serial_output = RunCalcApp("calcapp", {"--stream", path, "--max-errors", "2"}, &serial);
+        const auto output = RunCalcApp("calcapp", {"--stream", path, "--max-errors", "2", "--jobs", "4"}, &lines);
+        std::remove(path.c_str());
+        CHECK(serial_output == -4);
+        CHECK(output == -4);
+        REQUIRE(serial.lines.size() == 3 * 4995 + 2 * 2 + 1);
+        CHECK(serial.lines[3 * 7] == Err("Error on line 8: 1 &"));
+        CHECK(serial.lines[3 * 1006 + 2] == Err("Error on line 1008: 1 &"));
+        CHECK(serial.lines.back() == Err("3 more lines with errors"));
+        CHECK(VectorEquals(lines, serial.lines));
+    }
+
+    SECTION("cache gives the same output")
+    {
+        {
+            std::ofstream file{path};
+            for (int index = 0; index < 3000; index += 1)
+            {
+                file << (index % 7 == 3 ? "x" : fmt::format("{} |  x & 0", index % 5)) << "\n";
+            }
+        }
+        VectorOutput uncached;
+        const auto uncached_output = RunCalcApp("calcapp", {"--stream", path}, &uncached);
+        const auto output = RunCalcApp("calcapp", {"--stream", path, "--cache", "4", "--jobs", "2"}, &lines);
+        std::remove(path.c_str());
+        CHECK(uncached_output == -5);
+        CHECK(output == -5);
+        CHECK(VectorEquals(lines, uncached.lines));
+    }
+
+    SECTION("invalid cache")
+    {
+        const auto output = RunCalcApp("calcapp", {"--stream", path, "--cache", "x"}, &lines);
+        CHECK(output == -1);
+        CHECK(VectorEquals(lines, {Err("Invalid cache size: x")}));
+    }
+
+    SECTION("invalid jobs")
+    {
+        const auto output = RunCalcApp("calcapp", {"--stream", path, "--jobs", "0"}, &lines);
+        CHECK(output == -1);
+        CHECK(VectorEquals(lines, {Err("Invalid number of jobs: 0")}));
+    }
+
+    SECTION("option after stream")
+    {
+        // the option isn't taken as the path of the file
+        CHECK(RunCalcApp("calcapp", {"--stream", "--jobs", "0"}, &lines) == -1);
+        CHECK(RunCalcApp("calcapp", {"--stream", "--cache", "x"}, &lines) == -1);
+        CHECK(VectorEquals(lines, {Err("Invalid number of jobs: 0"), Err("Invalid cache size: x")}));
+    }
+
+    SECTION("missing file")
+    {
+        const auto output = RunCalcApp("calcapp", {"--stream", path}, &lines);
+        CHECK(output == -6);
+        CHECK(VectorEquals(lines, {Err(fmt::format("Unable to open {}", path))}));
+    }
+}
+
+
+TEST_CASE("calc-stats", "[calc]")
+{
+    VectorOutput lines;
+
+    if (!STATS_ENABLED)
+    {
+        const auto output = RunCalcApp("calcapp", {"--stats", "1"}, &lines);
+        CHECK(output == -1);
+        return;
+    }
+
+    SECTION("callback")
+    {
+        auto stats = Stats{};
+        int calls = 0;
+        const auto output = RunCalcApp("calcapp", {"1 | 2", "0xff & x"}, &lines, [&](const Stats& s) {
+            stats = s;
+            calls += 1;
+        });
+        CHECK(output == -5);
+        CHECK(calls == 1);
+        CHECK(stats.expressions == 2);
+        CHECK(stats.timed_expressions == 1);
+        CHECK(stats.tokens == 6);
+        CHECK(stats.nodes == 6);
+        CHECK(stats.bytes_in == 13);
+        REQUIRE(lines.lines.size() == 4);
+        CHECK(stats.bytes_out == lines.lines[0].text.size() + lines.lines[1].text.size() + lines.lines[2].text.size());
+    }
+
+    SECTION("jobs add up")
+    {
+        const std::string path = "calc-stats-test.txt";
+        {
+            std::ofstream file{path};
+            for (int line = 0; line < 3000; line += 1)
+            {
+                file << line << " | 1\n";
+            }
+        }
+        auto stats = Stats{};
+        const auto output = RunCalcApp(
+                "calcapp", {"--stream", path, "--jobs", "2"}, &lines, [&](const Stats& s) { stats = s; });
+        std::remove(path.c_str());
+        CHECK(output == 0);
+        CHECK(stats.expressions == 3000);
+        CHECK(stats.tokens == 9000);
+        CHECK(stats.timed_expressions > 0);
+        CHECK(stats.timed_expressions < 3000);
+    }
+
+    SECTION("summary is printed last")
+    {
+        const auto output = RunCalcApp("calcapp", {"--stats", "3"}, &lines);
+        CHECK(output == 0);
+        REQUIRE(lines.lines.size() == 3 + 3 + PHASE_COUNT);
+        CHECK(lines.lines[3].text == "stats: 1 expressions, 1 timed, 0 cache hits");
+        CHECK(lines.lines[4].text.rfind("stats: 1 tokens, 1 nodes, ", 0) == 0);
+    }
+}
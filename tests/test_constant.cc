@@ -0,0 +1,62 @@
+#include "catch.hpp"
+
+#include <cstdint>
+#include <string>
+
+#include "calc/constant.h"
+#include "calc/errorhandler.h"
+#include "calc/lexer.h"
+#include "calc/parser.h"
+
+
+// evaluated by the compiler, a malformed expression wouldn't compile
+static_assert("0xff & 0b100"_bb == 4);
+static_assert("1 << 4 | 1"_bb == 17);
+static_assert("~0 >> 60"_bb == 15);
+static_assert("(1 | 2) & ~(2 ^ 8)"_bb == 1);
+static_assert(EvaluateConstant<std::uint8_t>("0xff << 4").value == 0xf0);
+
+
+std::string
+ConstantError(const std::string& source)
+{
+    const auto result = EvaluateConstant<std::uint32_t>(source);
+    if (!result.failed)
+    {
+        return "";
+    }
+    return result.error.ToString();
+}
+
+
+std::string
+RuntimeError(const std::string& source)
+{
+    ErrorHandler errors;
+    AstArena arena;
+    const auto tokens = RunLexer<std::uint32_t>(source, &errors);
+    if (!errors.HasErr())
+    {
+        if (tokens.empty())
+        {
+            return "Empty statement";
+        }
+        RunParser(tokens, &errors, &arena);
+    }
+    return errors.HasErr() ? errors.errors[0].ToString() : "";
+}
+
+
+TEST_CASE("constant-errors", "[constant]")
+{
+    CHECK(ConstantError("x & 1") == "Missing value for x");
+    CHECK(ConstantError(std::string(MAX_CONSTANT_TOKENS + 1, '~')) == "Too many tokens, stopped at ~");
+
+    // the same code finds the same errors at compile time as at runtime
+    for (const auto* source: {"", "1 &", "1 2", "(1 | 2", "1 | 2)", "()", "1 ~ 2", "1 < 2", "0x", "0b12", "0x100000000", "$"})
+    {
+        INFO(source);
+        CHECK_FALSE(ConstantError(source).empty());
+        CHECK(ConstantError(source) == RuntimeError(source));
+    }
+}
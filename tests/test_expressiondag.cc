@@ -0,0 +1,135 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "calc/errorhandler.h"
+#include "calc/expressiondag.h"
+#include "calc/programcache.h"
+#include "calc/vm.h"
+
+
+using Value = std::uint32_t;
+
+
+TEST_CASE("expressiondag-sharing", "[expressiondag]")
+{
+    auto dag = ExpressionDag<Value>{};
+    ErrorHandler errors;
+
+    CHECK(dag.Add("0xff00 & flags & a", &errors) == 0);
+    // 0xff00, flags, &, a, &
+    CHECK(dag.NodeCount() == 5);
+
+    SECTION("a shared prefix is stored once")
+    {
+        CHECK(dag.Add("0xff00 & flags & b", &errors) == 1);
+        CHECK(dag.NodeCount() == 7);
+    }
+
+    SECTION("the order of and, or and xor doesn't matter")
+    {
+        dag.Add("flags & 0xff00", &errors);
+        dag.Add("a & (0xff00 & flags)", &errors);
+        CHECK(dag.NodeCount() == 5);
+    }
+
+    SECTION("the order of shifts does")
+    {
+        dag.Add("a << flags", &errors);
+        dag.Add("flags << a", &errors);
+        CHECK(dag.NodeCount() == 7);
+    }
+
+    SECTION("constants are folded")
+    {
+        dag.Add("a & (0xf0 | 0xff << 8)", &errors);
+        dag.Add("a & 0xfff0", &errors);
+        CHECK(dag.NodeCount() == 7);
+    }
+
+    SECTION("errors add nothing")
+    {
+        CHECK(dag.Add("0xff00 & (c", &errors) == -1);
+        CHECK(errors.HasErr());
+        CHECK(dag.ExpressionCount() == 1);
+        CHECK(dag.NodeCount() == 5);
+        CHECK(dag.Variables() == std::vector<std::string>{"flags", "a"});
+    }
+}
+
+
+TEST_CASE("expressiondag-evaluate", "[expressiondag]")
+{
+    const std::vector<std::string> terms = {
+            "0xff00 & flags", "~mask", "x << 3", "(y ^ x) >> 1", "0b1010", "flags | y"};
+    const std::vector<std::string> operators = {"&", "|", "^"};
+
+    // random expressions made of a few shared terms
+    std::mt19937 random{42};
+    const auto pick = [&random](const std::vector<std::string>& from) {
+        return from[std::uniform_int_distribution<std::size_t>{0, from.size() - 1}(random)];
+    };
+    std::vector<std::string> sources;
+    for (int index = 0; index < 500; index += 1)
+    {
+        auto source = pick(terms);
+        for (int term = 0; term < index % 4; term += 1)
+        {
+            source = fmt::format("({}) {} {}", source, pick(operators), pick(terms));
+        }
+        sources.emplace_back(source);
+    }
+
+    auto dag = ExpressionDag<Value>{};
+    auto cache = ProgramCache<Value>{0};
+    ErrorHandler errors;
+    std::vector<std::shared_ptr<const Program<Value>>> programs;
+    for (const auto& source: sources)
+    {
+        REQUIRE(dag.Add(source, &errors) >= 0);
+        programs.emplace_back(cache.Compile(source, true, &errors));
+        REQUIRE(programs.back() != nullptr);
+    }
+
+    // everything is shared with the first time
+    const auto node_count = dag.NodeCount();
+    for (const auto& source: sources)
+    {
+        dag.Add(source, &errors);
+    }
+    CHECK(dag.NodeCount() == node_count);
+
+    std::vector<Value> variables(dag.Variables().size());
+    std::vector<Value> values;
+    std::vector<Value> results;
+    REQUIRE(dag.ExpressionCount() == 2 * sources.size());
+    for (int input = 0; input < 20; input += 1)
+    {
+        for (auto& variable: variables)
+        {
+            variable = static_cast<Value>(random());
+        }
+        dag.Evaluate(variables, &values, &results);
+        REQUIRE(results.size() == 2 * sources.size());
+
+        for (std::size_t expression = 0; expression < sources.size(); expression += 1)
+        {
+            const auto& program = *programs[expression];
+            std::vector<Value> program_variables;
+            for (const auto& name: program.variables)
+            {
+                const auto found = std::find(dag.Variables().begin(), dag.Variables().end(), name);
+                program_variables.emplace_back(variables[static_cast<std::size_t>(found - dag.Variables().begin())]);
+            }
+            INFO(sources[expression]);
+            REQUIRE(results[expression] == RunProgram(program, program_variables));
+            REQUIRE(results[sources.size() + expression] == results[expression]);
+        }
+    }
+}
@@ -0,0 +1,104 @@
+#include "catch.hpp"
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "calc/arena.h"
+#include "calc/compiler.h"
+#include "calc/jit.h"
+#include "calc/optimizer.h"
+
+#include "parsefortest.h"
+
+
+TEST_CASE("jit-matches-calculate", "[jit]")
+{
+    // the constants cover every immediate encoding and the shift amounts
+    // that are larger than the register
+    auto engine = std::mt19937_64{4321};
+    const auto pick = [&engine](std::size_t count) {
+        return std::uniform_int_distribution<std::size_t>{0, count - 1}(engine);
+    };
+    const std::vector<std::string> atoms{
+            "a", "b", "c", "~a", "0", "3", "63", "64", "0x7fffffff", "0xffffffff",
+            "0x123456789", "0xffffffff80000000", "0xffffffffffffffff"};
+    const std::vector<std::string> operators{" & ", " | ", " ^ ", " << ", " >> "};
+    const auto optimize = GENERATE(false, true);
+
+    AstArena arena;
+    for (int test = 0; test < 300; test += 1)
+    {
+        std::string source = atoms[pick(atoms.size())];
+        const auto length = pick(10);
+        for (std::size_t i = 0; i < length; i += 1)
+        {
+            const auto rhs = pick(3) == 0
+                                     ? "(" + atoms[pick(atoms.size())] + operators[pick(operators.size())] + source + ")"
+                                     : atoms[pick(atoms.size())];
+            source += operators[pick(operators.size())] + rhs;
+        }
+
+        arena.Reset();
+        auto* root = ParseForTest<std::uint64_t>(source, &arena);
+        if (optimize)
+        {
+            root = RunOptimizer(root, &arena);
+        }
+        const auto program = CompileProgram(*root);
+        const auto jit = JitProgram{program};
+        CHECK(jit.IsNative() == JitProgram::IsSupported());
+
+        INFO(source);
+        INFO(program.ToString());
+        // the tree numbers the variables in the order they first appear
+        // and the program in the order they are used
+        std::string parsed;
+        for (const char c: source)
+        {
+            if (c >= 'a' && c <= 'c' && parsed.find(c) == std::string::npos)
+            {
+                parsed.push_back(c);
+            }
+        }
+
+        for (int i = 0; i < 8; i += 1)
+        {
+            // small values so the variables are useful shift amounts too
+            const auto values = std::vector<std::uint64_t>{
+                    i % 2 == 0 ? engine() : engine() % 80, engine() % 70, engine()};
+            const auto value_of = [&values](char name) {
+                return values[static_cast<std::size_t>(name - 'a')];
+            };
+            std::vector<std::uint64_t> tree_values;
+            for (const char name: parsed)
+            {
+                tree_values.emplace_back(value_of(name));
+            }
+            std::vector<std::uint64_t> program_values;
+            for (const auto& name: program.variables)
+            {
+                program_values.emplace_back(value_of(name[0]));
+            }
+            CHECK(jit.Run(program_values.data()) == root->Calculate(tree_values));
+        }
+    }
+}
+
+
+TEST_CASE("jit-falls-back-for-deep-programs", "[jit]")
+{
+    // every or waits for its right hand side so the stack is as deep as the
+    // chain is long
+    AstArena arena;
+    Node<std::uint64_t>* tree = arena.Make<NumberNode<std::uint64_t>>(1u);
+    for (std::uint64_t i = 0; i < 5000; i += 1)
+    {
+        tree = arena.Make<OrNode<std::uint64_t>>(
+                arena.MakeNodes({arena.Make<NumberNode<std::uint64_t>>(i), tree}));
+    }
+    const auto jit = JitProgram{CompileProgram(*tree)};
+    CHECK_FALSE(jit.IsNative());
+    CHECK(jit.Run(nullptr) == tree->Calculate({}));
+}
@@ -0,0 +1,59 @@
+#include "catch.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "calc/linereader.h"
+
+
+std::vector<std::string>
+ReadLines(const std::string& path, bool allow_map, bool* mapped)
+{
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    REQUIRE(file != nullptr);
+    std::vector<std::string> lines;
+    {
+        auto reader = LineReader{file, allow_map};
+        *mapped = reader.IsMapped();
+        std::string_view line;
+        while (reader.Next(&line))
+        {
+            lines.emplace_back(line);
+            reader.Release();
+        }
+    }
+    std::fclose(file);
+    return lines;
+}
+
+
+TEST_CASE("linereader", "[linereader]")
+{
+    const std::string path = "linereader-test.txt";
+    std::vector<std::string> expected;
+    {
+        std::ofstream file{path, std::ios::binary};
+        for (int index = 0; index < 100000; index += 1)
+        {
+            expected.emplace_back(index % 10 == 0 ? "" : std::to_string(index) + " & 0xff");
+            file << expected.back() << (index % 3 == 0 ? "\r\n" : "\n");
+        }
+        expected.emplace_back("no newline");
+        file << expected.back();
+    }
+
+    bool mapped = false;
+    const auto read = ReadLines(path, false, &mapped);
+    CHECK_FALSE(mapped);
+    CHECK(read == expected);
+
+    const auto map = ReadLines(path, true, &mapped);
+#if defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__)
+    CHECK(mapped);
+#endif
+    CHECK(map == expected);
+
+    std::remove(path.c_str());
+}
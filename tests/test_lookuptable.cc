@@ -0,0 +1,132 @@
+#include "catch.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "calc/arena.h"
+#include "calc/compiler.h"
+#include "calc/errorhandler.h"
+#include "calc/lookuptable.h"
+#include "calc/optimizer.h"
+#include "calc/programcache.h"
+#include "calc/vm.h"
+
+#include "parsefortest.h"
+
+
+template <typename V>
+void
+CheckTable(const std::string& source)
+{
+    AstArena arena;
+    const auto* root = RunOptimizer(ParseForTest<V>(source, &arena), &arena);
+    const auto direct = CompileProgram(*root);
+    auto tabulated = direct;
+    TabulateProgram(&tabulated);
+    REQUIRE(tabulated.table.size() == std::size_t{1} << BIT_WIDTH<V>);
+
+    for (std::size_t value = 0; value < tabulated.table.size(); value += 1)
+    {
+        const auto variable = static_cast<V>(value);
+        INFO(source << " for " << value);
+        REQUIRE(RunProgram(tabulated, &variable) == RunProgram(direct, &variable));
+    }
+}
+
+
+TEST_CASE("lookuptable-matches-vm", "[lookuptable]")
+{
+    const auto source = GENERATE(
+            std::string{"x"},
+            std::string{"~x & 0x5a | 0x81"},
+            std::string{"x << 3 ^ x >> 2"},
+            std::string{"1 << x"},
+            std::string{"(x ^ 0x3c) & ~(x << 1)"},
+            // the optimizer removes y so x keeps index 1
+            std::string{"y & 0 | x & 0x77"});
+
+    CheckTable<std::uint8_t>(source);
+    CheckTable<std::uint16_t>(source);
+}
+
+
+TEST_CASE("lookuptable-cost-model", "[lookuptable]")
+{
+    AstArena arena;
+    const auto one = CompileProgram(*RunOptimizer(ParseForTest<std::uint8_t>("x & 0xf0 | x >> 4", &arena), &arena));
+    const auto two = CompileProgram(*RunOptimizer(ParseForTest<std::uint8_t>("x & 0xf0 | y", &arena), &arena));
+    const auto wide = CompileProgram(*RunOptimizer(ParseForTest<std::uint32_t>("x & 0xf0 | x >> 4", &arena), &arena));
+    const auto one16 = CompileProgram(*RunOptimizer(ParseForTest<std::uint16_t>("x & 0xf0 | x >> 4", &arena), &arena));
+
+    CHECK_FALSE(ShouldTabulate(one, 10));
+    CHECK(ShouldTabulate(one, 1000));
+    CHECK_FALSE(ShouldTabulate(two, 100000000));
+    CHECK_FALSE(ShouldTabulate(wide, 100000000));
+
+    // a table with more inputs needs more calls to pay for itself
+    CHECK_FALSE(ShouldTabulate(one16, 1000));
+    CHECK(ShouldTabulate(one16, 1000000));
+}
+
+
+TEST_CASE("lookuptable-compile-clears", "[lookuptable]")
+{
+    AstArena arena;
+    const auto* root = RunOptimizer(ParseForTest<std::uint8_t>("x ^ 0xff", &arena), &arena);
+    auto program = CompileProgram(*root);
+    TabulateProgram(&program);
+    REQUIRE_FALSE(program.table.empty());
+
+    CompileProgram(*RunOptimizer(ParseForTest<std::uint8_t>("x & 1", &arena), &arena), &program);
+    CHECK(program.table.empty());
+    const std::uint8_t value = 3;
+    CHECK(RunProgram(program, &value) == 1);
+}
+
+
+TEST_CASE("lookuptable-cache", "[lookuptable]")
+{
+    auto cache = ProgramCache<std::uint8_t>{4};
+    ErrorHandler errors;
+    const std::string source = "x << 1 | x >> 7";
+
+    SECTION("expected calls add up")
+    {
+        const auto first = cache.Compile(source, true, &errors, 100);
+        REQUIRE(first != nullptr);
+        CHECK(first->table.empty());
+
+        auto program = first;
+        for (int compile = 0; compile < 1000 && program->table.empty(); compile += 1)
+        {
+            program = cache.Compile(source, true, &errors, 100);
+        }
+        CHECK_FALSE(program->table.empty());
+        CHECK(cache.Find(source, true) == program);
+
+        // the table doesn't change the results
+        for (unsigned value = 0; value < 256; value += 1)
+        {
+            const auto variable = static_cast<std::uint8_t>(value);
+            REQUIRE(RunProgram(*program, &variable) == RunProgram(*first, &variable));
+        }
+    }
+
+    SECTION("tabulated on the first compile")
+    {
+        const auto program = cache.Compile(source, true, &errors, 1000000);
+        REQUIRE(program != nullptr);
+        CHECK_FALSE(program->table.empty());
+        CHECK(cache.Compile(source, true, &errors) == program);
+    }
+
+    SECTION("not without expected calls")
+    {
+        for (int compile = 0; compile < 1000; compile += 1)
+        {
+            cache.Compile(source, true, &errors);
+        }
+        CHECK(cache.Find(source, true)->table.empty());
+    }
+}
@@ -0,0 +1,135 @@
+#include "catch.hpp"
+
+#include <cstdint>
+#include <random>
+#include <string>
+
+#include "calc/compiler.h"
+#include "calc/optimizer.h"
+#include "calc/program.h"
+
+#include "parsefortest.h"
+
+
+// the commandline default
+using Value = std::uint32_t;
+
+
+std::string
+Optimized(const std::string& source)
+{
+    AstArena arena;
+    const auto* root = RunOptimizer(ParseForTest<Value>(source, &arena), &arena);
+    return CompileProgram(*root).ToString();
+}
+
+
+TEST_CASE("optimizer-rules", "[optimizer]")
+{
+    SECTION("constants are folded")
+    {
+        CHECK(Optimized("0xff & 0x0f | 0x30") == "PUSH(63)");
+        CHECK(Optimized("0xff & 0x0f & x") == "PUSH_VAR(0) AND_CONST(15)");
+    }
+
+    SECTION("and with zero is zero")
+    {
+        CHECK(Optimized("0xff & 0xff & x & 0") == "PUSH(0)");
+    }
+
+    SECTION("identities are removed")
+    {
+        CHECK(Optimized("x | 0") == "PUSH_VAR(0)");
+        CHECK(Optimized("0 | x | 0") == "PUSH_VAR(0)");
+    }
+
+    SECTION("idempotence")
+    {
+        CHECK(Optimized("x & x & y") == "PUSH_VAR(0) AND_VAR(1)");
+        CHECK(Optimized("x | y | x | y") == "PUSH_VAR(0) OR_VAR(1)");
+    }
+
+    SECTION("absorption")
+    {
+        // & binds tighter so the first is x | (y & x)
+        CHECK(Optimized("x | y & x") == "PUSH_VAR(0)");
+        CHECK(Optimized("x & y | x") == "PUSH_VAR(0)");
+        CHECK(Optimized("y & x | x") == "PUSH_VAR(0)");
+    }
+
+    SECTION("xor cancels equal operands")
+    {
+        CHECK(Optimized("x ^ y ^ x") == "PUSH_VAR(0)");
+        CHECK(Optimized("x ^ y ^ x ^ x") == "PUSH_VAR(0) XOR_VAR(1)");
+        CHECK(Optimized("(x & y) ^ 3 ^ (x & y) ^ 5") == "PUSH(6)");
+    }
+
+    SECTION("not and shifts")
+    {
+        CHECK(Optimized("~~x") == "PUSH_VAR(0)");
+        CHECK(Optimized("~0xffff0000") == "PUSH(65535)");
+        CHECK(Optimized("x << 0 | 0 >> y") == "PUSH_VAR(0)");
+        CHECK(Optimized("1 << 4 << 32") == "PUSH(0)");
+        CHECK(Optimized("x >> (2 | 1)") == "PUSH_VAR(0) SHR_CONST(3)");
+    }
+
+    SECTION("removed variables doesn't leave gaps")
+    {
+        AstArena arena;
+        const auto* root = RunOptimizer(ParseForTest<Value>("a & 0 | b", &arena), &arena);
+        const auto program = CompileProgram(*root);
+        CHECK(program.variables == std::vector<std::string>{"b"});
+    }
+
+    SECTION("chains are flattened")
+    {
+        AstArena arena;
+        const auto* root = RunOptimizer(ParseForTest<Value>("a | b | c | d", &arena), &arena);
+        const auto* chain = dynamic_cast<const OrNode<Value>*>(root);
+        REQUIRE(chain != nullptr);
+        CHECK(chain->operands.size == 4);
+    }
+}
+
+
+TEST_CASE("optimizer-same-result", "[optimizer]")
+{
+    // build random expressions over few variables and constants so the
+    // optimizer has something to work with
+    auto engine = std::mt19937{1234};
+    const auto pick = [&engine](int count) {
+        return std::uniform_int_distribution<int>{0, count - 1}(engine);
+    };
+    const auto pick_value = [&engine]() {
+        return std::uniform_int_distribution<Value>{0, 0xffff}(engine);
+    };
+    const std::vector<std::string> atoms{"a", "b", "c", "0", "0xf", "0xff00", "0x7fffffff", "~a", "3"};
+    const std::vector<std::string> operators{" & ", " | ", " ^ ", " << ", " >> "};
+    AstArena arena;
+
+    for (int test = 0; test < 200; test += 1)
+    {
+        std::string source = atoms[static_cast<std::size_t>(pick(9))];
+        const auto length = pick(8);
+        for (int i = 0; i < length; i += 1)
+        {
+            source += operators[static_cast<std::size_t>(pick(5))];
+            source += atoms[static_cast<std::size_t>(pick(9))];
+            if (pick(4) == 0)
+            {
+                source = "~(" + source + ")";
+            }
+        }
+
+        arena.Reset();
+        auto* root = ParseForTest<Value>(source, &arena);
+        const auto* optimized = RunOptimizer(root, &arena);
+
+        INFO(source);
+        for (int i = 0; i < 10; i += 1)
+        {
+            const auto values = std::vector<Value>{pick_value(), pick_value(), pick_value()};
+            CHECK(optimized->Calculate(values) == root->Calculate(values));
+        }
+    }
+}
@@ -0,0 +1,128 @@
+#include "catch.hpp"
+
+#include <cstdint>
+#include <string>
+
+#include "calc/errorhandler.h"
+#include "calc/lexer.h"
+#include "calc/parser.h"
+
+
+// the commandline default
+using Value = std::uint32_t;
+
+
+Value
+Evaluate(const std::string& source)
+{
+    ErrorHandler errors;
+    AstArena arena;
+    const auto tokens = RunLexer<Value>(source, &errors);
+    REQUIRE_FALSE(errors.HasErr());
+    const auto* root = RunParser(tokens, &errors, &arena);
+    REQUIRE_FALSE(errors.HasErr());
+    return root->Calculate({});
+}
+
+
+std::vector<std::string>
+ParseErrors(const std::string& source)
+{
+    ErrorHandler errors;
+    AstArena arena;
+    const auto tokens = RunLexer<Value>(source, &errors);
+    if (!errors.HasErr())
+    {
+        RunParser(tokens, &errors, &arena);
+    }
+    return errors.Messages();
+}
+
+
+TEST_CASE("parser-precedence", "[parser]")
+{
+    SECTION("the c order")
+    {
+        CHECK(Evaluate("1 | 2 | 4 & 6") == 7);
+        CHECK(Evaluate("1 | 6 ^ 4") == 3);
+        CHECK(Evaluate("6 ^ 4 & 12") == 2);
+        CHECK(Evaluate("3 & 1 << 1") == 2);
+        CHECK(Evaluate("~1 & 3") == 2);
+    }
+
+    SECTION("left associative")
+    {
+        CHECK(Evaluate("256 >> 4 >> 2") == 4);
+        CHECK(Evaluate("1 << 2 >> 1") == 2);
+    }
+
+    SECTION("parentheses")
+    {
+        CHECK(Evaluate("(1 | 2 | 4) & 6") == 6);
+        CHECK(Evaluate("~(1 | 2)") == 0xfffffffc);
+        CHECK(Evaluate("((((5))))") == 5);
+        CHECK(Evaluate("~~(3 & (1 ^ (2 | 4)))") == 3);
+    }
+
+    SECTION("shifts saturate")
+    {
+        CHECK(Evaluate("1 << 31") == 0x80000000);
+        CHECK(Evaluate("1 << 32") == 0);
+        CHECK(Evaluate("0xffffffff >> 0xffffffff") == 0);
+    }
+}
+
+
+TEST_CASE("parser-errors", "[parser]")
+{
+    CHECK(ParseErrors("1 &") == std::vector<std::string>{"Expected number or variable but got EOF"});
+    CHECK(ParseErrors("1 2") == std::vector<std::string>{"Expected OP but got NUMBER(2)"});
+    CHECK(ParseErrors("(1 | 2") == std::vector<std::string>{"Missing )"});
+    CHECK(ParseErrors("1 | 2)") == std::vector<std::string>{"Unmatched )"});
+    CHECK(ParseErrors("()") == std::vector<std::string>{"Expected number or variable but got RPAREN"});
+    CHECK(ParseErrors("1 ~ 2") == std::vector<std::string>{"Expected OP but got NOT"});
+    CHECK(ParseErrors("1 < 2") == std::vector<std::string>{"Invalid character: <"});
+}
+
+
+// the column of the first error, 0 if there is none
+std::size_t
+ErrorColumn(const std::string& source)
+{
+    ErrorHandler errors;
+    AstArena arena;
+    const auto tokens = RunLexer<Value>(source, &errors);
+    if (!errors.HasErr())
+    {
+        RunParser(tokens, &errors, &arena);
+    }
+    return errors.HasErr() ? errors.errors[0].Offset(source) + 1 : 0;
+}
+
+
+TEST_CASE("parser-error-columns", "[parser]")
+{
+    CHECK(ErrorColumn("1 | 2") == 0);
+    CHECK(ErrorColumn("1 & $") == 5);
+    CHECK(ErrorColumn("12 0xff") == 4);
+    CHECK(ErrorColumn("0x") == 3);
+    CHECK(ErrorColumn("1 | 0x100000000") == 5);
+    CHECK(ErrorColumn("1 &  ") == 4);
+    CHECK(ErrorColumn("(1 | 2))") == 8);
+}
+
+
+TEST_CASE("parser-deep-nesting", "[parser]")
+{
+    // deep enough to overflow the call stack of a recursive parser
+    constexpr std::size_t DEPTH = 200000;
+    const auto source = std::string(DEPTH, '~') + std::string(DEPTH, '(') + "x" + std::string(DEPTH, ')');
+
+    ErrorHandler errors;
+    AstArena arena;
+    const auto tokens = RunLexer<Value>(source, &errors);
+    REQUIRE_FALSE(errors.HasErr());
+    const auto* root = RunParser(tokens, &errors, &arena);
+    CHECK_FALSE(errors.HasErr());
+    CHECK(dynamic_cast<const NotNode<Value>*>(root) != nullptr);
+}
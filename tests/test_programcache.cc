@@ -0,0 +1,117 @@
+#include "catch.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "calc/errorhandler.h"
+#include "calc/programcache.h"
+#include "calc/vm.h"
+
+
+using Value = std::uint32_t;
+
+
+TEST_CASE("programcache-lookup", "[programcache]")
+{
+    auto cache = ProgramCache<Value>{4};
+    ErrorHandler errors;
+
+    const auto first = cache.Compile("1 | 2 & x", true, &errors);
+    REQUIRE(first != nullptr);
+    CHECK(cache.Misses() == 1);
+    CHECK(cache.Hits() == 0);
+
+    SECTION("whitespace between tokens doesn't matter")
+    {
+        CHECK(cache.Compile("  1 |\t2   &  x \n", true, &errors) == first);
+        CHECK(cache.Hits() == 1);
+    }
+
+    SECTION("whitespace that separates tokens does")
+    {
+        cache.Compile("a b", true, &errors);
+        CHECK(errors.HasErr());
+        errors.Clear();
+        const auto ab = cache.Compile("ab", true, &errors);
+        REQUIRE(ab != nullptr);
+        CHECK(ab->variables == std::vector<std::string>{"ab"});
+    }
+
+    SECTION("errors aren't cached")
+    {
+        CHECK(cache.Compile("1 &", true, &errors) == nullptr);
+        CHECK(errors.HasErr());
+        CHECK(cache.Size() == 1);
+    }
+
+    SECTION("optimized and unoptimized programs are kept apart")
+    {
+        const auto unoptimized = cache.Compile("1 | 2 & x", false, &errors);
+        REQUIRE(unoptimized != nullptr);
+        CHECK(unoptimized != first);
+        CHECK(unoptimized->code.size() > first->code.size());
+        CHECK(cache.Misses() == 2);
+        CHECK(cache.Compile("1 | 2 & x", true, &errors) == first);
+        CHECK(cache.Compile("1 | 2 & x", false, &errors) == unoptimized);
+        CHECK(cache.Find("1 | 2 & x", false) == unoptimized);
+    }
+
+    SECTION("the least recently used is evicted")
+    {
+        cache.Compile("2", true, &errors);
+        cache.Compile("3", true, &errors);
+        cache.Compile("4", true, &errors);
+        CHECK(cache.Find("1 | 2 & x", true) == first);
+        cache.Compile("5", true, &errors);
+
+        CHECK(cache.Size() == 4);
+        CHECK(cache.Find("2", true) == nullptr);
+        CHECK(cache.Find("1 | 2 & x", true) == first);
+        CHECK(cache.Find("5", true) != nullptr);
+    }
+}
+
+
+TEST_CASE("programcache-no-capacity", "[programcache]")
+{
+    auto cache = ProgramCache<Value>{0};
+    ErrorHandler errors;
+    const auto program = cache.Compile("0xf0 | 0x0f", true, &errors);
+    REQUIRE(program != nullptr);
+    CHECK(RunProgram(*program, {}) == 0xff);
+    CHECK(cache.Size() == 0);
+    CHECK(cache.Find("0xf0 | 0x0f", true) == nullptr);
+}
+
+
+TEST_CASE("programcache-threads", "[programcache]")
+{
+    // catch can't check from several threads, so the results are counted
+    auto cache = ProgramCache<Value>{8};
+    std::atomic<int> wrong{0};
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < 4; thread += 1)
+    {
+        threads.emplace_back([&cache, &wrong]() {
+            ErrorHandler errors;
+            for (Value i = 0; i < 1000; i += 1)
+            {
+                const auto program = cache.Compile(std::to_string(i % 16) + " | 0x100", true, &errors);
+                if (program == nullptr || RunProgram(*program, {}) != ((i % 16) | 0x100))
+                {
+                    wrong += 1;
+                }
+            }
+        });
+    }
+    for (auto& thread: threads)
+    {
+        thread.join();
+    }
+    CHECK(wrong == 0);
+    CHECK(cache.Hits() + cache.Misses() == 4000);
+    CHECK(cache.Size() == 8);
+}
@@ -0,0 +1,195 @@
+#include "catch.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "calc/calc.h"
+#include "calc/records.h"
+
+
+struct ErrorCountOutput : public Output
+{
+    int infos = 0;
+    int errors = 0;
+
+    void
+    PrintInfo(std::string_view) override
+    {
+        infos += 1;
+    }
+
+    void
+    PrintError(std::string_view) override
+    {
+        errors += 1;
+    }
+};
+
+
+std::string
+ReadBinaryFile(const std::string& path)
+{
+    std::ifstream file{path, std::ios::binary};
+    std::ostringstream data;
+    data << file.rdbuf();
+    return data.str();
+}
+
+
+TEST_CASE("records-format", "[records]")
+{
+    RecordBuffer buffer;
+
+    SECTION("little endian")
+    {
+        const auto record = FormatRecord(std::uint32_t{0x11223344}, false, &buffer);
+        CHECK(record == std::string_view{"\x44\x33\x22\x11", 4});
+        CHECK(LoadLittleEndian<std::uint32_t>(record.data()) == 0x11223344);
+    }
+
+    SECTION("status")
+    {
+        const auto record = FormatRecord(std::uint8_t{0xab}, true, &buffer);
+        CHECK(record == std::string_view{"\x00\xab", 2});
+    }
+
+    SECTION("wide")
+    {
+        const auto value = (Bits<128>{0x0102} << 64) | Bits<128>{0x0304};
+        const auto record = FormatRecord(value, false, &buffer);
+        REQUIRE(record.size() == 16);
+        CHECK(record[0] == 0x04);
+        CHECK(record[8] == 0x02);
+        CHECK(LoadLittleEndian<Bits<128>>(record.data()) == value);
+    }
+
+    SECTION("error")
+    {
+        const auto record = FormatErrorRecord<std::uint16_t>(ErrorCode::MISSING_PAREN, &buffer);
+        CHECK(record == std::string_view{"\x0a\x00\x00", 3});
+        CHECK(std::string{RecordStatusName(static_cast<std::uint8_t>(record[0]))} == "missing paren");
+    }
+}
+
+
+TEST_CASE("records-reader", "[records]")
+{
+    const auto data = std::string_view{"\x00\x01\x00\x0b\x00\x00\x00\xff", 8};
+    auto reader = RecordReader{data, 16, true};
+    Record record;
+
+    REQUIRE(reader.Next(&record));
+    CHECK(record.status == RECORD_OK);
+    CHECK(LoadLittleEndian<std::uint16_t>(record.value.data()) == 1);
+
+    REQUIRE(reader.Next(&record));
+    CHECK(record.status == RecordStatus(ErrorCode::EMPTY_STATEMENT));
+
+    CHECK_FALSE(reader.Next(&record));
+    CHECK(reader.RemainingBytes() == 2);
+}
+
+
+TEST_CASE("records-stream", "[records]")
+{
+    const std::string path = "records-test.txt";
+    const std::string binary_path = "records-test.bin";
+    const int line_count = 5000;
+    {
+        std::ofstream file{path};
+        for (int line = 0; line < line_count; line += 1)
+        {
+            switch (line % 100)
+            {
+            case 7: file << "\n"; break;
+            case 8: file << "(1 | 2\n"; break;
+            default: file << line << " & 0xff0\n"; break;
+            }
+        }
+    }
+
+    const auto expect_records = [&](const std::string& data, bool has_status) {
+        auto reader = RecordReader{data, 32, has_status};
+        Record record;
+        for (int line = 0; line < line_count; line += 1)
+        {
+            const auto has_value = line % 100 != 7 && line % 100 != 8;
+            if (!has_status && !has_value)
+            {
+                continue;
+            }
+            REQUIRE(reader.Next(&record));
+            if (has_value)
+            {
+                REQUIRE(record.status == RECORD_OK);
+                REQUIRE(LoadLittleEndian<std::uint32_t>(record.value.data()) == static_cast<std::uint32_t>(line & 0xff0));
+            }
+            else
+            {
+                const auto code = line % 100 == 7 ? ErrorCode::EMPTY_STATEMENT : ErrorCode::MISSING_PAREN;
+                REQUIRE(record.status == RecordStatus(code));
+                REQUIRE(LoadLittleEndian<std::uint32_t>(record.value.data()) == 0);
+            }
+        }
+        CHECK_FALSE(reader.Next(&record));
+        CHECK(reader.RemainingBytes() == 0);
+    };
+
+    SECTION("values")
+    {
+        ErrorCountOutput output;
+        RunCalcApp("calcapp", {"--stream", path, "--binary", binary_path}, &output);
+        CHECK(output.infos == 0);
+        CHECK(output.errors == 2 * (line_count / 100));
+        expect_records(ReadBinaryFile(binary_path), false);
+    }
+
+    SECTION("status")
+    {
+        ErrorCountOutput output;
+        RunCalcApp("calcapp", {"--stream", path, "--binary", binary_path, "--status"}, &output);
+        const auto sequential = ReadBinaryFile(binary_path);
+        expect_records(sequential, true);
+
+        RunCalcApp("calcapp", {"--stream", path, "--binary", binary_path, "--status", "--jobs", "3"}, &output);
+        CHECK(ReadBinaryFile(binary_path) == sequential);
+    }
+
+    SECTION("arguments")
+    {
+        ErrorCountOutput output;
+        const auto result = RunCalcApp("calcapp", {"--binary", binary_path, "--status", "--width", "8", "3", "x"}, &output);
+        CHECK(result != 0);
+        CHECK(ReadBinaryFile(binary_path) == std::string{"\x00\x03\x0c\x00", 4});
+    }
+
+    SECTION("not with truth table")
+    {
+        // the options are checked before the file is opened
+        {
+            std::ofstream file{binary_path};
+            file << "keep";
+        }
+        ErrorCountOutput output;
+        const auto result = RunCalcApp("calcapp", {"--truth-table", "--binary", binary_path, "a & b"}, &output);
+        CHECK(result != 0);
+        CHECK(output.errors == 1);
+        CHECK(ReadBinaryFile(binary_path) == "keep");
+    }
+
+    SECTION("stdout")
+    {
+        // no records as the line fails, the stats are printed as errors
+        ErrorCountOutput output;
+        const auto result = RunCalcApp("calcapp", {"--binary", "-", "--stats", "x"}, &output);
+        CHECK(result != 0);
+        CHECK(output.infos == 0);
+        CHECK(output.errors > 0);
+    }
+
+    std::remove(path.c_str());
+    std::remove(binary_path.c_str());
+}
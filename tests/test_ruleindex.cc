@@ -0,0 +1,99 @@
+#include "catch.hpp"
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "calc/compiledexpr.h"
+#include "calc/errorhandler.h"
+#include "calc/ruleindex.h"
+
+
+TEST_CASE("ruleindex-errors", "[ruleindex]")
+{
+    RuleIndex index;
+    ErrorHandler errors;
+
+    CHECK(index.Add("x & 0xff", &errors) == 0);
+
+    SECTION("one variable")
+    {
+        CHECK(index.Add("x & y | 1", &errors) == -1);
+        CHECK(errors.Messages() == std::vector<std::string>{"Only one variable is allowed, found y"});
+    }
+
+    SECTION("syntax")
+    {
+        CHECK(index.Add("x &", &errors) == -1);
+        CHECK(errors.HasErr());
+    }
+
+    CHECK(index.RuleCount() == 1);
+    errors.Clear();
+    CHECK(index.Add("flags & 0x100", &errors) == 1);
+}
+
+
+TEST_CASE("ruleindex-match", "[ruleindex]")
+{
+    std::mt19937_64 random{7};
+    const auto mask = [&random]() {
+        // mostly a few bits like a flag test, sometimes a wide mask
+        auto bits = random() & random() & random();
+        if (random() % 4 == 0)
+        {
+            bits = random();
+        }
+        return bits;
+    };
+
+    std::vector<std::string> rules;
+    for (int rule = 0; rule < 1000; rule += 1)
+    {
+        switch (rule % 8)
+        {
+        case 0:
+        case 1:
+        case 2: rules.emplace_back(fmt::format("x & {}", mask())); break;
+        case 3: rules.emplace_back(fmt::format("x & {} | {}", mask(), rule % 16 == 3 ? mask() : 0)); break;
+        case 4: rules.emplace_back(fmt::format("~x & {}", mask())); break;
+        case 5: rules.emplace_back(fmt::format("(x ^ {}) & {}", mask(), mask())); break;
+        case 6: rules.emplace_back(fmt::format("x << {} & {}", rule % 5, mask())); break;
+        default: rules.emplace_back(std::to_string(rule % 3)); break;
+        }
+    }
+
+    RuleIndex index;
+    std::vector<CompiledExpr> expressions;
+    ErrorHandler errors;
+    for (const auto& rule: rules)
+    {
+        REQUIRE(index.Add(rule, &errors) == static_cast<int>(expressions.size()));
+        expressions.emplace_back(CompileExpression(rule, &errors));
+    }
+
+    std::vector<std::uint64_t> values = {0, ~std::uint64_t{0}, 1, 0x8000000000000000};
+    for (int value = 0; value < 200; value += 1)
+    {
+        values.emplace_back(value % 2 == 0 ? mask() : random());
+    }
+
+    RuleMatches matches;
+    for (const auto value: values)
+    {
+        std::vector<int> expected;
+        for (std::size_t rule = 0; rule < expressions.size(); rule += 1)
+        {
+            if (expressions[rule].Eval({&value, 1}) != 0)
+            {
+                expected.emplace_back(static_cast<int>(rule));
+            }
+        }
+        index.Match(value, &matches);
+        INFO(value);
+        REQUIRE(matches.rules == expected);
+    }
+}
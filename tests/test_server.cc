@@ -0,0 +1,216 @@
+#include "catch.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "calc/calc.h"
+#include "calc/server.h"
+
+#if defined(__linux__)
+#include <csignal>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+
+// the replies of a client to lines made by the function
+std::vector<std::string>
+SendLines(const std::string& path, std::size_t count, const std::function<std::string(std::size_t)>& make_line)
+{
+    std::vector<std::string> replies;
+    std::string line;
+    std::size_t sent = 0;
+    std::string error;
+    const auto next_line = [&](std::string_view* next) {
+        if (sent == count)
+        {
+            return false;
+        }
+        line = make_line(sent);
+        sent += 1;
+        *next = line;
+        return true;
+    };
+    const auto on_reply = [&](std::string_view reply) { replies.emplace_back(reply); };
+    if (!SendRequests(path, next_line, on_reply, &error))
+    {
+        replies.emplace_back(error);
+    }
+    return replies;
+}
+
+
+TEST_CASE("server-pipelined", "[server]")
+{
+    if (!Server::IsSupported())
+    {
+        return;
+    }
+
+    const std::string path = "server-test.sock";
+    const std::size_t reply_size = GENERATE(0U, 10000U);
+    auto server = Server{[reply_size](std::size_t line_number, std::string_view line, std::string* reply) {
+        *reply += fmt::format("{} {}{}\n", line_number, line, std::string(reply_size, '.'));
+    }};
+    std::string error;
+    REQUIRE(server.Listen(path, &error));
+
+    std::thread thread{[&server]() {
+        std::string run_error;
+        server.Run(&run_error);
+    }};
+
+    // several clients at the same time, each with its own line numbers
+    const std::size_t count = reply_size == 0 ? 20000 : 1000;
+    std::vector<std::vector<std::string>> replies(4);
+    std::vector<std::thread> clients;
+    for (std::size_t client = 0; client < replies.size(); client += 1)
+    {
+        clients.emplace_back([&, client]() {
+            replies[client] = SendLines(path, count, [client](std::size_t line) {
+                return fmt::format("{}-{}", client, line);
+            });
+        });
+    }
+    for (auto& client: clients)
+    {
+        client.join();
+    }
+
+    for (std::size_t client = 0; client < replies.size(); client += 1)
+    {
+        REQUIRE(replies[client].size() == count);
+        for (std::size_t line = 0; line < count; line += 1)
+        {
+            const auto expected = fmt::format("{} {}-{}{}", line + 1, client, line, std::string(reply_size, '.'));
+            REQUIRE(replies[client][line] == expected);
+        }
+    }
+
+    SECTION("a second server can't use the socket")
+    {
+        auto other = Server{[](int, std::string_view, std::string*) {}};
+        CHECK_FALSE(other.Listen(path, &error));
+        CHECK(error == "A server is already listening on server-test.sock");
+    }
+
+    server.Stop();
+    thread.join();
+}
+
+
+#if defined(__linux__)
+
+TEST_CASE("server-calc", "[server]")
+{
+    const std::string path = "server-calc-test.sock";
+    const pid_t child = fork();
+    REQUIRE(child >= 0);
+    if (child == 0)
+    {
+        struct NullOutput : public Output
+        {
+            void
+            PrintInfo(std::string_view) override
+            {
+            }
+
+            void
+            PrintError(std::string_view) override
+            {
+            }
+        };
+        NullOutput output;
+        _exit(RunCalcApp("calcapp", {"--serve", path, "--width", "8"}, &output) == 0 ? 0 : 1);
+    }
+
+    struct LineOutput : public Output
+    {
+        std::vector<std::string> lines;
+
+        void
+        PrintInfo(std::string_view str) override
+        {
+            lines.emplace_back(str);
+        }
+
+        void
+        PrintError(std::string_view str) override
+        {
+            lines.emplace_back(fmt::format("ERR {}", str));
+        }
+    };
+
+    // the server may not be listening yet
+    LineOutput output;
+    int result = 0;
+    for (int attempt = 0; attempt < 500; attempt += 1)
+    {
+        output.lines.clear();
+        result = RunCalcApp("calcapp", {"--client", path, "0x42 | 7", "", "4 $ 2", "~0"}, &output);
+        if (result != -6)
+        {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    }
+
+    kill(child, SIGTERM);
+    int status = 0;
+    waitpid(child, &status, 0);
+
+    CHECK(result == -7);
+    CHECK(output.lines
+          == std::vector<std::string>{
+                  "dec: 71",
+                  "hex: 0x47",
+                  "bin: 100 0111",
+                  "ERR Error on line 3: 4 $ 2",
+                  "ERR  - Invalid character: $",
+                  "dec: 255",
+                  "hex: 0xff",
+                  "bin: 1111 1111"});
+    CHECK(WIFEXITED(status));
+    CHECK(WEXITSTATUS(status) == 0);
+    CHECK(access(path.c_str(), F_OK) != 0);
+}
+
+#endif
+
+
+TEST_CASE("server-options", "[server]")
+{
+    struct ErrorOutput : public Output
+    {
+        std::string error;
+
+        void
+        PrintInfo(std::string_view) override
+        {
+        }
+
+        void
+        PrintError(std::string_view str) override
+        {
+            error = str;
+        }
+    };
+    ErrorOutput output;
+
+    CHECK(RunCalcApp("calcapp", {"--serve"}, &output) == -1);
+    CHECK(output.error == "--serve needs a socket path");
+    CHECK(RunCalcApp("calcapp", {"--serve", "x.sock", "1"}, &output) == -1);
+    CHECK(output.error == "--serve reads the expressions from its clients");
+    CHECK(RunCalcApp("calcapp", {"--serve", "x.sock", "--stream"}, &output) == -1);
+    CHECK(output.error == "--serve can't be used with --stream");
+    CHECK(RunCalcApp("calcapp", {"--client", "x.sock", "--truth-table", "x"}, &output) == -1);
+    CHECK(output.error == "--client can't be used with --truth-table");
+    CHECK(RunCalcApp("calcapp", {"--client", "missing-test.sock", "1"}, &output) == -6);
+    CHECK(output.error.find("Unable to connect to missing-test.sock") == 0);
+}
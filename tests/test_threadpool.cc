@@ -0,0 +1,45 @@
+#include "catch.hpp"
+
+#include <atomic>
+#include <vector>
+
+#include "calc/threadpool.h"
+
+
+TEST_CASE("threadpool-run", "[threadpool]")
+{
+    auto pool = ThreadPool{4};
+    CHECK(pool.Size() == 4);
+
+    SECTION("every index once")
+    {
+        // run a few batches so the queues are reused
+        for (std::size_t count: {0u, 1u, 3u, 1000u})
+        {
+            std::vector<std::atomic<int>> calls(count);
+            std::atomic<bool> bad_worker = false;
+            pool.Run(count, [&](std::size_t index, std::size_t worker) {
+                calls[index] += 1;
+                if (worker >= pool.Size())
+                {
+                    bad_worker = true;
+                }
+            });
+
+            CHECK_FALSE(bad_worker);
+            for (const auto& c: calls)
+            {
+                CHECK(c == 1);
+            }
+        }
+    }
+}
+
+
+TEST_CASE("threadpool-single", "[threadpool]")
+{
+    auto pool = ThreadPool{1};
+    std::vector<std::size_t> order;
+    pool.Run(5, [&](std::size_t index, std::size_t) { order.emplace_back(index); });
+    CHECK(order == std::vector<std::size_t>{0, 1, 2, 3, 4});
+}
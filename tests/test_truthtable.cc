@@ -0,0 +1,65 @@
+#include "catch.hpp"
+
+#include <cstdint>
+#include <string>
+
+#include "calc/arena.h"
+#include "calc/compiler.h"
+#include "calc/truthtable.h"
+
+#include "parsefortest.h"
+
+
+TEST_CASE("truthtable-small", "[truthtable]")
+{
+    AstArena arena;
+
+    SECTION("rows past the last are 0")
+    {
+        const auto table = TruthTable{CompileProgram(*ParseForTest<std::uint64_t>("a | b", &arena))};
+        CHECK(table.RowCount() == 4);
+        CHECK(table.EvalRows(0) == 0b1110);
+    }
+
+    SECTION("constants only use the lowest bit")
+    {
+        const auto table = TruthTable{CompileProgram(*ParseForTest<std::uint64_t>("a & 2 | b & 3", &arena))};
+        CHECK(table.EvalRows(0) == 0b1010);
+    }
+
+    SECTION("not, xor and shifts work on single bits")
+    {
+        const auto eval = [&arena](const std::string& source) {
+            return TruthTable{CompileProgram(*ParseForTest<std::uint64_t>(source, &arena))}.EvalRows(0);
+        };
+        CHECK(eval("~a ^ b") == 0b1001);
+        CHECK(eval("a << b") == 0b0100);
+        CHECK(eval("(a | b) >> a") == 0b0010);
+        CHECK(eval("a >> 1 | b << 0") == 0b1010);
+    }
+}
+
+
+TEST_CASE("truthtable-matches-calculate", "[truthtable]")
+{
+    // more than 6 variables so some of them are the same for a whole word
+    AstArena arena;
+    const auto* root = ParseForTest<std::uint64_t>("a & b | c & d | e & f | g & h | a & h", &arena);
+    const auto table = TruthTable{CompileProgram(*root)};
+    REQUIRE(table.VariableCount() == 8);
+
+    for (std::uint64_t first_row = 0; first_row < table.RowCount(); first_row += 64)
+    {
+        const auto results = table.EvalRows(first_row);
+        for (std::uint64_t row = first_row; row < first_row + 64; row += 1)
+        {
+            std::vector<std::uint64_t> values;
+            for (std::size_t variable = 0; variable < 8; variable += 1)
+            {
+                values.emplace_back((row >> (7 - variable)) & 1);
+            }
+            INFO(row);
+            CHECK(((results >> (row - first_row)) & 1) == root->Calculate(values));
+        }
+    }
+}
@@ -0,0 +1,112 @@
+#include "catch.hpp"
+
+#include <cstdint>
+#include <string>
+
+#include "calc/compiler.h"
+#include "calc/program.h"
+#include "calc/value.h"
+#include "calc/vm.h"
+
+#include "parsefortest.h"
+
+
+// the commandline default
+using Value = std::uint32_t;
+
+
+TEST_CASE("vm-matches-calculate", "[vm]")
+{
+    const auto source = GENERATE(
+            std::string{"42"},
+            std::string{"0x42"},
+            std::string{"0b1010"},
+            std::string{"0b0101 & 0b1100"},
+            std::string{"0b0101 | 0b1100"},
+            std::string{"0xff & 0b100"},
+            std::string{"1 | 2 | 4 & 6"},
+            std::string{"0xf0f0 & 0xff00 | 0x000f & 0x0ff0 | 0x1"},
+            std::string{"~0x0f ^ 0xff"},
+            std::string{"(1 << 31 >> 3) ^ ~(0x12 << 40)"},
+            std::string{"0xf0 >> (1 | 2) << 1 ^ (3 & ~5)"});
+
+    AstArena arena;
+    const auto* root = ParseForTest<Value>(source, &arena);
+    const auto program = CompileProgram(*root);
+
+    INFO(source);
+    INFO(program.ToString());
+    CHECK(RunProgram(program, {}) == root->Calculate({}));
+}
+
+
+TEST_CASE("vm-compile", "[vm]")
+{
+    AstArena arena;
+
+    SECTION("constants are folded into the operation")
+    {
+        const auto program = CompileProgram(*ParseForTest<Value>("1 & 2 | 3", &arena));
+        CHECK(program.ToString() == "PUSH(1) AND_CONST(2) OR_CONST(3)");
+        CHECK(program.stack_size == 1);
+    }
+
+    SECTION("non constant right hand side uses the stack")
+    {
+        const auto* tree = arena.Make<AndNode<Value>>(arena.MakeNodes(
+                {arena.Make<NumberNode<Value>>(6u),
+                 arena.Make<OrNode<Value>>(arena.MakeNodes(
+                         {arena.Make<NumberNode<Value>>(1u),
+                          arena.Make<NumberNode<Value>>(2u)}))}));
+        const auto program = CompileProgram(*tree);
+        CHECK(program.ToString() == "PUSH(6) PUSH(1) OR_CONST(2) AND");
+        CHECK(program.stack_size == 2);
+        CHECK(RunProgram(program, {}) == tree->Calculate({}));
+    }
+
+    SECTION("deep trees spill to a heap stack")
+    {
+        Node<Value>* tree = arena.Make<NumberNode<Value>>(1u);
+        for (int i = 0; i < 100; i += 1)
+        {
+            tree = arena.Make<OrNode<Value>>(
+                    arena.MakeNodes({arena.Make<NumberNode<Value>>(static_cast<Value>(i)), tree}));
+        }
+        const auto program = CompileProgram(*tree);
+        CHECK(program.stack_size == 100);
+        CHECK(RunProgram(program, {}) == tree->Calculate({}));
+    }
+}
+
+
+TEST_CASE("vm-variables", "[vm]")
+{
+    AstArena arena;
+    const auto* root = ParseForTest<Value>("(x & 0xff00 | y) & x | z", &arena);
+    const auto program = CompileProgram(*root);
+
+    CHECK(program.variables == std::vector<std::string>{"x", "y", "z"});
+    CHECK(program.ToString() == "PUSH_VAR(0) AND_CONST(65280) OR_VAR(1) AND_VAR(0) OR_VAR(2)");
+
+    const auto values = GENERATE(
+            std::vector<Value>{0, 0, 0},
+            std::vector<Value>{0x1234, 0x7, 0x80},
+            std::vector<Value>{0xffff, 0xf0f0, 0x1});
+    CHECK(RunProgram(program, values) == root->Calculate(values));
+}
+
+
+TEMPLATE_TEST_CASE("vm-widths", "[vm]", std::uint8_t, std::uint64_t, Bits<256>)
+{
+    using V = TestType;
+
+    AstArena arena;
+    const auto* root = ParseForTest<V>("0xf0 | x & 0x3c | y", &arena);
+    const auto program = CompileProgram(*root);
+
+    for (std::uint64_t x: {0x0u, 0x3u, 0xffu})
+    {
+        const auto values = std::vector<V>{V(x), V(0x100u & x)};
+        CHECK(RunProgram(program, values) == root->Calculate(values));
+    }
+}